@@ -29,7 +29,43 @@
 #include <cstring>
 #include <cmath>
 #include <map>
+#include <set>
 #include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cerrno>
+#include <csignal>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <utility>
+
+#include <zlib.h>
+
+#if defined( _WIN32 )
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <shlwapi.h>
+#include <io.h>
+#include <direct.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#else
+#include <unistd.h>
+#include <fcntl.h>
+#include <dlfcn.h>
+#include <dirent.h>
+#include <fnmatch.h>
+#include <sys/stat.h>
+#if defined( __linux__ )
+#include <sys/syscall.h>
+#endif
+#if defined( __APPLE__ )
+#include <mach-o/dyld.h>
+#endif
+#endif
 
 #include <TDocStd_Document.hxx>
 #include <TopoDS.hxx>
@@ -37,15 +73,10 @@
 #include <Quantity_Color.hxx>
 #include <XCAFApp_Application.hxx>
 #include <Handle_XCAFApp_Application.hxx>
+#include <TCollection_ExtendedString.hxx>
+#include <PCDM_StoreStatus.hxx>
+#include <PCDM_ReaderStatus.hxx>
 
-#include <AIS_Shape.hxx>
-
-#include <IGESControl_Reader.hxx>
-#include <IGESCAFControl_Reader.hxx>
-#include <Interface_Static.hxx>
-
-#include <STEPControl_Reader.hxx>
-#include <STEPCAFControl_Reader.hxx>
 
 #include <XCAFDoc_DocumentTool.hxx>
 #include <XCAFDoc_ColorTool.hxx>
@@ -55,13 +86,20 @@
 #include <TDocStd_Document.hxx>
 
 #include <BRep_Tool.hxx>
+#include <BRepTools.hxx>
+#include <BRepAdaptor_Surface.hxx>
+#include <GeomAbs_SurfaceType.hxx>
 #include <BRepMesh_IncrementalMesh.hxx>
 
 #include <TopoDS.hxx>
 #include <TopoDS_Shape.hxx>
 #include <TopoDS_Face.hxx>
+#include <TopoDS_TShape.hxx>
+#include <TopoDS_Edge.hxx>
 #include <TopoDS_Compound.hxx>
 #include <TopExp_Explorer.hxx>
+#include <TopTools_MapOfShape.hxx>
+#include <TColStd_Array1OfInteger.hxx>
 
 #include <Quantity_Color.hxx>
 #include <Poly_Triangulation.hxx>
@@ -70,8 +108,25 @@
 
 #include <TDF_LabelSequence.hxx>
 #include <TDF_ChildIterator.hxx>
+#include <TDataStd_Name.hxx>
+#include <TCollection_AsciiString.hxx>
 
 #include "plugins/3dapi/ifsg_all.h"
+#include "oce_reader.h"
+#include "occlusion.h"
+
+// reader module names and install location; normally set by the build
+#ifndef OCE_VIS_IGES_MODULE
+#define OCE_VIS_IGES_MODULE "liboce_vis_iges.so"
+#endif
+
+#ifndef OCE_VIS_STEP_MODULE
+#define OCE_VIS_STEP_MODULE "liboce_vis_step.so"
+#endif
+
+#ifndef OCE_VIS_MODULE_DIR
+#define OCE_VIS_MODULE_DIR "/usr/local/lib"
+#endif
 
 // precision for mesh creation; 0.07 should be good enough for ECAD viewing
 #define USER_PREC (0.14)
@@ -102,6 +157,71 @@ typedef std::map< std::string, SGNODE* >   FACEMAP;
 typedef std::map< std::string, std::vector< SGNODE* > > NODEMAP;
 typedef std::pair< std::string, std::vector< SGNODE* > > NODEITEM;
 
+// face sets are keyed on the underlying face geometry and the
+// orientation (true if reversed); the face location is not included
+typedef std::pair< const TopoDS_TShape*, bool > MESHKEY;
+
+struct MESHITEM
+{
+    SGNODE* faceSet;    // SGFACESET shared by all occurrences of the face
+    SGNODE* coords;     // SGCOORDS shared by both orientations of the face
+};
+
+typedef std::map< MESHKEY, MESHITEM > MESHMAP;
+typedef std::map< const TopoDS_TShape*, SGNODE* > LINEMAP;
+
+// merged solids are keyed on the underlying solid geometry and on the
+// inherited color, which is baked into the per-vertex colors of faces
+// which have no color of their own
+struct MERGEKEY
+{
+    const TopoDS_TShape* tshape;
+    Standard_Real rgb[3];   // inherited color; -1 if there is none
+
+    MERGEKEY( const TopoDS_TShape* aShape, const Quantity_Color* aColor )
+    {
+        tshape = aShape;
+        rgb[0] = aColor ? aColor->Red() : -1.0;
+        rgb[1] = aColor ? aColor->Green() : -1.0;
+        rgb[2] = aColor ? aColor->Blue() : -1.0;
+    }
+
+    bool operator<( const MERGEKEY& aKey ) const
+    {
+        if( tshape != aKey.tshape )
+            return tshape < aKey.tshape;
+
+        for( int i = 0; i < 3; ++i )
+        {
+            if( rgb[i] != aKey.rgb[i] )
+                return rgb[i] < aKey.rgb[i];
+        }
+
+        return false;
+    }
+};
+
+struct MERGEITEM
+{
+    SGNODE* faces;      // SGSHAPE holding the merged face set
+    SGNODE* lines;      // SGSHAPE holding the merged edges; may be NULL
+};
+
+typedef std::map< MERGEKEY, MERGEITEM > MERGEMAP;
+
+// content hashes of solids keyed on the underlying solid geometry
+typedef std::map< const TopoDS_TShape*, std::string > HASHMAP;
+
+/**
+ * PROGRESS_FUNC
+ * is invoked each time a solid or face has been converted; aContext is the
+ * pointer registered with the callback and the totals are counted from the
+ * free shapes before the conversion starts.  Returning false cancels the
+ * conversion.
+ */
+typedef bool (*PROGRESS_FUNC)( void* aContext, int aSolidsDone, int aSolids,
+    int aFacesDone, int aFaces );
+
 enum FormatType
 {
     FMT_NONE = 0,
@@ -109,20 +229,54 @@ enum FormatType
     FMT_IGES = 2
 };
 
+// product filter state inherited by the children of an assembly
+struct FILTER_STATE
+{
+    int  depth;         // assembly depth of the shape; free shapes are at depth 0
+    bool included;      // true if the shape or an ancestor matched an include filter
+    std::string path;   // product names from the free shape down, separated by '/'
+};
+
 // VRML conversion parameters
 struct PARAMS
 {
     FormatType format;
+    bool   compressed;      // input is gzip compressed
     double deflection;
     double angleIncrement;
     bool   useHierarchy;
     bool   useNormals;
+    bool   useEdges;        // extract feature edges as line sets
+    bool   mergeFaces;      // merge the faces of a solid into one face set
+    int    aoSamples;       // occlusion rays per vertex; 0 for no occlusion
+    bool   incremental;     // reuse unchanged solids from the output's cache
+    bool   persistDoc;      // keep the transferred document beside the input
     std::string inputFile;
+    std::string placementFile;  // board placement list; replaces inputFile
+    std::vector< std::string > includes;    // product patterns to convert
+    std::vector< std::string > excludes;    // product patterns to skip
+    int    maxDepth;        // max. assembly depth to convert; -1 for no limit
+    bool   estimate;        // only estimate the cost of the conversion
     std::string outputFile;
 };
 
 #define DEFAULT_OUT "output.wrl"
 
+// placement of a model within a board assembly
+struct PLACEMENT
+{
+    std::string model;  // model file name
+    double x;           // position (mm)
+    double y;
+    double z;
+    double rotation;    // rotation about the Z axis (degrees)
+    bool   bottom;      // true if the model is flipped onto the bottom side
+};
+
+// converted model subtrees keyed on the model file name; NULL if the model
+// could not be converted
+typedef std::map< std::string, SGNODE* > MODELMAP;
+
 // note: getopt would make life easier but there is no guarantee
 // of its availability
 bool processArgs( int argc, const char** argv, PARAMS& args );
@@ -139,6 +293,26 @@ bool processComp( const TopoDS_Shape& shape, DATA& data, SGNODE* parent,
 bool processFace( const TopoDS_Face& face, DATA& data, SGNODE* parent,
     std::vector< SGNODE* >* items, Quantity_Color* color );
 
+SGNODE* getFaceSet( const TopoDS_Face& face, bool reverse, DATA& data );
+
+Quantity_Color* getFaceColor( const TopoDS_Face& face, DATA& data,
+    Quantity_Color* color, Quantity_Color& lcolor );
+
+Handle(Poly_Triangulation) meshFace( const TopoDS_Face& face, DATA& data,
+    TopLoc_Location& loc );
+
+void addEdges( const TopoDS_Face& face, const Handle(Poly_Triangulation)& triangulation,
+    const TopLoc_Location& loc, const gp_Trsf* trsf, DATA& data,
+    std::vector< SGPOINT >& vertices, std::vector< int >& indices );
+
+bool processCachedSolid( const TopoDS_Shape& shape, DATA& data, SGNODE* parent,
+    Quantity_Color* color );
+
+SGNODE* processEdges( const TopoDS_Face& face, DATA& data );
+
+bool processMerged( const TopoDS_Shape& shape, DATA& data, SGNODE* parent,
+    Quantity_Color* color );
+
 
 struct DATA
 {
@@ -147,22 +321,66 @@ struct DATA
     Handle( XCAFDoc_ShapeTool ) m_assy;
     SGNODE* scene;
     SGNODE* defaultColor;
+    SGNODE* edgeColor;
     Quantity_Color refColor;
     NODEMAP  shapes;    // SGNODE lists representing a TopoDS_SOLID / COMPOUND
     COLORMAP colors;    // SGAPPEARANCE nodes
     FACEMAP  faces;     // SGSHAPE items representing a TopoDS_FACE
+    MESHMAP  meshes;    // SGFACESET items representing a face triangulation
+    LINEMAP  lines;     // SGLINESET items representing the edges of a face
+    MERGEMAP merged;    // SGSHAPE items representing the merged faces of a solid
+    TopTools_MapOfShape edges;  // edges already outlined within the current solid
+    std::string cacheDir;   // per-solid cache files; empty unless incremental
+    HASHMAP solidHashes;    // geometry hashes of the solids to be converted
+    std::set< std::string > usedHashes; // cache entries used by this conversion
+    int solidsReused;   // number of solids read from the cache
+    std::vector< std::string > includes;    // product patterns to convert
+    std::vector< std::string > excludes;    // product patterns to skip
+    int maxDepth;       // max. assembly depth to convert; -1 for no limit
+    FILTER_STATE filter;    // filter state of the shape being converted
     bool renderBoth;
     bool hasSolid;      // set to true if there is a parent solid
     bool useNorms;      // set to true to calculate normals for the VRML file
+    bool useEdges;      // set to true to outline the feature edges
+    bool mergeFaces;    // set to true to merge the faces of each solid
+    int aoSamples;      // occlusion rays per vertex of a merged solid
+    double deflection;  // max. surface deflection for meshing (mm)
+    double angle;       // max. angular deflection for meshing (radians)
+    PROGRESS_FUNC progress; // optional progress and cancellation callback
+    void* progressCtx;  // context passed to the progress callback
+    int nSolids;        // number of solids to be converted
+    int nFaces;         // number of faces to be converted
+    int solidsDone;
+    int facesDone;
+    bool cancelled;     // set to true when the callback cancels the conversion
+    double readerTime;  // seconds spent loading the reader module
 
     DATA()
     {
         scene = NULL;
         defaultColor = NULL;
+        edgeColor = NULL;
         refColor.SetValues( Quantity_NOC_BLACK );
         renderBoth = false;
         hasSolid = false;
         useNorms = false;
+        useEdges = false;
+        mergeFaces = false;
+        aoSamples = 0;
+        deflection = USER_PREC;
+        angle = USER_ANGLE;
+        progress = NULL;
+        progressCtx = NULL;
+        nSolids = 0;
+        nFaces = 0;
+        solidsDone = 0;
+        facesDone = 0;
+        cancelled = false;
+        readerTime = 0.0;
+        solidsReused = 0;
+        maxDepth = -1;
+        filter.depth = -1;
+        filter.included = true;
     }
 
     ~DATA()
@@ -187,6 +405,9 @@ struct DATA
         if( defaultColor && NULL == S3D::GetSGNodeParent( defaultColor ) )
             S3D::DestroyNode( defaultColor );
 
+        if( edgeColor && NULL == S3D::GetSGNodeParent( edgeColor ) )
+            S3D::DestroyNode( edgeColor );
+
         // destroy any faces with no parent
         if( !faces.empty() )
         {
@@ -204,6 +425,59 @@ struct DATA
             faces.clear();
         }
 
+        // destroy any face sets or line sets with no parent
+        if( !meshes.empty() )
+        {
+            MESHMAP::iterator sM = meshes.begin();
+            MESHMAP::iterator eM = meshes.end();
+
+            while( sM != eM )
+            {
+                if( NULL == S3D::GetSGNodeParent( sM->second.faceSet ) )
+                    S3D::DestroyNode( sM->second.faceSet );
+
+                ++sM;
+            }
+
+            meshes.clear();
+        }
+
+        if( !lines.empty() )
+        {
+            LINEMAP::iterator sL = lines.begin();
+            LINEMAP::iterator eL = lines.end();
+
+            while( sL != eL )
+            {
+                if( NULL != sL->second && NULL == S3D::GetSGNodeParent( sL->second ) )
+                    S3D::DestroyNode( sL->second );
+
+                ++sL;
+            }
+
+            lines.clear();
+        }
+
+        if( !merged.empty() )
+        {
+            MERGEMAP::iterator sM = merged.begin();
+            MERGEMAP::iterator eM = merged.end();
+
+            while( sM != eM )
+            {
+                if( NULL == S3D::GetSGNodeParent( sM->second.faces ) )
+                    S3D::DestroyNode( sM->second.faces );
+
+                if( NULL != sM->second.lines
+                    && NULL == S3D::GetSGNodeParent( sM->second.lines ) )
+                    S3D::DestroyNode( sM->second.lines );
+
+                ++sM;
+            }
+
+            merged.clear();
+        }
+
         // destroy any shapes with no parent
         if( !shapes.empty() )
         {
@@ -235,6 +509,16 @@ struct DATA
         
     }
     
+    // invoke the progress callback; returns false if the conversion is cancelled
+    bool Report( void )
+    {
+        if( !cancelled && NULL != progress
+            && !progress( progressCtx, solidsDone, nSolids, facesDone, nFaces ) )
+            cancelled = true;
+
+        return !cancelled;
+    }
+
     // find collection of tagged nodes
     bool GetShape( const std::string& id, std::vector< SGNODE* >*& listPtr )
     {
@@ -295,21 +579,57 @@ struct DATA
         
         return app.GetRawPtr();
     }
+
+    // return the appearance of the feature edges; lines are unlit
+    // so the color is set via the emissive term
+    SGNODE* GetEdgeColor( void )
+    {
+        if( edgeColor )
+            return edgeColor;
+
+        IFSG_APPEARANCE app( true );
+        app.SetShininess( 0.0 );
+        app.SetSpecular( 0.0, 0.0, 0.0 );
+        app.SetAmbient( 0.0, 0.0, 0.0 );
+        app.SetDiffuse( 0.0, 0.0, 0.0 );
+        app.SetEmissive( 0.05, 0.05, 0.05 );
+
+        edgeColor = app.GetRawPtr();
+        return edgeColor;
+    }
 };
 
 
-FormatType fileType( const char* aFileName )
+bool isCompressed( const char* aFileName )
 {
     std::ifstream ifile;
-    ifile.open( aFileName );
-    
+    ifile.open( aFileName, std::ios_base::in | std::ios_base::binary );
+
     if( !ifile.is_open() )
+        return false;
+
+    unsigned char magic[2] = { 0, 0 };
+    ifile.read( (char*)magic, 2 );
+    ifile.close();
+
+    // gzip member header: ID1 = 0x1f, ID2 = 0x8b
+    return ( magic[0] == 0x1f && magic[1] == 0x8b );
+}
+
+
+FormatType fileType( const char* aFileName )
+{
+    // note: gzread() passes uncompressed files through unchanged so
+    // this test works for both plain and gzip compressed inputs
+    gzFile ifile = gzopen( aFileName, "rb" );
+
+    if( NULL == ifile )
         return FMT_NONE;
-    
+
     char iline[82];
     memset( iline, 0, 82 );
-    ifile.getline( iline, 82 );
-    ifile.close();
+    gzgets( ifile, iline, 82 );
+    gzclose( ifile );
     iline[81] = 0;  // ensure NULL termination when string is too long
     
     // check for STEP in Part 21 format
@@ -334,6 +654,192 @@ FormatType fileType( const char* aFileName )
 }
 
 
+/*
+ * INFLATED_FILE
+ * holds the decompressed contents of a gzip input in a memory-backed
+ * file so that the OCE readers, which only accept a file name, may
+ * read the model without the uncompressed data being written to disk.
+ * On Linux an anonymous memfd is used and the reader is handed its
+ * /proc/self/fd path; on other POSIX systems the data is placed in an
+ * unlinked-on-close file in /dev/shm (or TMPDIR if /dev/shm is absent).
+ */
+class INFLATED_FILE
+{
+private:
+    int         m_fd;
+    std::string m_path;
+    bool        m_unlink;   // true if m_path must be removed on close
+
+    // hide the copy constructor and assignment operator
+    INFLATED_FILE( const INFLATED_FILE& );
+    INFLATED_FILE& operator=( const INFLATED_FILE& );
+
+    bool create( void );
+
+public:
+    INFLATED_FILE()
+    {
+        m_fd = -1;
+        m_unlink = false;
+    }
+
+    ~INFLATED_FILE()
+    {
+        Close();
+    }
+
+    /**
+     * Function Inflate
+     * decompresses the given gzip file into a memory-backed file
+     *
+     * @return true on success; GetPath() then names the inflated data
+     */
+    bool Inflate( const char* aFileName );
+
+    const char* GetPath( void ) const
+    {
+        return m_path.c_str();
+    }
+
+    void Close( void );
+};
+
+
+bool INFLATED_FILE::create( void )
+{
+#if defined( _WIN32 )
+    return false;
+#else
+
+#if defined( __linux__ ) && defined( SYS_memfd_create )
+    m_fd = (int) syscall( SYS_memfd_create, "oce_vis", 0 );
+
+    if( m_fd >= 0 )
+    {
+        std::ostringstream ostr;
+        ostr << "/proc/self/fd/" << m_fd;
+        m_path = ostr.str();
+        m_unlink = false;
+        return true;
+    }
+#endif
+
+    std::string tmpl;
+
+    if( 0 == access( "/dev/shm", W_OK ) )
+    {
+        tmpl = "/dev/shm";
+    }
+    else
+    {
+        const char* tmpdir = getenv( "TMPDIR" );
+        tmpl = ( tmpdir && tmpdir[0] ) ? tmpdir : "/tmp";
+    }
+
+    tmpl.append( "/oce_vis_XXXXXX" );
+    std::vector< char > buf( tmpl.begin(), tmpl.end() );
+    buf.push_back( 0 );
+    m_fd = mkstemp( &buf[0] );
+
+    if( m_fd < 0 )
+        return false;
+
+    m_path = &buf[0];
+    m_unlink = true;
+    return true;
+#endif
+}
+
+
+bool INFLATED_FILE::Inflate( const char* aFileName )
+{
+    Close();
+
+#if defined( _WIN32 )
+    std::cerr << "* compressed input is not supported on this platform\n";
+    return false;
+#else
+    gzFile ifile = gzopen( aFileName, "rb" );
+
+    if( NULL == ifile )
+    {
+        std::cerr << "* could not open compressed file '" << aFileName << "'\n";
+        return false;
+    }
+
+    if( !create() )
+    {
+        std::cerr << "* could not create a memory-backed file for decompression\n";
+        gzclose( ifile );
+        return false;
+    }
+
+    // large reads keep the number of inflate/write cycles low
+    gzbuffer( ifile, 1 << 17 );
+    std::vector< char > buf( 1 << 20 );
+    int nread;
+    bool ok = true;
+
+    while( ok && ( nread = gzread( ifile, &buf[0], (unsigned int)buf.size() ) ) > 0 )
+    {
+        const char* bp = &buf[0];
+
+        while( nread > 0 )
+        {
+            ssize_t nw = write( m_fd, bp, nread );
+
+            if( nw <= 0 )
+            {
+                ok = false;
+                break;
+            }
+
+            bp += nw;
+            nread -= (int)nw;
+        }
+    }
+
+    if( nread < 0 )
+    {
+        int errnum = 0;
+        std::cerr << "* corrupt compressed file '" << aFileName << "': ";
+        std::cerr << gzerror( ifile, &errnum ) << "\n";
+        ok = false;
+    }
+    else if( !ok )
+    {
+        std::cerr << "* could not write decompressed data\n";
+    }
+
+    gzclose( ifile );
+
+    if( !ok || lseek( m_fd, 0, SEEK_SET ) < 0 )
+    {
+        Close();
+        return false;
+    }
+
+    return true;
+#endif
+}
+
+
+void INFLATED_FILE::Close( void )
+{
+#if !defined( _WIN32 )
+    if( m_fd >= 0 )
+        close( m_fd );
+
+    if( m_unlink && !m_path.empty() )
+        unlink( m_path.c_str() );
+#endif
+
+    m_fd = -1;
+    m_unlink = false;
+    m_path.clear();
+}
+
+
 void getTag( TDF_Label& label, std::string& aTag )
 {
     aTag.clear();
@@ -422,13 +928,51 @@ void addItems( SGNODE* parent, std::vector< SGNODE* >* lp )
 }
 
 
+// add a node as a child if it has no parent, otherwise as a reference
+void attachNode( SGNODE* parent, SGNODE* item )
+{
+    if( NULL == parent || NULL == item )
+        return;
+
+    if( NULL == S3D::GetSGNodeParent( item ) )
+        S3D::AddSGNodeChild( parent, item );
+    else
+        S3D::AddSGNodeRef( parent, item );
+
+    return;
+}
+
+
+// set the translation and rotation of a transform node from an OCE location
+void setTransform( IFSG_TRANSFORM& node, const TopLoc_Location& loc )
+{
+    if( loc.IsIdentity() )
+        return;
+
+    gp_Trsf T = loc.Transformation();
+    gp_XYZ coord = T.TranslationPart();
+    node.SetTranslation( SGPOINT( coord.X(), coord.Y(), coord.Z() ) );
+    gp_XYZ axis;
+    Standard_Real angle;
+
+    if( T.GetRotation( axis, angle ) )
+        node.SetRotation( SGVECTOR( axis.X(), axis.Y(), axis.Z() ), angle );
+
+    return;
+}
+
+
 bool processShell( const TopoDS_Shape& shape, DATA& data, SGNODE* parent,
     std::vector< SGNODE* >* items, Quantity_Color* color )
 {
     TopoDS_Iterator it;
     bool ret = false;
 
-    for( it.Initialize( shape, false, false ); it.More(); it.Next() )
+    // edges are only shared between faces of the same solid or free shell
+    if( data.useEdges && !data.hasSolid )
+        data.edges.Clear();
+
+    for( it.Initialize( shape, false, false ); it.More() && !data.cancelled; it.Next() )
     {
         const TopoDS_Face& face = TopoDS::Face( it.Value() );
 
@@ -468,20 +1012,9 @@ bool processSolid( const TopoDS_Shape& shape, DATA& data, SGNODE* parent,
     TopoDS_Iterator it;
     IFSG_TRANSFORM childNode( parent );
     SGNODE* pptr = childNode.GetRawPtr();
-    TopLoc_Location loc = shape.Location();
     bool ret = false;
 
-    if( !loc.IsIdentity() )
-    {
-        gp_Trsf T = loc.Transformation();
-        gp_XYZ coord = T.TranslationPart();
-        childNode.SetTranslation( SGPOINT( coord.X(), coord.Y(), coord.Z() ) );
-        gp_XYZ axis;
-        Standard_Real angle;
-
-        if( T.GetRotation( axis, angle ) )
-            childNode.SetRotation( SGVECTOR( axis.X(), axis.Y(), axis.Z() ), angle );
-    }
+    setTransform( childNode, shape.Location() );
 
     std::vector< SGNODE* >* component = NULL;
 
@@ -499,14 +1032,32 @@ bool processSolid( const TopoDS_Shape& shape, DATA& data, SGNODE* parent,
     // instantiate the solid
     std::vector< SGNODE* > itemList;
 
-    for( it.Initialize( shape, false, false ); it.More(); it.Next() )
+    if( !data.cacheDir.empty() )
     {
-        const TopoDS_Shape& subShape = it.Value();
+        ret = processCachedSolid( shape, data, pptr, lcolor );
+    }
+    else if( data.mergeFaces )
+    {
+        ret = processMerged( shape, data, pptr, lcolor );
+    }
+    else
+    {
+        // edges are only shared between faces of the same solid
+        if( data.useEdges )
+            data.edges.Clear();
 
-        if( processShell( subShape, data, pptr, &itemList, lcolor ) )
-            ret = true;
+        for( it.Initialize( shape, false, false ); it.More() && !data.cancelled; it.Next() )
+        {
+            const TopoDS_Shape& subShape = it.Value();
+
+            if( processShell( subShape, data, pptr, &itemList, lcolor ) )
+                ret = true;
+        }
     }
 
+    ++data.solidsDone;
+    data.Report();
+
     if( !ret )
         childNode.Destroy();
     else if( NULL != items )
@@ -516,59 +1067,391 @@ bool processSolid( const TopoDS_Shape& shape, DATA& data, SGNODE* parent,
 }
 
 
-bool processComp( const TopoDS_Shape& shape, DATA& data, SGNODE* parent,
-    std::vector< SGNODE* >* items )
+// FNV-1a hash of a string as 16 hex digits
+std::string hashString( const std::string& aData )
 {
-    TopoDS_Iterator it;
-    IFSG_TRANSFORM childNode( parent );
-    SGNODE* pptr = childNode.GetRawPtr();
-    TopLoc_Location loc = shape.Location();
-    bool ret = false;
+    unsigned long long hash = 14695981039346656037ULL;
 
-    if( !loc.IsIdentity() )
+    for( size_t i = 0; i < aData.size(); ++i )
     {
-        gp_Trsf T = loc.Transformation();
-        gp_XYZ coord = T.TranslationPart();
-        childNode.SetTranslation( SGPOINT( coord.X(), coord.Y(), coord.Z() ) );
-        gp_XYZ axis;
-        Standard_Real angle;
-
-        if( T.GetRotation( axis, angle ) )
-            childNode.SetRotation( SGVECTOR( axis.X(), axis.Y(), axis.Z() ), angle );
+        hash ^= (unsigned char) aData[i];
+        hash *= 1099511628211ULL;
     }
 
-    for( it.Initialize( shape, false, false ); it.More(); it.Next() )
-    {
-        const TopoDS_Shape& subShape = it.Value();
-        TopAbs_ShapeEnum stype = subShape.ShapeType();
-        data.hasSolid = false;
+    char buf[17];
+    snprintf( buf, sizeof( buf ), "%016llx", hash );
+    return std::string( buf );
+}
 
-        switch( stype )
-        {
-            case TopAbs_COMPOUND:
-            case TopAbs_COMPSOLID:
-                if( processComp( subShape, data, pptr, items ) )
-                    ret = true;
-                break;
 
-            case TopAbs_SOLID:
-                if( processSolid( subShape, data, pptr, items ) )
-                    ret = true;
-                break;
+// hash the topology and geometry of every solid within a shape; this must be
+// done before meshing since BRepTools::Write includes any triangulation
+void hashSolids( const TopoDS_Shape& shape, DATA& data )
+{
+    TopExp_Explorer ex;
 
-            case TopAbs_SHELL:
-                if( processShell( subShape, data, pptr, items, NULL ) )
-                    ret = true;
-                break;
+    for( ex.Init( shape, TopAbs_SOLID ); ex.More(); ex.Next() )
+    {
+        const TopoDS_Shape& solid = ex.Current();
+        const TopoDS_TShape* tshape = solid.TShape().operator->();
 
-            case TopAbs_FACE:
-                if( processFace( TopoDS::Face( subShape ), data, pptr, items, NULL ) )
-                    ret = true;
-                break;
+        if( data.solidHashes.find( tshape ) != data.solidHashes.end() )
+            continue;
 
-            default:
-                break;
-        }
+        // the placement of the solid is applied by its parent transform
+        // so it is not part of the content
+        std::ostringstream ostr;
+        BRepTools::Write( solid.Located( TopLoc_Location() ), ostr );
+        data.solidHashes.insert( std::pair< const TopoDS_TShape*,
+            std::string >( tshape, hashString( ostr.str() ) ) );
+    }
+
+    return;
+}
+
+
+// reuse the cached subtree of an unchanged solid or else convert the solid
+// and write its subtree to the cache
+bool processCachedSolid( const TopoDS_Shape& shape, DATA& data, SGNODE* parent,
+    Quantity_Color* color )
+{
+    const TopoDS_TShape* tshape = shape.TShape().operator->();
+    HASHMAP::iterator hItem = data.solidHashes.find( tshape );
+
+    if( hItem == data.solidHashes.end() )
+    {
+        hashSolids( shape, data );
+        hItem = data.solidHashes.find( tshape );
+    }
+
+    // the cache entry depends on the geometry, color and conversion settings
+    std::ostringstream key;
+    key << hItem->second << " " << data.deflection << " " << data.angle;
+    key << " " << data.useNorms << data.useEdges << data.renderBoth << data.mergeFaces;
+    key << " " << data.aoSamples;
+
+    if( NULL != color )
+        key << " " << color->Red() << " " << color->Green() << " " << color->Blue();
+
+    // colors assigned to individual faces take precedence over the solid
+    // color so a model which only recolors a face must not reuse the entry
+    TopExp_Explorer fex;
+    int nface = 0;
+
+    for( fex.Init( shape, TopAbs_FACE ); fex.More(); fex.Next(), ++nface )
+    {
+        Quantity_Color lcolor;
+
+        if( NULL != getFaceColor( TopoDS::Face( fex.Current() ), data, NULL, lcolor ) )
+        {
+            key << " f" << nface << " " << lcolor.Red() << " " << lcolor.Green();
+            key << " " << lcolor.Blue();
+        }
+    }
+
+    std::string hash = hashString( key.str() );
+    std::string fname = data.cacheDir;
+    fname.append( "/" ).append( hash ).append( ".3dc" );
+    data.usedHashes.insert( hash );
+
+#if defined( _WIN32 )
+    if( 0 == _access( fname.c_str(), 4 ) )
+#else
+    if( 0 == access( fname.c_str(), R_OK ) )
+#endif
+    {
+        SGNODE* cached = S3D::ReadCache( fname.c_str(), NULL, NULL );
+
+        if( NULL != cached )
+        {
+            S3D::AddSGNodeChild( parent, cached );
+
+            TopExp_Explorer ex;
+
+            for( ex.Init( shape, TopAbs_FACE ); ex.More(); ex.Next() )
+                ++data.facesDone;
+
+            ++data.solidsReused;
+            return true;
+        }
+    }
+
+    IFSG_TRANSFORM body( true );
+    bool ret = false;
+
+    // the solid is converted with its own node maps so that the subtree
+    // holds no references to nodes owned by other solids
+    {
+        DATA solidData;
+        solidData.m_doc = data.m_doc;
+        solidData.m_color = data.m_color;
+        solidData.m_assy = data.m_assy;
+        solidData.renderBoth = data.renderBoth;
+        solidData.hasSolid = true;
+        solidData.useNorms = data.useNorms;
+        solidData.useEdges = data.useEdges;
+        solidData.mergeFaces = data.mergeFaces;
+        solidData.aoSamples = data.aoSamples;
+        solidData.deflection = data.deflection;
+        solidData.angle = data.angle;
+        solidData.progress = data.progress;
+        solidData.progressCtx = data.progressCtx;
+        solidData.nSolids = data.nSolids;
+        solidData.nFaces = data.nFaces;
+        solidData.solidsDone = data.solidsDone;
+        solidData.facesDone = data.facesDone;
+
+        TopoDS_Iterator it;
+        std::vector< SGNODE* > itemList;
+
+        if( solidData.mergeFaces )
+        {
+            ret = processMerged( shape, solidData, body.GetRawPtr(), color );
+        }
+        else
+        {
+            for( it.Initialize( shape, false, false ); it.More() && !solidData.cancelled;
+                it.Next() )
+            {
+                if( processShell( it.Value(), solidData, body.GetRawPtr(),
+                    &itemList, color ) )
+                    ret = true;
+            }
+        }
+
+        data.facesDone = solidData.facesDone;
+        data.cancelled = solidData.cancelled;
+    }
+
+    if( !ret || data.cancelled )
+    {
+        body.Destroy();
+        return false;
+    }
+
+    if( !S3D::WriteCache( fname.c_str(), true, body.GetRawPtr(), NULL ) )
+        std::cout << "* could not write cache file '" << fname << "'\n";
+
+    S3D::AddSGNodeChild( parent, body.GetRawPtr() );
+    return true;
+}
+
+
+// remove cache files which were not used by the current conversion
+void pruneCache( const std::string& aCacheDir, const std::set< std::string >& aUsed )
+{
+    std::vector< std::string > names;
+
+#if defined( _WIN32 )
+    WIN32_FIND_DATAA entry;
+    std::string spec = aCacheDir;
+    HANDLE dir = FindFirstFileA( spec.append( "/*.3dc" ).c_str(), &entry );
+
+    if( INVALID_HANDLE_VALUE == dir )
+        return;
+
+    do
+    {
+        if( !( entry.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY ) )
+            names.push_back( entry.cFileName );
+    } while( FindNextFileA( dir, &entry ) );
+
+    FindClose( dir );
+#else
+    DIR* dir = opendir( aCacheDir.c_str() );
+
+    if( NULL == dir )
+        return;
+
+    struct dirent* entry;
+
+    while( NULL != ( entry = readdir( dir ) ) )
+        names.push_back( entry->d_name );
+
+    closedir( dir );
+#endif
+
+    for( size_t i = 0; i < names.size(); ++i )
+    {
+        const std::string& name = names[i];
+        size_t nc = name.size();
+
+        if( nc < 5 || name.compare( nc - 4, 4, ".3dc" ) )
+            continue;
+
+        if( aUsed.find( name.substr( 0, nc - 4 ) ) != aUsed.end() )
+            continue;
+
+        std::string fname = aCacheDir;
+        fname.append( "/" ).append( name );
+        remove( fname.c_str() );
+    }
+
+    return;
+}
+
+
+// returns true if the shell wildcard pattern matches the whole string; on
+// Windows PathMatchSpecA() is used, which ignores case and has no [] sets
+bool matchPattern( const std::string& aPattern, const std::string& aString )
+{
+    if( aString.empty() )
+        return false;
+
+#if defined( _WIN32 )
+    return PathMatchSpecA( aString.c_str(), aPattern.c_str() ) ? true : false;
+#else
+    return 0 == fnmatch( aPattern.c_str(), aString.c_str(), 0 );
+#endif
+}
+
+
+// returns true if any pattern matches the product name, name path or label tag
+bool matchFilter( const std::vector< std::string >& aPatterns, const std::string& aName,
+    const std::string& aPath, const std::string& aTag )
+{
+    std::vector< std::string >::const_iterator sP = aPatterns.begin();
+    std::vector< std::string >::const_iterator eP = aPatterns.end();
+
+    while( sP != eP )
+    {
+        if( matchPattern( *sP, aName ) || matchPattern( *sP, aPath )
+            || matchPattern( *sP, aTag ) )
+            return true;
+
+        ++sP;
+    }
+
+    return false;
+}
+
+
+// apply the product filters and depth limit to a shape before it is
+// descended into; on success data.filter holds the state for the shape's
+// children and the caller must restore the previous state afterwards
+bool enterShape( const TopoDS_Shape& shape, DATA& data )
+{
+    if( data.includes.empty() && data.excludes.empty() && data.maxDepth < 0 )
+        return true;
+
+    ++data.filter.depth;
+
+    if( data.maxDepth >= 0 && data.filter.depth > data.maxDepth )
+        return false;
+
+    std::string name;
+    std::string tag;
+    TDF_Label label;
+
+    if( data.m_assy->FindShape( shape, label, Standard_False ) )
+    {
+        getTag( label, tag );
+        Handle(TDataStd_Name) lname;
+
+        if( label.FindAttribute( TDataStd_Name::GetID(), lname ) )
+        {
+            TCollection_AsciiString aname( lname->Get(), '?' );
+            name = aname.ToCString();
+        }
+    }
+
+    if( !name.empty() )
+    {
+        if( !data.filter.path.empty() )
+            data.filter.path.append( 1, '/' );
+
+        data.filter.path.append( name );
+    }
+
+    if( matchFilter( data.excludes, name, data.filter.path, tag ) )
+        return false;
+
+    if( !data.filter.included
+        && matchFilter( data.includes, name, data.filter.path, tag ) )
+        data.filter.included = true;
+
+    // assemblies are descended in search of included products but
+    // solids, shells and faces are only converted within an included branch
+    TopAbs_ShapeEnum stype = shape.ShapeType();
+
+    if( !data.filter.included && TopAbs_COMPOUND != stype && TopAbs_COMPSOLID != stype )
+        return false;
+
+    return true;
+}
+
+
+// credit the solids and faces of a pruned branch to the progress counts
+// since countShapes() includes them in the totals
+void skipShape( const TopoDS_Shape& shape, DATA& data )
+{
+    TopExp_Explorer ex;
+
+    for( ex.Init( shape, TopAbs_SOLID ); ex.More(); ex.Next() )
+        ++data.solidsDone;
+
+    for( ex.Init( shape, TopAbs_FACE ); ex.More(); ex.Next() )
+        ++data.facesDone;
+
+    data.Report();
+    return;
+}
+
+
+bool processComp( const TopoDS_Shape& shape, DATA& data, SGNODE* parent,
+    std::vector< SGNODE* >* items )
+{
+    TopoDS_Iterator it;
+    IFSG_TRANSFORM childNode( parent );
+    SGNODE* pptr = childNode.GetRawPtr();
+    bool ret = false;
+
+    setTransform( childNode, shape.Location() );
+
+    for( it.Initialize( shape, false, false ); it.More() && !data.cancelled; it.Next() )
+    {
+        const TopoDS_Shape& subShape = it.Value();
+        TopAbs_ShapeEnum stype = subShape.ShapeType();
+        data.hasSolid = false;
+
+        // filtered branches are pruned before they are tessellated
+        FILTER_STATE filter = data.filter;
+
+        if( !enterShape( subShape, data ) )
+        {
+            data.filter = filter;
+            skipShape( subShape, data );
+            continue;
+        }
+
+        switch( stype )
+        {
+            case TopAbs_COMPOUND:
+            case TopAbs_COMPSOLID:
+                if( processComp( subShape, data, pptr, items ) )
+                    ret = true;
+                break;
+
+            case TopAbs_SOLID:
+                if( processSolid( subShape, data, pptr, items ) )
+                    ret = true;
+                break;
+
+            case TopAbs_SHELL:
+                if( processShell( subShape, data, pptr, items, NULL ) )
+                    ret = true;
+                break;
+
+            case TopAbs_FACE:
+                if( processFace( TopoDS::Face( subShape ), data, pptr, items, NULL ) )
+                    ret = true;
+                break;
+
+            default:
+                break;
+        }
+
+        data.filter = filter;
     }
 
     if( !ret )
@@ -587,6 +1470,15 @@ bool processNode( const TopoDS_Shape& shape, DATA& data, SGNODE* parent,
     bool ret = false;
     data.hasSolid = false;
 
+    FILTER_STATE filter = data.filter;
+
+    if( !enterShape( shape, data ) )
+    {
+        data.filter = filter;
+        skipShape( shape, data );
+        return false;
+    }
+
     switch( stype )
     {
         case TopAbs_COMPOUND:
@@ -614,103 +1506,839 @@ bool processNode( const TopoDS_Shape& shape, DATA& data, SGNODE* parent,
             break;
     }
 
+    data.filter = filter;
     return ret;
 }
 
 
-bool readIGES( Handle(TDocStd_Document)& m_doc, const char* fname )
+// count the solids and faces within a shape for progress reporting
+void countShapes( const TopoDS_Shape& shape, DATA& data )
 {
-    IGESCAFControl_Reader reader;
-    IFSelect_ReturnStatus stat  = reader.ReadFile( fname );
-    reader.PrintCheckLoad( Standard_False, IFSelect_ItemsByEntity ); 
+    TopExp_Explorer ex;
+
+    for( ex.Init( shape, TopAbs_SOLID ); ex.More(); ex.Next() )
+        ++data.nSolids;
+
+    for( ex.Init( shape, TopAbs_FACE ); ex.More(); ex.Next() )
+        ++data.nFaces;
+
+    return;
+}
 
-    if( stat != IFSelect_RetDone )
-        return false;
 
-    // Enable user-defined shape precision
-    if( !Interface_Static::SetIVal( "read.precision.mode", 1 ) )
+// set by SIGINT to cancel a conversion in progress
+static volatile sig_atomic_t s_cancel = 0;
+
+extern "C" void onInterrupt( int aSignal )
+{
+    s_cancel = 1;
+}
+
+
+// time of the last progress report written to stderr
+struct PROGRESS_STATE
+{
+    std::chrono::steady_clock::time_point lastReport;
+    bool reported;
+
+    PROGRESS_STATE() : reported( false ) {}
+};
+
+
+// write machine-readable progress lines to stderr at most every 250 ms
+// and on completion; a pending SIGINT cancels the conversion
+bool reportProgress( void* aContext, int aSolidsDone, int aSolids,
+    int aFacesDone, int aFaces )
+{
+    PROGRESS_STATE* state = (PROGRESS_STATE*) aContext;
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    bool done = ( aSolidsDone >= aSolids && aFacesDone >= aFaces );
+
+    if( done || !state->reported
+        || now - state->lastReport >= std::chrono::milliseconds( 250 ) )
+    {
+        std::cerr << "PROGRESS solids=" << aSolidsDone << "/" << aSolids;
+        std::cerr << " faces=" << aFacesDone << "/" << aFaces << "\n";
+        state->lastReport = now;
+        state->reported = true;
+    }
+
+    return 0 == s_cancel;
+}
+
+
+// returns true if aFileName exists and is not older than aRefName
+bool isNewer( const char* aFileName, const char* aRefName )
+{
+#if defined( _WIN32 )
+    struct _stat fileStat;
+    struct _stat refStat;
+
+    if( 0 != _stat( aFileName, &fileStat ) || 0 != _stat( aRefName, &refStat ) )
         return false;
+#else
+    struct stat fileStat;
+    struct stat refStat;
 
-    // Set the shape conversion precision to USER_PREC (default 0.0001 has too many triangles)
-    if( !Interface_Static::SetRVal( "read.precision.val", USER_PREC ) )  
+    if( 0 != stat( aFileName, &fileStat ) || 0 != stat( aRefName, &refStat ) )
         return false;
+#endif
+
+    return fileStat.st_mtime >= refStat.st_mtime;
+}
 
-    Interface_Static::SetRVal( "ShapeProcess.FixFaceSize.Tolerance", USER_PREC );
 
-    // set other translation options
-    reader.SetColorMode(true);  // use model colors
-    reader.SetNameMode(false);  // don't use IGES label names
-    reader.SetLayerMode(false); // ignore LAYER data
+// returns the directory holding the executable including the trailing
+// separator, or an empty string where it cannot be determined
+std::string getExeDir( void )
+{
+    std::string path;
+
+#if defined( _WIN32 )
+    char buf[MAX_PATH];
+    DWORD len = GetModuleFileNameA( NULL, buf, MAX_PATH );
+
+    if( len > 0 && len < MAX_PATH )
+        path.assign( buf, len );
+#elif defined( __APPLE__ )
+    uint32_t size = 0;
+    _NSGetExecutablePath( NULL, &size );
+    std::vector< char > buf( size + 1, 0 );
+
+    if( 0 == _NSGetExecutablePath( &buf[0], &size ) )
+        path = &buf[0];
+#elif defined( __linux__ )
+    char buf[4096];
+    ssize_t len = readlink( "/proc/self/exe", buf, sizeof( buf ) - 1 );
+
+    if( len > 0 )
+        path.assign( buf, len );
+#endif
+
+#if defined( _WIN32 )
+    size_t sep = path.find_last_of( "/\\" );
+#else
+    size_t sep = path.rfind( '/' );
+#endif
+
+    if( std::string::npos == sep )
+        return std::string();
+
+    return path.substr( 0, sep + 1 );
+}
 
-    if ( !reader.Transfer( m_doc ) )
+
+// search the directory holding the executable and then the install
+// directory for a reader module; the module is left loaded for the
+// life of the process since the document holds objects created by it
+OCE_READER_FUNC loadReader( FormatType aFormat )
+{
+    const char* modName = NULL;
+
+    switch( aFormat )
     {
-        std::cout << "* Translation failed\n";
-        m_doc->Close();
-        return false;
+        case FMT_IGES:
+            modName = OCE_VIS_IGES_MODULE;
+            break;
+
+        case FMT_STEP:
+            modName = OCE_VIS_STEP_MODULE;
+            break;
+
+        default:
+            return NULL;
+    }
+
+    std::vector< std::string > paths;
+    std::string exeDir = getExeDir();
+
+    if( !exeDir.empty() )
+        paths.push_back( exeDir.append( modName ) );
+
+    paths.push_back( std::string( OCE_VIS_MODULE_DIR ).append( "/" ).append( modName ) );
+
+    std::vector< std::string >::iterator sP = paths.begin();
+    std::vector< std::string >::iterator eP = paths.end();
+
+#if defined( _WIN32 )
+    HMODULE handle = NULL;
+
+    while( sP != eP && NULL == handle )
+    {
+        handle = LoadLibraryA( sP->c_str() );
+        ++sP;
+    }
+
+    if( NULL == handle )
+    {
+        std::cerr << "* could not load reader module '" << modName << "'\n";
+        std::cerr << "  error code " << GetLastError() << "\n";
+        return NULL;
     }
 
-    // are there any shapes to translate?
-    if( reader.NbShapes() < 1 )
+    OCE_READER_FUNC reader = (OCE_READER_FUNC) GetProcAddress( handle, OCE_READER_ENTRY );
+
+    if( NULL == reader )
+    {
+        std::cerr << "* invalid reader module '" << modName << "'\n";
+        FreeLibrary( handle );
+        return NULL;
+    }
+#else
+    void* handle = NULL;
+
+    while( sP != eP && NULL == handle )
+    {
+        handle = dlopen( sP->c_str(), RTLD_NOW | RTLD_LOCAL );
+        ++sP;
+    }
+
+    if( NULL == handle )
+    {
+        std::cerr << "* could not load reader module '" << modName << "'\n";
+        std::cerr << "  " << dlerror() << "\n";
+        return NULL;
+    }
+
+    OCE_READER_FUNC reader = (OCE_READER_FUNC) dlsym( handle, OCE_READER_ENTRY );
+
+    if( NULL == reader )
+    {
+        std::cerr << "* invalid reader module '" << modName << "'\n";
+        dlclose( handle );
+        return NULL;
+    }
+#endif
+
+    return reader;
+}
+
+
+void printUsage()
+{
+    std::cout << "\n* Usage: oce_vis {-h} {-n} {-e} {-c} {-r rays} {-i} {-k} {-d val} {-a val}\n";
+    std::cout << "         {-o outputfile} {-s pattern} {-x pattern} {-l depth} {--estimate}\n";
+    std::cout << "         {inputfile | -b placementfile}\n";
+    std::cout << "  -h: if present, produces a hierarchical output employing DEF/USE\n";
+    std::cout << "  -n: if present, calculates surface normals\n";
+    std::cout << "  -e: if present, outlines the edges of all faces\n";
+    std::cout << "  -c: if present, merges the faces of each solid into a single\n";
+    std::cout << "      face set with per-vertex colors\n";
+    std::cout << "  -r: bakes ambient occlusion into the vertex colors by casting\n";
+    std::cout << "      the given number of rays per vertex (1 .. 1024); implies -c;\n";
+    std::cout << "      each solid is only occluded by its own faces\n";
+    std::cout << "  -i: if present, solids unchanged since the previous conversion\n";
+    std::cout << "      are reused from the cache directory <outputfile>.cache\n";
+    std::cout << "  -k: if present, keeps the transferred model in <inputfile>.xbf\n";
+    std::cout << "      and reuses it while the input file is unchanged\n";
+    std::cout << "  -d: max. surface deflection (mm), default ";
+    std::cout << USER_PREC << " \n";
+    std::cout << "      range: 0.0001 .. 0.8\n";
+    std::cout << "  -a: max. angular increment (degrees), default ";
+    std::cout << USER_ANGLE*180.0/M_PI << " deg.\n";
+    std::cout << "      range: -45 .. -5 and 5 .. 45 deg\n";
+    std::cout << "  -o: output file; must end in .wrl\n";
+    std::cout << "  inputfile: input model; must be IGES or STEP AP203/214/242\n";
+    std::cout << "      and may be gzip compressed (.gz)\n";
+    std::cout << "  -s: converts only products whose name, name path (A/B/C) or\n";
+    std::cout << "      label tag matches the pattern; may be repeated\n";
+    std::cout << "  -x: skips products matching the pattern; may be repeated\n";
+    std::cout << "  -l: max. assembly depth to convert; free shapes are at depth 0\n";
+    std::cout << "  --estimate: meshes a sample of faces and writes the estimated\n";
+    std::cout << "      triangles, output size and time as JSON; no output is written;\n";
+    std::cout << "      the time to load the reader module is given both for the\n";
+    std::cout << "      first file (cold) and for a file after it (warm)\n";
+    std::cout << "  -b: board assembly; each line of the placement file is\n";
+    std::cout << "      <model> <x> <y> <z> <rotation (deg)> <top|bottom>\n";
+    std::cout << "      and each distinct model is converted once and reused\n";
+    std::cout << "  progress is written to stderr as lines of the form\n";
+    std::cout << "      PROGRESS solids=<done>/<total> faces=<done>/<total>\n";
+    std::cout << "  and an interrupt (Ctrl-C) cancels the conversion\n\n";
+}
+
+
+// read a placement list; each line holds a model file name (quoted if it
+// contains spaces), X, Y, Z (mm), rotation (deg) and side (top or bottom);
+// blank lines and lines starting with '#' are ignored and relative model
+// names are taken relative to the placement file
+bool readPlacements( const std::string& aFileName, std::vector< PLACEMENT >& aList )
+{
+    std::ifstream ifile( aFileName.c_str() );
+
+    if( !ifile.is_open() )
+    {
+        std::cout << "* could not open placement file '" << aFileName << "'\n";
         return false;
-    
+    }
+
+    std::string baseDir;
+    size_t sep = aFileName.rfind( '/' );
+
+    if( std::string::npos != sep )
+        baseDir = aFileName.substr( 0, sep + 1 );
+
+    std::string line;
+    int lineNo = 0;
+
+    while( std::getline( ifile, line ) )
+    {
+        ++lineNo;
+        size_t start = line.find_first_not_of( " \t\r" );
+
+        if( std::string::npos == start || '#' == line[start] )
+            continue;
+
+        PLACEMENT item;
+        std::istringstream istr;
+
+        if( '"' == line[start] )
+        {
+            size_t end = line.find( '"', start + 1 );
+
+            if( std::string::npos == end )
+            {
+                std::cout << "* unterminated model name on line " << lineNo << "\n";
+                return false;
+            }
+
+            item.model = line.substr( start + 1, end - start - 1 );
+            istr.str( line.substr( end + 1 ) );
+        }
+        else
+        {
+            istr.str( line.substr( start ) );
+            istr >> item.model;
+        }
+
+        std::string side;
+        istr >> item.x >> item.y >> item.z >> item.rotation >> side;
+
+        if( istr.fail() || item.model.empty() || ( side.compare( "top" )
+            && side.compare( "bottom" ) ) )
+        {
+            std::cout << "* invalid placement on line " << lineNo << " of '";
+            std::cout << aFileName << "'\n";
+            return false;
+        }
+
+        item.bottom = !side.compare( "bottom" );
+
+        if( '/' != item.model[0] )
+            item.model.insert( 0, baseDir );
+
+        aList.push_back( item );
+    }
+
     return true;
 }
 
 
-bool readSTEP( Handle(TDocStd_Document)& m_doc, const char* fname )
+// set up the conversion state for one model file
+bool initData( const PARAMS& args, DATA& data )
 {
-    STEPCAFControl_Reader reader;
-    IFSelect_ReturnStatus stat  = reader.ReadFile( fname );
-    
-    if( stat != IFSelect_RetDone )
-        return false;
+    data.useNorms = args.useNormals;
+    data.useEdges = args.useEdges;
+    // the occlusion is carried by the per-vertex colors of merged solids
+    data.mergeFaces = args.mergeFaces || args.aoSamples > 0;
+    data.aoSamples = args.aoSamples;
+    data.deflection = args.deflection;
+    data.angle = std::fabs( args.angleIncrement );
+    data.includes = args.includes;
+    data.excludes = args.excludes;
+    data.maxDepth = args.maxDepth;
+    data.filter.included = args.includes.empty();
+
+    // per-solid cache files are kept in a directory beside the output
+    if( args.incremental )
+    {
+        data.cacheDir = args.outputFile;
+        data.cacheDir.append( ".cache" );
+
+#if defined( _WIN32 )
+        if( 0 != _mkdir( data.cacheDir.c_str() ) && EEXIST != errno )
+#else
+        if( 0 != mkdir( data.cacheDir.c_str(), 0755 ) && EEXIST != errno )
+#endif
+        {
+            std::cout << "* could not create cache directory '";
+            std::cout << data.cacheDir << "'\n";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+// read a model file into data.m_doc
+bool loadDocument( const PARAMS& args, const std::string& aFileName, DATA& data )
+{
+    FormatType format = fileType( aFileName.c_str() );
+
+    switch( format )
+    {
+        case FMT_IGES:
+            data.renderBoth = true;
+            break;
+            
+        case FMT_STEP:
+            break;
+            
+        default:
+            std::cerr << "File is not an IGES or STEP file\n";
+            std::cerr << "filename: " << aFileName << "\n";
+            return false;
+            break;
+    }
+
+    Handle(XCAFApp_Application) m_app = XCAFApp_Application::GetApplication();
+    std::string docName = aFileName;
+    docName.append( ".xbf" );
+    bool haveDoc = false;
 
-    // Enable user-defined shape precision
-    if( !Interface_Static::SetIVal( "read.precision.mode", 1 ) )
+    // the transferred document does not depend on the meshing parameters
+    // so a document saved by an earlier run is used while the input is unchanged
+    if( args.persistDoc && isNewer( docName.c_str(), aFileName.c_str() ) )
     {
-        // ERROR
+        if( PCDM_RS_OK == m_app->Open( TCollection_ExtendedString( docName.c_str() ),
+                                       data.m_doc ) )
+        {
+            std::cerr << "* using transferred document '" << docName << "'\n";
+            haveDoc = true;
+        }
+        else
+        {
+            std::cerr << "* could not open document '" << docName << "'\n";
+        }
+    }
+
+    if( !haveDoc )
+    {
+        m_app->NewDocument( args.persistDoc ? "BinXCAF" : "MDTV-XCAF", data.m_doc );
+
+        // the OCE readers only accept a file name so compressed input is
+        // inflated into a memory-backed file and the readers given its path
+        INFLATED_FILE inflated;
+        const char* readName = aFileName.c_str();
+
+        if( isCompressed( aFileName.c_str() ) )
+        {
+            if( !inflated.Inflate( aFileName.c_str() ) )
+                return false;
+
+            readName = inflated.GetPath();
+        }
+
+        // the IGES and STEP toolkits are only loaded once the format is known
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        OCE_READER_FUNC readModel = loadReader( format );
+        data.readerTime = std::chrono::duration< double >(
+            std::chrono::steady_clock::now() - t0 ).count();
+
+        if( NULL == readModel || !readModel( data.m_doc, readName, USER_PREC ) )
+            return false;
+
+        // the decompressed data is no longer required once transferred
+        inflated.Close();
+
+        // the document is saved before meshing so that it holds no triangulations
+        if( args.persistDoc && PCDM_SS_OK != m_app->SaveAs( data.m_doc,
+            TCollection_ExtendedString( docName.c_str() ) ) )
+        {
+            std::cerr << "* could not save document '" << docName << "'\n";
+        }
+    }
+
+    data.m_assy = XCAFDoc_DocumentTool::ShapeTool( data.m_doc->Main() );
+    data.m_color = XCAFDoc_DocumentTool::ColorTool( data.m_doc->Main() );
+    return true;
+}
+
+
+// read a model file and convert its free shapes into children of aParent;
+// returns true if any shape was converted
+bool convertFile( const PARAMS& args, const std::string& aFileName, DATA& data,
+    SGNODE* aParent )
+{
+    if( !loadDocument( args, aFileName, data ) )
         return false;
+
+    // retrieve all free shapes
+    TDF_LabelSequence frshapes; 
+    data.m_assy->GetFreeShapes( frshapes );
+    
+    int nshapes = frshapes.Length();
+    bool ret = false;
+
+    // count the work up front so that progress can be reported as a fraction
+    for( int i = 1; i <= nshapes; ++i )
+    {
+        TopoDS_Shape shape = data.m_assy->GetShape( frshapes.Value(i) );
+
+        if( shape.IsNull() )
+            continue;
+
+        countShapes( shape, data );
+
+        if( !data.cacheDir.empty() )
+            hashSolids( shape, data );
     }
 
-    // Set the shape conversion precision to USER_PREC (default 0.0001 has too many triangles)
-    if( !Interface_Static::SetRVal( "read.precision.val", USER_PREC ) )  
+    PROGRESS_STATE progress;
+    data.progress = reportProgress;
+    data.progressCtx = &progress;
+    data.Report();
+
+    int id = 1;
+    
+    while( id <= nshapes && !data.cancelled )
     {
-        // ERROR
+        TopoDS_Shape shape = data.m_assy->GetShape( frshapes.Value(id) );
+
+        if ( !shape.IsNull() && processNode( shape, data, aParent, NULL ) )
+            ret = true;
+
+        ++id;
+    };
+
+    if( !data.cacheDir.empty() )
+    {
+        std::cout << "* reused " << data.solidsReused << " of ";
+        std::cout << data.nSolids << " solids from '" << data.cacheDir << "'\n";
+    }
+
+    return ret && !data.cancelled;
+}
+
+
+// approximate VRML output per mesh vertex, per triangle and per face occurrence
+#define EST_VERTEX_BYTES 30
+#define EST_TRIANGLE_BYTES 20
+#define EST_FACE_BYTES 200
+// number of faces meshed to estimate the cost of the conversion
+#define EST_SAMPLES 64
+
+
+// write a string as a JSON string literal
+void writeJSON( std::ostream& aStream, const std::string& aString )
+{
+    aStream << '"';
+
+    for( size_t i = 0; i < aString.size(); ++i )
+    {
+        unsigned char ch = aString[i];
+
+        if( '"' == ch || '\\' == ch )
+        {
+            aStream << '\\' << ch;
+        }
+        else if( ch < 0x20 )
+        {
+            char buf[8];
+            snprintf( buf, sizeof( buf ), "\\u%04x", ch );
+            aStream << buf;
+        }
+        else
+        {
+            aStream << ch;
+        }
+    }
+
+    aStream << '"';
+}
+
+
+/*
+ * STDOUT_REDIRECT
+ * sends everything written to stdout to stderr while it exists; this
+ * includes the messages which the OCE readers and toolkits print, so
+ * that stdout may carry a single result such as the JSON estimate.
+ */
+class STDOUT_REDIRECT
+{
+private:
+    int m_fd;   // duplicate of the original stdout or -1
+
+    // hide the copy constructor and assignment operator
+    STDOUT_REDIRECT( const STDOUT_REDIRECT& );
+    STDOUT_REDIRECT& operator=( const STDOUT_REDIRECT& );
+
+public:
+    STDOUT_REDIRECT()
+    {
+        std::cout.flush();
+        fflush( stdout );
+
+#if defined( _WIN32 )
+        m_fd = _dup( _fileno( stdout ) );
+
+        if( m_fd >= 0 && _dup2( _fileno( stderr ), _fileno( stdout ) ) < 0 )
+        {
+            _close( m_fd );
+            m_fd = -1;
+        }
+#else
+        m_fd = dup( fileno( stdout ) );
+
+        if( m_fd >= 0 && dup2( fileno( stderr ), fileno( stdout ) ) < 0 )
+        {
+            close( m_fd );
+            m_fd = -1;
+        }
+#endif
+    }
+
+    ~STDOUT_REDIRECT()
+    {
+        Restore();
+    }
+
+    /**
+     * Function Restore
+     * flushes the redirected output and reinstates the original stdout
+     */
+    void Restore( void )
+    {
+        if( m_fd < 0 )
+            return;
+
+        std::cout.flush();
+        fflush( stdout );
+
+#if defined( _WIN32 )
+        _dup2( m_fd, _fileno( stdout ) );
+        _close( m_fd );
+#else
+        dup2( m_fd, fileno( stdout ) );
+        close( m_fd );
+#endif
+
+        m_fd = -1;
+    }
+};
+
+
+// load a model and estimate the cost of converting it from a random sample
+// of meshed faces; the estimate is returned in aEstimate as a JSON object
+// and no scenegraph is built
+bool estimateFile( const PARAMS& args, const std::string& aFileName, DATA& data,
+    std::string& aEstimate )
+{
+    static const char* surfaceNames[] = { "plane", "cylinder", "cone", "sphere",
+        "torus", "bezier", "bspline", "revolution", "extrusion", "offset", "other" };
+    const int nSurfaceTypes = sizeof( surfaceNames ) / sizeof( surfaceNames[0] );
+
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+
+    if( !loadDocument( args, aFileName, data ) )
         return false;
+
+    double loadTime = std::chrono::duration< double >(
+        std::chrono::steady_clock::now() - t0 ).count();
+
+    // the load time includes the cold start of the reader module; loading
+    // the module again while it is resident gives the cost paid by any
+    // later file of the same format
+    double readerWarmTime = 0.0;
+
+    if( data.readerTime > 0.0 )
+    {
+        t0 = std::chrono::steady_clock::now();
+        loadReader( data.renderBoth ? FMT_IGES : FMT_STEP );
+        readerWarmTime = std::chrono::duration< double >(
+            std::chrono::steady_clock::now() - t0 ).count();
     }
 
-    // set other translation options
-    reader.SetColorMode(true);  // use model colors
-    reader.SetNameMode(false);  // don't use label names
-    reader.SetLayerMode(false); // ignore LAYER data
+    TDF_LabelSequence frshapes;
+    data.m_assy->GetFreeShapes( frshapes );
+
+    // faces are meshed once per TShape so only the distinct faces are sampled
+    std::vector< TopoDS_Face > faces;
+    std::set< const TopoDS_TShape* > seen;
+    int surfaceCounts[nSurfaceTypes] = { 0 };
+
+    for( int i = 1; i <= frshapes.Length(); ++i )
+    {
+        TopoDS_Shape shape = data.m_assy->GetShape( frshapes.Value(i) );
+
+        if( shape.IsNull() )
+            continue;
+
+        countShapes( shape, data );
+        TopExp_Explorer ex;
+
+        for( ex.Init( shape, TopAbs_FACE ); ex.More(); ex.Next() )
+        {
+            const TopoDS_Face& face = TopoDS::Face( ex.Current() );
+
+            if( !seen.insert( face.TShape().operator->() ).second )
+                continue;
+
+            faces.push_back( face );
+            BRepAdaptor_Surface surface( face, Standard_False );
+            int stype = (int) surface.GetType();
+
+            if( stype < 0 || stype >= nSurfaceTypes )
+                stype = nSurfaceTypes - 1;
+
+            ++surfaceCounts[stype];
+        }
+    }
+
+    // a fixed seed keeps repeated estimates of the same file consistent
+    std::mt19937 rng( 5489u );
+    size_t nSamples = std::min( faces.size(), (size_t) EST_SAMPLES );
+
+    for( size_t i = 0; i < nSamples; ++i )
+    {
+        std::uniform_int_distribution< size_t > pick( i, faces.size() - 1 );
+        std::swap( faces[i], faces[pick( rng )] );
+    }
+
+    double sampleTris = 0.0;
+    double sampleNodes = 0.0;
+    double sampleTime = 0.0;
+
+    for( size_t i = 0; i < nSamples; ++i )
+    {
+        t0 = std::chrono::steady_clock::now();
+        BRepMesh_IncrementalMesh IM( faces[i], data.deflection, Standard_False, data.angle );
+        sampleTime += std::chrono::duration< double >(
+            std::chrono::steady_clock::now() - t0 ).count();
+
+        TopLoc_Location loc;
+        Handle(Poly_Triangulation) triangulation = BRep_Tool::Triangulation( faces[i], loc );
+
+        if( triangulation.IsNull() )
+            continue;
+
+        sampleTris += triangulation->NbTriangles();
+        sampleNodes += triangulation->NbNodes();
+    }
+
+    double scale = nSamples > 0 ? (double) faces.size() / (double) nSamples : 0.0;
+    double triangles = sampleTris * scale;
+    double vertices = sampleNodes * scale;
+    double meshTime = sampleTime * scale;
+
+    // normals double the per-vertex data; the second side of a face
+    // shares its vertices but needs its own index list
+    double vertexBytes = EST_VERTEX_BYTES * ( data.useNorms ? 2 : 1 );
+    double triangleBytes = EST_TRIANGLE_BYTES * ( data.renderBoth ? 2 : 1 );
+    double outputBytes = vertices * vertexBytes + triangles * triangleBytes
+        + (double) data.nFaces * EST_FACE_BYTES;
+
+    std::ostringstream ostr;
+    ostr << "{\"file\":";
+    writeJSON( ostr, aFileName );
+    ostr << ",\"format\":\"" << ( data.renderBoth ? "IGES" : "STEP" ) << "\"";
+    ostr << ",\"solids\":" << data.nSolids;
+    ostr << ",\"faces\":" << data.nFaces;
+    ostr << ",\"unique_faces\":" << faces.size();
+    ostr << ",\"surface_types\":{";
+
+    for( int i = 0; i < nSurfaceTypes; ++i )
+    {
+        if( i > 0 )
+            ostr << ",";
+
+        ostr << "\"" << surfaceNames[i] << "\":" << surfaceCounts[i];
+    }
+
+    ostr << "},\"sampled_faces\":" << nSamples;
+    ostr << ",\"deflection\":" << data.deflection;
+    ostr << ",\"angle_deg\":" << data.angle * 180.0 / M_PI;
+    ostr << ",\"triangles\":" << (long long) triangles;
+    ostr << ",\"vertices\":" << (long long) vertices;
+    ostr << ",\"output_bytes\":" << (long long) outputBytes;
+    ostr << ",\"load_seconds\":" << loadTime;
+    ostr << ",\"reader_cold_seconds\":" << data.readerTime;
+    ostr << ",\"reader_warm_seconds\":" << readerWarmTime;
+    ostr << ",\"mesh_seconds\":" << meshTime;
+    ostr << ",\"total_seconds\":" << loadTime + meshTime << "}";
+
+    aEstimate = ostr.str();
+    return true;
+}
+
+
+// convert each distinct model of a placement list once and place it by
+// reference wherever it is used
+bool convertBoard( const PARAMS& args, SGNODE* aTopNode,
+    std::set< std::string >& aUsedHashes )
+{
+    std::vector< PLACEMENT > placements;
+
+    if( !readPlacements( args.placementFile, placements ) )
+        return false;
+
+    MODELMAP models;
+    bool ret = false;
+    std::vector< PLACEMENT >::iterator sP = placements.begin();
+    std::vector< PLACEMENT >::iterator eP = placements.end();
+
+    while( sP != eP && 0 == s_cancel )
+    {
+        MODELMAP::iterator mItem = models.find( sP->model );
+
+        if( mItem == models.end() )
+        {
+            std::cout << "Processing model: " << sP->model << "\n";
+            IFSG_TRANSFORM modelNode( true, true );
+            bool ok = false;
+
+            // the model's maps only hold nodes owned by modelNode once converted
+            {
+                DATA data;
+
+                if( initData( args, data ) )
+                    ok = convertFile( args, sP->model, data, modelNode.GetRawPtr() );
+
+                aUsedHashes.insert( data.usedHashes.begin(), data.usedHashes.end() );
+            }
+
+            SGNODE* model = NULL;
+
+            if( ok )
+            {
+                model = modelNode.GetRawPtr();
+            }
+            else
+            {
+                modelNode.Destroy();
+                std::cout << "* could not process model '" << sP->model << "'\n";
+            }
+
+            mItem = models.insert( std::pair< std::string, SGNODE* >( sP->model,
+                model ) ).first;
+        }
+
+        if( NULL != mItem->second )
+        {
+            IFSG_TRANSFORM place( aTopNode );
+            place.SetTranslation( SGPOINT( sP->x, sP->y, sP->z ) );
+            place.SetRotation( SGVECTOR( 0.0, 0.0, 1.0 ), sP->rotation * M_PI / 180.0 );
+            SGNODE* target = place.GetRawPtr();
+
+            // bottom side models are flipped about the board's Y axis
+            if( sP->bottom )
+            {
+                IFSG_TRANSFORM flip( target );
+                flip.SetRotation( SGVECTOR( 0.0, 1.0, 0.0 ), M_PI );
+                target = flip.GetRawPtr();
+            }
 
-    if ( !reader.Transfer( m_doc ) )
-    {
-        m_doc->Close();
-        return false;
-    }
+            attachNode( target, mItem->second );
+            ret = true;
+        }
 
-    // are there any shapes to translate?
-    if( reader.NbRootsForTransfer() < 1 )
-        return false;
-    
-    return true;
-}
+        ++sP;
+    }
 
+    std::cout << "* placed " << placements.size() << " models using ";
+    std::cout << models.size() << " distinct models\n";
 
-void printUsage()
-{
-    std::cout << "\n* Usage: oce_vis {-h} {-n} {-d val} {-a val} {-o outputfile} inputfile\n";
-    std::cout << "  -h: if present, produces a hierarchical output employing DEF/USE\n";
-    std::cout << "  -n: if present, calculates surface normals\n";
-    std::cout << "  -d: max. surface deflection (mm), default ";
-    std::cout << USER_PREC << " \n";
-    std::cout << "      range: 0.0001 .. 0.8\n";
-    std::cout << "  -a: max. angular increment (degrees), default ";
-    std::cout << USER_ANGLE*180.0/M_PI << " deg.\n";
-    std::cout << "      range: -45 .. -5 and 5 .. 45 deg\n";
-    std::cout << "  -o: output file; must end in .wrl\n";
-    std::cout << "  inputfile: input model; must be IGES or STEP AP203/214/242\n\n";
+    return ret && 0 == s_cancel;
 }
 
 
@@ -724,68 +2352,86 @@ int main( int argc, const char** argv )
         return -1;
     }
 
-    std::cout << "Processing file: " << args.inputFile << "\n";
+    // only the JSON estimate is written to stdout; anything printed while
+    // the model is loaded and sampled is sent to stderr instead
+    if( args.estimate )
+    {
+        std::string estimate;
+        STDOUT_REDIRECT redirect;
+        DATA data;
+
+        if( !initData( args, data ) || !estimateFile( args, args.inputFile, data, estimate ) )
+            return -1;
+
+        redirect.Restore();
+        std::cout << estimate << std::endl;
+        return 0;
+    }
+
+    if( args.placementFile.empty() )
+    {
+        std::cout << "Processing file: " << args.inputFile << "\n";
+        std::cout << "    compressed: " << args.compressed << "\n";
+    }
+    else
+    {
+        std::cout << "Processing placements: " << args.placementFile << "\n";
+    }
+
     std::cout << "    deflection (mm): " << args.deflection << "\n";
     std::cout << "    angle (deg): " << args.angleIncrement * 180.0 / M_PI << "\n";
     std::cout << "    hierarchy: " << args.useHierarchy << "\n";
     std::cout << "    normals: " << args.useNormals << "\n";
+    std::cout << "    edges: " << args.useEdges << "\n";
+    std::cout << "    merge faces: " << args.mergeFaces << "\n";
+    std::cout << "    occlusion rays: " << args.aoSamples << "\n";
+    std::cout << "    incremental: " << args.incremental << "\n";
+    std::cout << "    keep document: " << args.persistDoc << "\n";
     std::cout << "    output file: " << args.outputFile << "\n";
 
-    DATA data;
-    data.useNorms = args.useNormals;
+    IFSG_TRANSFORM topNode( true, true );
+    std::set< std::string > usedHashes;
+    bool ret = false;
+    bool reuse = args.useHierarchy;
 
-    Handle(XCAFApp_Application) m_app = XCAFApp_Application::GetApplication();
-    m_app->NewDocument( "MDTV-XCAF", data.m_doc );
-    
-    switch( args.format )
+    signal( SIGINT, onInterrupt );
+
+    if( args.placementFile.empty() )
     {
-        case FMT_IGES:
-            data.renderBoth = true;
-            
-            if( !readIGES( data.m_doc, args.inputFile.c_str() ) )
-                return -1;
-            break;
-            
-        case FMT_STEP:
-            if( !readSTEP( data.m_doc, args.inputFile.c_str() ) )
-                return -1;
-            break;
-            
-        default:
-            std::cout << "File is not an IGES or STEP file\n";
-            std::cout << "filename: " << args.inputFile << "\n";
+        DATA data;
+
+        if( !initData( args, data ) )
             return -1;
-            break;
+
+        ret = convertFile( args, args.inputFile, data, topNode.GetRawPtr() );
+        usedHashes = data.usedHashes;
+    }
+    else
+    {
+        // shared models are written once and placed via DEF/USE
+        reuse = true;
+        ret = convertBoard( args, topNode.GetRawPtr(), usedHashes );
     }
-    
-    data.m_assy = XCAFDoc_DocumentTool::ShapeTool( data.m_doc->Main() );
-    data.m_color = XCAFDoc_DocumentTool::ColorTool( data.m_doc->Main() );
 
-    // retrieve all free shapes
-    TDF_LabelSequence frshapes; 
-    data.m_assy->GetFreeShapes( frshapes );
-    
-    int nshapes = frshapes.Length();
-    bool ret = false;
+    signal( SIGINT, SIG_DFL );
 
-    // TBD: create the top level SG node
-    IFSG_TRANSFORM topNode( true );
-    data.scene = topNode.GetRawPtr();
-    int id = 1;
-    
-    while( id <= nshapes )
+    if( 0 != s_cancel )
     {
-        TopoDS_Shape shape = data.m_assy->GetShape( frshapes.Value(id) );
-
-        if ( !shape.IsNull() && processNode( shape, data, data.scene, NULL ) )
-            ret = true;
+        std::cout << "* conversion cancelled\n";
+        topNode.Destroy();
+        return -1;
+    }
 
-        ++id;
-    };
+    if( args.incremental )
+    {
+        std::string cacheDir = args.outputFile;
+        cacheDir.append( ".cache" );
+        pruneCache( cacheDir, usedHashes );
+    }
 
     // on success write out a VRML file
-    if( ret && S3D::WriteVRML( args.outputFile.c_str(), true, data.scene,
-                               args.useHierarchy, true ) )
+    if( ret && S3D::WriteVRML( args.outputFile.c_str(), true, topNode.GetRawPtr(),
+                               reuse, true ) )
     {
         std::cout << "* VRML translation written to '";
         std::cout << args.outputFile.c_str() << "'\n";
@@ -793,9 +2439,14 @@ int main( int argc, const char** argv )
     else
     {
         std::cout << "* could not process input file '";
-        std::cout << args.inputFile.c_str() << "'\n";
+
+        if( args.placementFile.empty() )
+            std::cout << args.inputFile.c_str() << "'\n";
+        else
+            std::cout << args.placementFile.c_str() << "'\n";
     }
 
+    topNode.Destroy();
     return 0;
 }
 
@@ -824,13 +2475,30 @@ bool processFace( const TopoDS_Face& face, DATA& data, SGNODE* parent,
     if( data.renderBoth || !data.hasSolid )
         showTwoSides = true;
 
+    // the triangulation of a face is held by the underlying TShape and does
+    // not include the face location; each located occurrence of the face is
+    // placed via its own transform so that the mesh data can be shared
+    IFSG_TRANSFORM txNode( false );
+    SGNODE* target = parent;
+    TopLoc_Location loc = face.Location();
+
+    if( !loc.IsIdentity() )
+    {
+        txNode.NewNode( parent );
+        setTransform( txNode, loc );
+        target = txNode.GetRawPtr();
+
+        if( NULL != items )
+        {
+            items->push_back( target );
+            items = NULL;
+        }
+    }
+
     if( ashape )
     {
-        if( NULL == S3D::GetSGNodeParent( ashape ) )
-            S3D::AddSGNodeChild( parent, ashape );
-        else
-            S3D::AddSGNodeRef( parent, ashape );
-        
+        attachNode( target, ashape );
+
         if( NULL != items )
             items->push_back( ashape );
 
@@ -840,142 +2508,474 @@ bool processFace( const TopoDS_Face& face, DATA& data, SGNODE* parent,
             id2.append( "b" );
             SGNODE* shapeB = data.GetFace( id2 );
 
-            if( NULL == S3D::GetSGNodeParent( shapeB ) )
-                S3D::AddSGNodeChild( parent, shapeB );
-            else
-                S3D::AddSGNodeRef( parent, shapeB );
+            attachNode( target, shapeB );
 
             if( NULL != items )
                 items->push_back( shapeB );
         }
 
+        if( data.useEdges )
+        {
+            std::string id3 = partID;
+            id3.append( "e" );
+            SGNODE* shapeE = data.GetFace( id3 );
+
+            if( NULL != shapeE )
+            {
+                attachNode( target, shapeE );
+
+                if( NULL != items )
+                    items->push_back( shapeE );
+            }
+        }
+
+        ++data.facesDone;
+        data.Report();
         return true;
     }
 
-    TopLoc_Location loc = face.Location();
+    SGNODE* vface = getFaceSet( face, reverse, data );
+
+    if( NULL == vface )
+    {
+        txNode.Destroy();
+        ++data.facesDone;
+        data.Report();
+        return false;
+    }
+
+    Quantity_Color lcolor;
+    color = getFaceColor( face, data, color, lcolor );
+
+    SGNODE* ocolor = data.GetColor( color );
+
+    // create a SHAPE and attach the color and data,
+    // then attach the shape to the parent and return TRUE
+    IFSG_SHAPE vshape( true );
+    attachNode( vshape.GetRawPtr(), ocolor );
+    attachNode( vshape.GetRawPtr(), vface );
+    vshape.SetParent( target );
+
+    if( !partID.empty() )
+        data.faces.insert( std::pair< std::string,
+            SGNODE* >( partID, vshape.GetRawPtr() ) );
+
+    // The outer surface of an IGES model is indeterminate so
+    // we must render both sides of a surface; the back of a face
+    // is the face set of the opposite orientation.
+    if( showTwoSides )
+    {
+        SGNODE* vface2 = getFaceSet( face, !reverse, data );
+        std::string id2 = partID;
+        id2.append( "b" );
+        IFSG_SHAPE vshape2( true );
+        attachNode( vshape2.GetRawPtr(), ocolor );
+        attachNode( vshape2.GetRawPtr(), vface2 );
+        vshape2.SetParent( target );
+
+        if( !partID.empty() )
+            data.faces.insert( std::pair< std::string,
+                SGNODE* >( id2, vshape2.GetRawPtr() ) );
+    }
+
+    if( data.useEdges )
+    {
+        SGNODE* vlines = processEdges( face, data );
+
+        if( NULL != vlines )
+        {
+            IFSG_SHAPE eshape( true );
+            attachNode( eshape.GetRawPtr(), data.GetEdgeColor() );
+            attachNode( eshape.GetRawPtr(), vlines );
+            eshape.SetParent( target );
+
+            if( !partID.empty() )
+            {
+                std::string id3 = partID;
+                id3.append( "e" );
+                data.faces.insert( std::pair< std::string,
+                    SGNODE* >( id3, eshape.GetRawPtr() ) );
+            }
+        }
+    }
+
+    ++data.facesDone;
+    data.Report();
+    return true;
+}
+
+
+// return the face color if one is assigned, otherwise the inherited color;
+// a face color has precedence over SOLID colors
+Quantity_Color* getFaceColor( const TopoDS_Face& face, DATA& data,
+    Quantity_Color* color, Quantity_Color& lcolor )
+{
+    TDF_Label L;
+
+    if( data.m_color->ShapeTool()->Search( face, L ) )
+    {
+        if( data.m_color->GetColor( L, XCAFDoc_ColorGen, lcolor )
+            || data.m_color->GetColor(L, XCAFDoc_ColorCurv, lcolor )
+            || data.m_color->GetColor(L, XCAFDoc_ColorSurf, lcolor ) )
+            return &lcolor;
+    }
+
+    return color;
+}
+
+
+// return the triangulation of a face, meshing the face if it has no
+// triangulation of the requested deflection; loc is set to the location
+// of the triangulation
+Handle(Poly_Triangulation) meshFace( const TopoDS_Face& face, DATA& data,
+    TopLoc_Location& loc )
+{
     Standard_Boolean isTessellate (Standard_False);
     Handle(Poly_Triangulation) triangulation = BRep_Tool::Triangulation( face, loc );
-    
-    if( triangulation.IsNull() || triangulation->Deflection() > USER_PREC + Precision::Confusion() )
+
+    if( triangulation.IsNull()
+        || triangulation->Deflection() > data.deflection + Precision::Confusion() )
         isTessellate = Standard_True;
-    
-    if (isTessellate) 
+
+    if (isTessellate)
     {
-        BRepMesh_IncrementalMesh IM(face, USER_PREC, Standard_False, USER_ANGLE );
+        BRepMesh_IncrementalMesh IM(face, data.deflection, Standard_False, data.angle );
         triangulation = BRep_Tool::Triangulation( face, loc );
     }
 
+    return triangulation;
+}
+
+
+SGNODE* getFaceSet( const TopoDS_Face& face, bool reverse, DATA& data )
+{
+    // face sets are keyed on the face geometry and the orientation
+    // so that patterned faces are only meshed and stored once
+    const TopoDS_TShape* tshape = face.TShape().operator->();
+    MESHMAP::iterator item = data.meshes.find( MESHKEY( tshape, reverse ) );
+
+    if( item != data.meshes.end() )
+        return item->second.faceSet;
+
+    TopLoc_Location loc;
+    Handle(Poly_Triangulation) triangulation = meshFace( face, data, loc );
+
     if( triangulation.IsNull() == Standard_True )
-        return false;
+        return NULL;
 
-    Quantity_Color lcolor;
+    // the opposite orientation has the same vertices and only
+    // differs in the winding so its coordinates are referenced
+    MESHMAP::iterator other = data.meshes.find( MESHKEY( tshape, !reverse ) );
+    IFSG_FACESET vface( true );
+    IFSG_COORDINDEX coordIdx( vface );
+    SGNODE* coords = NULL;
 
-    // check for a face color; this has precedence over SOLID colors
-    do
+    if( other != data.meshes.end() )
+    {
+        coords = other->second.coords;
+        vface.AddRefNode( coords );
+    }
+    else
     {
-        TDF_Label L;
+        const TColgp_Array1OfPnt& arrPolyNodes = triangulation->Nodes();
+        std::vector< SGPOINT > vertices;
+        vertices.reserve( triangulation->NbNodes() );
 
-        if( data.m_color->ShapeTool()->Search( face, L ) )
+        for(int i = 1; i <= triangulation->NbNodes(); i++)
         {
-            if( data.m_color->GetColor( L, XCAFDoc_ColorGen, lcolor )
-                || data.m_color->GetColor(L, XCAFDoc_ColorCurv, lcolor )
-                || data.m_color->GetColor(L, XCAFDoc_ColorSurf, lcolor ) )
-                color = &lcolor;
+            gp_XYZ v( arrPolyNodes(i).Coord() );
+            vertices.push_back( SGPOINT( v.X(), v.Y(), v.Z() ) );
         }
-    } while( 0 );
 
-    SGNODE* ocolor = data.GetColor( color );
-    
-    // create a SHAPE and attach the color and data,
-    // then attach the shape to the parent and return TRUE
-    IFSG_SHAPE vshape( true );
-    IFSG_FACESET vface( vshape );
-    IFSG_COORDS vcoords( vface );
-    IFSG_COORDINDEX coordIdx( vface );
+        IFSG_COORDS vcoords( vface );
+        vcoords.SetSinglePrecision( true );
+        vcoords.SetCoordsList( std::move( vertices ) );
+        coords = vcoords.GetRawPtr();
+    }
+
+    const Poly_Array1OfTriangle& arrTriangles = triangulation->Triangles();
+    std::vector< int > indices;
+    indices.reserve( 3 * triangulation->NbTriangles() );
+
+    for(int i = 1; i <= triangulation->NbTriangles(); i++)
+    {
+        int a, b, c;
+        arrTriangles( i ).Get( a, b, c );
+        a--;
+
+        if( reverse )
+        {
+            int tmp = b - 1;
+            b = c - 1;
+            c = tmp;
+        } else {
+            b--;
+            c--;
+        }
+
+        indices.push_back( a );
+        indices.push_back( b );
+        indices.push_back( c );
+    }
+
+    coordIdx.SetIndices( std::move( indices ) );
+
+    if( data.useNorms )
+        vface.CalcNormals( NULL );
+
+    MESHITEM mesh;
+    mesh.faceSet = vface.GetRawPtr();
+    mesh.coords = coords;
+    data.meshes.insert( std::pair< MESHKEY, MESHITEM >( MESHKEY( tshape, reverse ), mesh ) );
+
+    return mesh.faceSet;
+}
+
+
+SGNODE* processEdges( const TopoDS_Face& face, DATA& data )
+{
+    // line sets are keyed on the face geometry; the outline is the same
+    // for every occurrence and orientation of the face
+    const TopoDS_TShape* tshape = face.TShape().operator->();
+    LINEMAP::iterator item = data.lines.find( tshape );
+
+    if( item != data.lines.end() )
+        return item->second;
+
+    TopLoc_Location loc;
+    Handle(Poly_Triangulation) triangulation = BRep_Tool::Triangulation( face, loc );
+
+    if( triangulation.IsNull() )
+        return NULL;
+
+    std::vector< SGPOINT > vertices;
+    std::vector< int > indices;
+    addEdges( face, triangulation, loc, NULL, data, vertices, indices );
+
+    SGNODE* vlines = NULL;
+
+    if( !indices.empty() )
+    {
+        IFSG_LINESET eline( true );
+        IFSG_COORDS ecoords( eline );
+        IFSG_COORDINDEX ecoordIdx( eline );
+
+        ecoords.SetSinglePrecision( true );
+        ecoords.SetCoordsList( std::move( vertices ) );
+        ecoordIdx.SetIndices( std::move( indices ) );
+        vlines = eline.GetRawPtr();
+    }
+
+    data.lines.insert( std::pair< const TopoDS_TShape*, SGNODE* >( tshape, vlines ) );
+
+    return vlines;
+}
+
+
+// append the outline of a face to a list of line set vertices and indices;
+// if trsf is not NULL the vertices are transformed
+void addEdges( const TopoDS_Face& face, const Handle(Poly_Triangulation)& triangulation,
+    const TopLoc_Location& loc, const gp_Trsf* trsf, DATA& data,
+    std::vector< SGPOINT >& vertices, std::vector< int >& indices )
+{
+    // the outline is taken from the edge discretizations stored with the
+    // face triangulation so that its vertices coincide with the mesh vertices
+    const TColgp_Array1OfPnt& arrPolyNodes = triangulation->Nodes();
+    std::map< int, int > nodeMap;   // triangulation node -> line set vertex
+    std::map< int, int >::iterator mit;
+    TopExp_Explorer ex;
+
+    for( ex.Init( face, TopAbs_EDGE ); ex.More(); ex.Next() )
+    {
+        const TopoDS_Edge& edge = TopoDS::Edge( ex.Current() );
+
+        // skip the poles and seams; these are not boundaries of the solid
+        if( BRep_Tool::Degenerated( edge ) || BRep_Tool::IsClosed( edge, face ) )
+            continue;
+
+        Handle( Poly_PolygonOnTriangulation ) poly =
+            BRep_Tool::PolygonOnTriangulation( edge, triangulation, loc );
+
+        if( poly.IsNull() || poly->NbNodes() < 2 )
+            continue;
+
+        // an edge is shared by two faces but is only outlined once
+        if( !data.edges.Add( edge ) )
+            continue;
+
+        const TColStd_Array1OfInteger& nodes = poly->Nodes();
+
+        for( int i = nodes.Lower(); i <= nodes.Upper(); ++i )
+        {
+            int node = nodes( i );
+            mit = nodeMap.find( node );
+
+            if( mit == nodeMap.end() )
+            {
+                gp_Pnt v( arrPolyNodes( node ) );
+
+                if( NULL != trsf )
+                    v = v.Transformed( *trsf );
+
+                mit = nodeMap.insert( std::pair< int, int >( node,
+                    (int)vertices.size() ) ).first;
+                vertices.push_back( SGPOINT( v.X(), v.Y(), v.Z() ) );
+            }
+
+            indices.push_back( mit->second );
+        }
+
+        indices.push_back( -1 );
+    }
+
+    return;
+}
+
+
+// convert all faces of a solid into a single face set; the face colors are
+// assigned per vertex so that a multi-colored solid is drawn as one mesh
+bool processMerged( const TopoDS_Shape& shape, DATA& data, SGNODE* parent,
+    Quantity_Color* color )
+{
+    // the merged shapes are keyed on the solid geometry and inherited
+    // color; the solid location is applied by the parent transform
+    MERGEKEY key( shape.TShape().operator->(), color );
+    MERGEMAP::iterator item = data.merged.find( key );
+    TopExp_Explorer ex;
+
+    if( item != data.merged.end() )
+    {
+        attachNode( parent, item->second.faces );
+        attachNode( parent, item->second.lines );
+
+        for( ex.Init( shape, TopAbs_FACE ); ex.More(); ex.Next() )
+            ++data.facesDone;
+
+        data.Report();
+        return true;
+    }
 
-    if( NULL == S3D::GetSGNodeParent( ocolor ) )
-        S3D::AddSGNodeChild( vshape.GetRawPtr(), ocolor );
-    else
-        S3D::AddSGNodeRef( vshape.GetRawPtr(), ocolor );
+    // edges are only shared between faces of the same solid
+    if( data.useEdges )
+        data.edges.Clear();
 
-    const TColgp_Array1OfPnt&    arrPolyNodes = triangulation->Nodes();
-    const Poly_Array1OfTriangle& arrTriangles = triangulation->Triangles();
+    bool showTwoSides = data.renderBoth || !data.hasSolid;
+    TopoDS_Shape solid = shape.Located( TopLoc_Location() );
     std::vector< SGPOINT > vertices;
+    std::vector< SGCOLOR > vcolors;
     std::vector< int > indices;
-    std::vector< int > indices2;
-    gp_Trsf tx;
-
-    for(int i = 1; i <= triangulation->NbNodes(); i++)
-    {
-        gp_XYZ v( arrPolyNodes(i).Coord() );
-        vertices.push_back( SGPOINT( v.X(), v.Y(), v.Z() ) );
-    }
+    std::vector< SGPOINT > lvertices;
+    std::vector< int > lindices;
 
-    for(int i = 1; i <= triangulation->NbTriangles(); i++)
+    for( ex.Init( solid, TopAbs_FACE ); ex.More() && !data.cancelled; ex.Next() )
     {
-        int a, b, c;
-        arrTriangles( i ).Get( a, b, c );
-        a--;
+        const TopoDS_Face& face = TopoDS::Face( ex.Current() );
+        TopLoc_Location loc;
+        Handle(Poly_Triangulation) triangulation = meshFace( face, data, loc );
 
-        if( reverse )
+        if( triangulation.IsNull() )
         {
-            int tmp = b - 1;
-            b = c - 1;
-            c = tmp;
-        } else {
-            b--;
-            c--;
+            ++data.facesDone;
+            data.Report();
+            continue;
         }
 
-        indices.push_back( a );
-        indices.push_back( b );
-        indices.push_back( c );
+        Quantity_Color lcolor;
+        Quantity_Color* fcolor = getFaceColor( face, data, color, lcolor );
+        SGCOLOR vcolor( 0.6, 0.6, 0.6 );
 
-        if( showTwoSides )
+        if( NULL != fcolor )
+            vcolor.SetColor( fcolor->Red(), fcolor->Green(), fcolor->Blue() );
+
+        // the triangulation excludes the face location within the solid
+        gp_Trsf T = loc.Transformation();
+        bool reverse = ( face.Orientation() == TopAbs_REVERSED );
+        const TColgp_Array1OfPnt& arrPolyNodes = triangulation->Nodes();
+        const Poly_Array1OfTriangle& arrTriangles = triangulation->Triangles();
+        int nSides = showTwoSides ? 2 : 1;
+
+        // the back of a two-sided face has its own vertices so that
+        // the calculated normals are not averaged with the front
+        for( int side = 0; side < nSides; ++side )
         {
-            indices2.push_back( b );
-            indices2.push_back( a );
-            indices2.push_back( c );
+            int base = (int)vertices.size();
+
+            for( int i = 1; i <= triangulation->NbNodes(); ++i )
+            {
+                gp_Pnt v = arrPolyNodes( i ).Transformed( T );
+                vertices.push_back( SGPOINT( v.X(), v.Y(), v.Z() ) );
+                vcolors.push_back( vcolor );
+            }
+
+            bool flip = ( side == 0 ) ? reverse : !reverse;
+
+            for( int i = 1; i <= triangulation->NbTriangles(); ++i )
+            {
+                int a, b, c;
+                arrTriangles( i ).Get( a, b, c );
+
+                if( flip )
+                    std::swap( b, c );
+
+                indices.push_back( base + a - 1 );
+                indices.push_back( base + b - 1 );
+                indices.push_back( base + c - 1 );
+            }
         }
-    }
 
-    vcoords.SetCoordsList( vertices.size(), &vertices[0] );
-    coordIdx.SetIndices( indices.size(), &indices[0] );
+        if( data.useEdges )
+            addEdges( face, triangulation, loc, &T, data, lvertices, lindices );
 
-    if( data.useNorms )
-        vface.CalcNormals( NULL );
+        ++data.facesDone;
+        data.Report();
+    }
 
-    vshape.SetParent( parent );
+    if( indices.empty() || data.cancelled )
+        return false;
 
-    if( !partID.empty() )
-        data.faces.insert( std::pair< std::string,
-            SGNODE* >( partID, vshape.GetRawPtr() ) );
-    
-    // The outer surface of an IGES model is indeterminate so
-    // we must render both sides of a surface.
-    if( showTwoSides )
-    {
-        std::string id2 = partID;
-        id2.append( "b" );
-        IFSG_SHAPE vshape2( true );
-        IFSG_FACESET vface2( vshape2 );
-        IFSG_COORDS vcoords2( vface2 );
-        IFSG_COORDINDEX coordIdx2( vface2 );
-        S3D::AddSGNodeRef( vshape2.GetRawPtr(), ocolor );
+    // the occlusion is baked per solid since the merged face set
+    // is shared by every occurrence of the solid
+    if( data.aoSamples > 0 )
+        BakeOcclusion( vertices, indices, vcolors, data.aoSamples, 0 );
+
+    // the face colors are carried by the vertices so the appearance
+    // only supplies the lighting terms of the solid color
+    IFSG_SHAPE vshape( true );
+    attachNode( vshape.GetRawPtr(), data.GetColor( color ) );
+    IFSG_FACESET vface( vshape );
+    IFSG_COORDS vcoords( vface );
+    IFSG_COORDINDEX coordIdx( vface );
+    IFSG_COLORS vcols( vface );
 
-        vcoords2.SetCoordsList( vertices.size(), &vertices[0] );
-        coordIdx2.SetIndices( indices2.size(), &indices2[0] );
+    vcoords.SetCoordsList( std::move( vertices ) );
+    coordIdx.SetIndices( std::move( indices ) );
+    vcols.SetColorList( std::move( vcolors ) );
 
-        if( data.useNorms )
-            vface2.CalcNormals( NULL );
+    if( data.useNorms )
+        vface.CalcNormals( NULL );
 
-        vshape2.SetParent( parent );
+    MERGEITEM mitem;
+    mitem.faces = vshape.GetRawPtr();
+    mitem.lines = NULL;
 
-        if( !partID.empty() )
-            data.faces.insert( std::pair< std::string,
-                SGNODE* >( id2, vshape2.GetRawPtr() ) );
+    if( !lindices.empty() )
+    {
+        IFSG_SHAPE eshape( true );
+        attachNode( eshape.GetRawPtr(), data.GetEdgeColor() );
+        IFSG_LINESET eline( eshape );
+        IFSG_COORDS ecoords( eline );
+        IFSG_COORDINDEX ecoordIdx( eline );
+
+        ecoords.SetSinglePrecision( true );
+        ecoords.SetCoordsList( std::move( lvertices ) );
+        ecoordIdx.SetIndices( std::move( lindices ) );
+        mitem.lines = eshape.GetRawPtr();
     }
 
+    data.merged.insert( std::pair< MERGEKEY, MERGEITEM >( key, mitem ) );
+    attachNode( parent, mitem.faces );
+    attachNode( parent, mitem.lines );
+
     return true;
 }
 
@@ -985,7 +2985,12 @@ enum ARGSTATE
     ARGNONE = 0,    // default machine state
     ARGDEF,         // need to read deflection
     ARGANG,         // need to read angle
-    ARGOUT          // need to read output filename (MUST end in '.wrl')
+    ARGOUT,         // need to read output filename (MUST end in '.wrl')
+    ARGBRD,         // need to read placement filename
+    ARGINC,         // need to read an include pattern
+    ARGEXC,         // need to read an exclude pattern
+    ARGLVL,         // need to read the max. assembly depth
+    ARGRAY          // need to read the number of occlusion rays
 };
 
 #define hasInput 1
@@ -994,24 +2999,42 @@ enum ARGSTATE
 #define hasDef   8
 #define hasAng   16
 #define hasOut   32
-#define hasAll   63
+#define hasEdges 64
+#define hasIncr  128
+#define hasDoc   256
+#define hasBoard 512
+#define hasDepth 1024
+#define hasMerge 2048
+#define hasRays  4096
+#define hasAll   8191
 
 bool processTok( const char* tok, PARAMS& args, ARGSTATE& state,
-    unsigned char& flags );
+    unsigned int& flags );
 
 bool processArgs( int argc, const char** argv, PARAMS& args )
 {
     ARGSTATE state = ARGNONE;
     int argnum = 1;
-    unsigned char flags = 0;
+    unsigned int flags = 0;
 
     args.outputFile.clear();
     args.inputFile.clear();
+    args.placementFile.clear();
+    args.includes.clear();
+    args.excludes.clear();
+    args.maxDepth = -1;
+    args.estimate = false;
     args.deflection = USER_PREC;
     args.angleIncrement = USER_ANGLE;
     args.useHierarchy = false;
     args.useNormals = false;
+    args.useEdges = false;
+    args.mergeFaces = false;
+    args.aoSamples = 0;
+    args.incremental = false;
+    args.persistDoc = false;
     args.format = FMT_NONE;
+    args.compressed = false;
 
     if( argc <= argnum )
     {
@@ -1037,8 +3060,20 @@ bool processArgs( int argc, const char** argv, PARAMS& args )
         std::cout << std::endl;
     }
 
-    if( args.inputFile.empty() )
+    if( !args.inputFile.empty() && !args.placementFile.empty() )
+    {
+        std::cout << "* an input file and a placement file may not both be given\n";
+        return false;
+    }
+
+    if( args.inputFile.empty() && args.placementFile.empty() )
+        return false;
+
+    if( args.estimate && args.inputFile.empty() )
+    {
+        std::cout << "* --estimate requires an input file\n";
         return false;
+    }
 
     if( args.outputFile.empty() )
         args.outputFile = DEFAULT_OUT;
@@ -1050,25 +3085,46 @@ bool processArgs( int argc, const char** argv, PARAMS& args )
         return false;
     }
 
-    args.format = fileType( args.inputFile.c_str() );
+    if( !args.outputFile.compare( args.placementFile ) )
+    {
+        std::cout << "* placement and output files are the same\n";
+        args.outputFile.clear();
+        return false;
+    }
+
+    if( !args.inputFile.empty() )
+    {
+        args.compressed = isCompressed( args.inputFile.c_str() );
+        args.format = fileType( args.inputFile.c_str() );
+    }
+
     return true;
 }
 
 bool processDef( const char* tok, PARAMS& args, ARGSTATE& state,
-    unsigned char& flags );
+    unsigned int& flags );
 
 bool processAng( const char* tok, PARAMS& args, ARGSTATE& state,
-    unsigned char& flags );
+    unsigned int& flags );
 
 bool processOut( const char* tok, PARAMS& args, ARGSTATE& state,
-    unsigned char& flags );
+    unsigned int& flags );
 
 bool processOpt( const char* tok, PARAMS& args, ARGSTATE& state,
-    unsigned char& flags );
+    unsigned int& flags );
+
+bool processBrd( const char* tok, PARAMS& args, ARGSTATE& state,
+    unsigned int& flags );
+
+bool processLvl( const char* tok, PARAMS& args, ARGSTATE& state,
+    unsigned int& flags );
+
+bool processRay( const char* tok, PARAMS& args, ARGSTATE& state,
+    unsigned int& flags );
 
 
 bool processTok( const char* tok, PARAMS& args, ARGSTATE& state,
-    unsigned char& flags )
+    unsigned int& flags )
 {
     switch( state )
     {
@@ -1109,6 +3165,34 @@ bool processTok( const char* tok, PARAMS& args, ARGSTATE& state,
 
             break;
 
+        case ARGBRD:
+            if( !processBrd( tok, args, state, flags ) )
+                return false;
+
+            break;
+
+        case ARGINC:
+            args.includes.push_back( tok );
+            state = ARGNONE;
+            break;
+
+        case ARGEXC:
+            args.excludes.push_back( tok );
+            state = ARGNONE;
+            break;
+
+        case ARGLVL:
+            if( !processLvl( tok, args, state, flags ) )
+                return false;
+
+            break;
+
+        case ARGRAY:
+            if( !processRay( tok, args, state, flags ) )
+                return false;
+
+            break;
+
         default:
             return false;
             break;
@@ -1119,7 +3203,7 @@ bool processTok( const char* tok, PARAMS& args, ARGSTATE& state,
 
 
 bool processDef( const char* tok, PARAMS& args, ARGSTATE& state,
-    unsigned char& flags )
+    unsigned int& flags )
 {
     if( (flags & hasDef) )
     {
@@ -1147,7 +3231,7 @@ bool processDef( const char* tok, PARAMS& args, ARGSTATE& state,
 
 
 bool processAng( const char* tok, PARAMS& args, ARGSTATE& state,
-    unsigned char& flags )
+    unsigned int& flags )
 {
     if( (flags & hasAng) )
     {
@@ -1177,7 +3261,7 @@ bool processAng( const char* tok, PARAMS& args, ARGSTATE& state,
 
 
 bool processOut( const char* tok, PARAMS& args, ARGSTATE& state,
-    unsigned char& flags )
+    unsigned int& flags )
 {
     if( (flags & hasOut) )
     {
@@ -1201,11 +3285,96 @@ bool processOut( const char* tok, PARAMS& args, ARGSTATE& state,
 }
 
 
+bool processBrd( const char* tok, PARAMS& args, ARGSTATE& state,
+    unsigned int& flags )
+{
+    if( (flags & hasBoard) )
+    {
+        std::cout << "* duplicate placement file definitions\n";
+        return false;
+    }
+
+    args.placementFile = tok;
+    flags |= hasBoard;
+    state = ARGNONE;
+    return true;
+}
+
+
+bool processLvl( const char* tok, PARAMS& args, ARGSTATE& state,
+    unsigned int& flags )
+{
+    if( (flags & hasDepth) )
+    {
+        std::cout << "* duplicate assembly depth definition\n";
+        return false;
+    }
+
+    int depth = -1;
+
+    std::istringstream istr;
+    istr.str( tok );
+    istr >> depth;
+
+    if( istr.fail() || depth < 0 )
+    {
+        std::cout << "* invalid assembly depth: '" << tok << "'\n";
+        return false;
+    }
+
+    args.maxDepth = depth;
+    flags |= hasDepth;
+    state = ARGNONE;
+    return true;
+}
+
+
+bool processRay( const char* tok, PARAMS& args, ARGSTATE& state,
+    unsigned int& flags )
+{
+    if( (flags & hasRays) )
+    {
+        std::cout << "* duplicate occlusion ray definition\n";
+        return false;
+    }
+
+    int rays = 0;
+
+    std::istringstream istr;
+    istr.str( tok );
+    istr >> rays;
+
+    if( istr.fail() || rays < 1 || rays > 1024 )
+    {
+        std::cout << "* invalid number of occlusion rays: '" << tok << "'\n";
+        return false;
+    }
+
+    args.aoSamples = rays;
+    flags |= hasRays;
+    state = ARGNONE;
+    return true;
+}
+
+
 bool processOpt( const char* tok, PARAMS& args, ARGSTATE& state,
-    unsigned char& flags )
+    unsigned int& flags )
 {
     switch( tok[1] )
     {
+        case '-':
+            if( !strcmp( tok, "--estimate" ) )
+            {
+                args.estimate = true;
+                state = ARGNONE;
+            }
+            else
+            {
+                std::cout << "* Unexpected option: '" << tok << "'\n";
+                return false;
+            }
+            break;
+
         case 'h':
             if( tok[2] == 0 )
             {
@@ -1246,6 +3415,86 @@ bool processOpt( const char* tok, PARAMS& args, ARGSTATE& state,
             }
             break;
 
+        case 'e':
+            if( tok[2] == 0 )
+            {
+                if( (flags & hasEdges) )
+                {
+                    std::cout << "* double of switch '-e'\n";
+                    return false;
+                }
+
+                args.useEdges = true;
+                state = ARGNONE;
+                flags |= hasEdges;
+            }
+            else
+            {
+                std::cout << "* unexpected switch + value: '";
+                std::cout << tok << "'\n";
+            }
+            break;
+
+        case 'c':
+            if( tok[2] == 0 )
+            {
+                if( (flags & hasMerge) )
+                {
+                    std::cout << "* double of switch '-c'\n";
+                    return false;
+                }
+
+                args.mergeFaces = true;
+                state = ARGNONE;
+                flags |= hasMerge;
+            }
+            else
+            {
+                std::cout << "* unexpected switch + value: '";
+                std::cout << tok << "'\n";
+            }
+            break;
+
+        case 'i':
+            if( tok[2] == 0 )
+            {
+                if( (flags & hasIncr) )
+                {
+                    std::cout << "* double of switch '-i'\n";
+                    return false;
+                }
+
+                args.incremental = true;
+                state = ARGNONE;
+                flags |= hasIncr;
+            }
+            else
+            {
+                std::cout << "* unexpected switch + value: '";
+                std::cout << tok << "'\n";
+            }
+            break;
+
+        case 'k':
+            if( tok[2] == 0 )
+            {
+                if( (flags & hasDoc) )
+                {
+                    std::cout << "* double of switch '-k'\n";
+                    return false;
+                }
+
+                args.persistDoc = true;
+                state = ARGNONE;
+                flags |= hasDoc;
+            }
+            else
+            {
+                std::cout << "* unexpected switch + value: '";
+                std::cout << tok << "'\n";
+            }
+            break;
+
         case 'd':
             if( tok[2] == 0 )
             {
@@ -1282,6 +3531,74 @@ bool processOpt( const char* tok, PARAMS& args, ARGSTATE& state,
             }
             break;
 
+        case 's':
+            if( tok[2] == 0 )
+                state = ARGINC;
+            else
+                args.includes.push_back( &tok[2] );
+            break;
+
+        case 'x':
+            if( tok[2] == 0 )
+                state = ARGEXC;
+            else
+                args.excludes.push_back( &tok[2] );
+            break;
+
+        case 'l':
+            if( tok[2] == 0 )
+            {
+                if( (flags & hasDepth) )
+                {
+                    std::cout << "* double of switch '-l'\n";
+                    return false;
+                }
+
+                state = ARGLVL;
+            }
+            else
+            {
+                if( !processLvl( &tok[2], args, state, flags ) )
+                    return false;
+            }
+            break;
+
+        case 'r':
+            if( tok[2] == 0 )
+            {
+                if( (flags & hasRays) )
+                {
+                    std::cout << "* double of switch '-r'\n";
+                    return false;
+                }
+
+                state = ARGRAY;
+            }
+            else
+            {
+                if( !processRay( &tok[2], args, state, flags ) )
+                    return false;
+            }
+            break;
+
+        case 'b':
+            if( tok[2] == 0 )
+            {
+                if( (flags & hasBoard) )
+                {
+                    std::cout << "* double of switch '-b'\n";
+                    return false;
+                }
+
+                state = ARGBRD;
+            }
+            else
+            {
+                if( !processBrd( &tok[2], args, state, flags ) )
+                    return false;
+            }
+            break;
+
         case 'o':
             if( tok[2] == 0 )
             {
@@ -86,6 +86,23 @@ typedef struct
 } SMESH;
 
 
+/// Line segment structure used to outline a model (feature edges).
+/// CONDITIONS:
+///     m_LineIdx holds pairs of indices; each pair is a line segment
+///     any m_LineIdx must be an index of m_Positions
+///     m_MaterialIdx must be an existent material index stored in the parent model;
+///     lines are unlit so renderers should use the material's m_Emissive color
+/// m_Positions units are the same as SMESH::m_Positions
+typedef struct
+{
+    unsigned int    m_VertexSize;   ///< Number of vertex in the array
+    SFVEC3F        *m_Positions;    ///< Vertex position array
+    unsigned int    m_LineIdxSize;  ///< Number of elements of the m_LineIdx array
+    unsigned int   *m_LineIdx;      ///< Line segment indexes (2 per segment)
+    unsigned int    m_MaterialIdx;  ///< Material Index to be used in this line set
+} SLINESET;
+
+
 /// Store the a model based on meshes and materials
 typedef struct
 {
@@ -94,6 +111,9 @@ typedef struct
 
     unsigned int    m_MaterialsSize;    ///< Number of materials in the material array
     SMATERIAL      *m_Materials;        ///< The materials list of this model
+
+    unsigned int    m_LineSetsSize;     ///< Number of line sets in the array
+    SLINESET       *m_LineSets;         ///< The feature edges of this model; can be NULL
 } S3DMODEL;
 
 #endif // C3DMODEL_H
@@ -38,6 +38,38 @@ class SCENEGRAPH;
 struct S3D_INFO;
 struct S3D_POINT;
 
+
+/**
+ * Struct SGSTATS
+ * summarizes the content and memory use of a scene graph. Counts of
+ * instances include each occurrence of a node reached via a reference;
+ * unique counts include each node once. Memory is the capacity held by
+ * the containers of each node; the memory of hash tables is estimated.
+ */
+struct SGSTATS
+{
+    size_t nodes[S3D::SGTYPE_END];  // unique nodes of each type
+    size_t bytes[S3D::SGTYPE_END];  // memory held by the unique nodes of each type
+
+    size_t uniqueNodes;         // nodes reached, each counted once
+    size_t instances;           // nodes reached, each counted per occurrence
+    size_t references;          // occurrences of nodes reached via a reference
+
+    size_t vertices;            // vertices of all instances
+    size_t uniqueVertices;      // vertices of unique coordinate nodes
+    size_t indices;             // coordinate indices of all instances
+    size_t uniqueIndices;       // coordinate indices of unique index nodes
+    size_t triangles;           // face set triangles of all instances
+    size_t uniqueTriangles;     // face set triangles of unique index nodes
+
+    size_t nodeBytes;           // node objects including allocation headers
+    size_t linkBytes;           // child, reference and back-pointer containers
+    size_t nameBytes;           // user assigned names
+    size_t dataBytes;           // coordinate, normal, color and index lists
+    size_t totalBytes;          // sum of the above
+};
+
+
 namespace S3D
 {
     /**
@@ -52,6 +84,30 @@ namespace S3D
     SGLIB_API SGNODE* GetSGNodeParent( SGNODE* aNode );
     SGLIB_API bool AddSGNodeRef( SGNODE* aParent, SGNODE* aChild );
     SGLIB_API bool AddSGNodeChild( SGNODE* aParent, SGNODE* aChild );
+
+    /**
+     * Functions GraftSGNodeChild and GraftSGNodeRef
+     * link a tree built on a worker thread to a node of a shared scene graph.
+     * Independent scene graphs (trees holding no links to nodes outside of
+     * themselves) may be created, read, written and destroyed concurrently
+     * on different threads. GraftSGNodeChild() adds the top node of such a
+     * tree, which must have no parent, as a child of aParent. GraftSGNodeRef()
+     * adds a reference from aParent to aNode, which must already have a parent;
+     * a tree under construction may thus refer to shared nodes such as materials.
+     *
+     * Grafts are synchronized with each other only. While grafts are in
+     * progress the shared scene graph must not otherwise be modified, read or
+     * written, and a tree holding references made via GraftSGNodeRef() must
+     * not be destroyed. Once grafted, a tree is part of the shared scene graph
+     * and must no longer be modified by its worker. A graft discards the
+     * bounds cached by the nodes holding aParent (see GetBounds()); bounds of
+     * the shared scene graph should therefore be retrieved or written only once
+     * grafting is complete.
+     *
+     * @return true on success; false if the nodes may not be linked
+     */
+    SGLIB_API bool GraftSGNodeChild( SGNODE* aParent, SGNODE* aChild );
+    SGLIB_API bool GraftSGNodeRef( SGNODE* aParent, SGNODE* aNode );
     SGLIB_API void AssociateSGNodeWrapper( SGNODE* aObject, SGNODE** aRefPtr );
 
     /**
@@ -66,7 +122,8 @@ namespace S3D
      *
      * @param aFileName is the name of the file to write
      * @param overwrite must be set to true to overwrite an existing file
-     * @param aNode is any node within the node tree which is to be written
+     * @param aNode is any node within the node tree which is to be written;
+     * the tree is not modified so it may be read or written by other threads
      * @return true on success
      */
     SGLIB_API bool WriteCache( const char* aFileName, bool overwrite, SGNODE* aNode,
@@ -79,7 +136,8 @@ namespace S3D
      * @param aFileName is the name of the binary cache file to be read
      * @return NULL on failure, on success a pointer to the top level SCENEGRAPH node;
      * if desired this node can be associated with an IFSG_TRANSFORM wrapper via
-     * the IFSG_TRANSFORM::Attach() function.
+     * the IFSG_TRANSFORM::Attach() function. The node owns a memory arena holding
+     * all nodes of the tree; see IFSG_TRANSFORM::IFSG_TRANSFORM().
      */
     SGLIB_API SGNODE* ReadCache( const char* aFileName, void* aPluginMgr,
         bool (*aTagCheck)( const char*, void* ) );
@@ -92,6 +150,10 @@ namespace S3D
      * @param overwrite should be set to true to overwrite an existing VRML file
      * @param aTopNode is a pointer to a SCENEGRAPH object representing the VRML scene
      * @param reuse should be set to true to make use of VRML DEF/USE features
+     * @param renameNodes should be set to true to give the nodes unique names
+     * within the file; the names are generated for the file and the nodes
+     * themselves are not renamed. The scene graph is not modified so it may
+     * be read or written by other threads.
      * @return true on success
      */
     SGLIB_API bool WriteVRML( const char* filename, bool overwrite, SGNODE* aTopNode,
@@ -99,23 +161,25 @@ namespace S3D
 
     // NOTE: The following functions are used in combination to create a VRML
     // assembly which may use various instances of each SG* representation of a module.
+    // Node names are drawn from a naming context owned by the top level node of each
+    // scene graph so that independent scene graphs may be written concurrently.
     // A typical use case would be:
-    // 1. invoke 'ResetNodeIndex()' to reset the global node name indices
-    // 2. for each model pointer provided by 'S3DCACHE->Load()', invoke 'RenameNodes()' once;
-    //    this ensures that all nodes have a unique name to present to the final output file.
-    //    Internally, RenameNodes() will only rename the given node and all Child subnodes;
-    //    nodes which are only referenced will not be renamed. Using the pointer supplied
-    //    by 'S3DCACHE->Load()' ensures that all nodes but the returned node (top node) are
-    //    children of at least one node, so all nodes are given unique names.
-    // 3. if SG* trees are created independently of S3DCACHE->Load() the user must invoke
-    //    RenameNodes() as appropriate to ensure that all nodes have a unique name
+    // 1. invoke 'ResetNodeIndex()' on the top level assembly node to reset its node
+    //    name indices
+    // 2. (optional) for each model pointer provided by 'S3DCACHE->Load()', invoke
+    //    'RenameNodes()'; models are also renamed when they are reached by reference
+    //    in step 6.
+    // 3. if SG* trees are created independently of S3DCACHE->Load() they are named
+    //    in the same manner once they are referenced by the assembly
     // 4. create an assembly structure by creating new IFSG_TRANSFORM nodes as appropriate
     //    for each instance of a component; the component base model as returned by
     //    S3DCACHE->Load() may be added to these IFSG_TRANSFORM nodes via 'AddRefNode()';
     //    set the offset, rotation, etc of the IFSG_TRANSFORM node to ensure correct
     // 5. Ensure that all new IFSG_TRANSFORM nodes are placed as child nodes within a
     //    top level IFSG_TRANSFORM node in preparation for final node naming and output
-    // 6. Invoke RenameNodes() on the top level assembly node
+    // 6. Invoke RenameNodes() on the top level assembly node; this renames the
+    //    node, its Child subnodes and every referenced node which has not already
+    //    been renamed since the last ResetNodeIndex() so that all names are unique
     // 7. Invoke WriteVRML() as normal, with renameNodes = false, to write the entire assembly
     //    structure to a single VRML file
     // 8. Clean up by deleting any extra IFSG_TRANSFORM wrappers and their underlying SG*
@@ -123,7 +187,7 @@ namespace S3D
 
     /**
      * Function ResetNodeIndex
-     * resets the global SG* class indices
+     * resets the node name indices of the scene graph holding the given node
      *
      * @param aNode may be any valid SGNODE
      */
@@ -131,8 +195,9 @@ namespace S3D
 
     /**
      * Function RenameNodes
-     * renames a node and all children nodes based on the current
-     * values of the global SG* class indices
+     * renames a node, all children nodes and all referenced nodes not yet
+     * renamed based on the current node name indices of the scene graph
+     * holding the given node
      *
      * @param aNode is a top level node
      */
@@ -146,8 +211,36 @@ namespace S3D
      */
     SGLIB_API void DestroyNode( SGNODE* aNode );
 
+    /**
+     * Function GetStats
+     * returns node counts, geometry counts and memory use of the scene
+     * graph beneath aNode, following references
+     *
+     * @param aNode is the node at which to start; it is not modified
+     * @return the statistics; all values are 0 if aNode is NULL
+     */
+    SGLIB_API SGSTATS GetStats( SGNODE* aNode );
+
+    /**
+     * Function GetBounds
+     * retrieves the axis aligned bounds of the geometry beneath aNode,
+     * following references. The bounds of a transform node include its
+     * own transform and thus enclose the S3DMODEL created by GetModel().
+     * The bounds are cached by the scene graph and are recomputed only
+     * after its geometry or transforms change.
+     *
+     * @param aNode is the node at which to start; it is not modified
+     * @param aMin receives the lower corner of the bounds
+     * @param aMax receives the upper corner of the bounds
+     * @return true on success; false if aNode is NULL or holds no geometry
+     */
+    SGLIB_API bool GetBounds( SGNODE* aNode, SGPOINT& aMin, SGPOINT& aMax );
+
     // NOTE: The following functions facilitate the creation and destruction
-    // of data structures for rendering
+    // of data structures for rendering. GetModel(), like GetStats(), GetBounds(),
+    // WriteVRML() and WriteCache(), does not modify the scene graph; any number of
+    // threads may invoke these functions on one scene graph at once provided that
+    // no thread modifies the scene graph meanwhile.
 
     /**
      * Function GetModel
@@ -31,6 +31,7 @@
 #define IFSG_COLORS_H
 
 #include <cstdlib>
+#include <vector>
 #include "plugins/3dapi/ifsg_node.h"
 
 
@@ -51,6 +52,7 @@ public:
 
     bool GetColorList( size_t& aListSize, SGCOLOR*& aColorList );
     bool SetColorList( size_t aListSize, const SGCOLOR* aColorList );
+    bool SetColorList( std::vector< SGCOLOR >&& aColorList );
     bool AddColor( double aRedValue, double aGreenValue, double aBlueValue );
     bool AddColor( const SGCOLOR& aColor );
 };
@@ -30,6 +30,7 @@
 #ifndef IFSG_COORDS_H
 #define IFSG_COORDS_H
 
+#include <vector>
 #include "plugins/3dapi/ifsg_node.h"
 
 
@@ -48,8 +49,17 @@ public:
     bool NewNode( SGNODE* aParent );
     bool NewNode( IFSG_NODE& aParent );
 
+    /**
+     * Function SetSinglePrecision
+     * selects single precision storage of the coordinates; coordinates
+     * are always passed in double precision and are converted on entry.
+     * GetCoordsList() returns the node to double precision storage.
+     */
+    bool SetSinglePrecision( bool aSingle );
+
     bool GetCoordsList( size_t& aListSize, SGPOINT*& aCoordsList );
     bool SetCoordsList( size_t aListSize, const SGPOINT* aCoordsList );
+    bool SetCoordsList( std::vector< SGPOINT >&& aCoordsList );
     bool AddCoord( double aXValue, double aYValue, double aZValue );
     bool AddCoord( const SGPOINT& aPoint );
 };
@@ -30,6 +30,7 @@
 #ifndef IFSG_INDEX_H
 #define IFSG_INDEX_H
 
+#include <vector>
 #include "plugins/3dapi/ifsg_node.h"
 
 
@@ -57,6 +58,12 @@ public:
      */
     bool SetIndices( size_t nIndices, int* aIndexList );
 
+    /**
+     * Function SetIndices
+     * takes over the given index data without copying it.
+     */
+    bool SetIndices( std::vector< int >&& aIndexList );
+
 
     /**
      * Function AddIndex
@@ -30,6 +30,7 @@
 #ifndef IFSG_NORMALS_H
 #define IFSG_NORMALS_H
 
+#include <vector>
 #include "plugins/3dapi/ifsg_node.h"
 
 
@@ -48,8 +49,17 @@ public:
     bool NewNode( SGNODE* aParent );
     bool NewNode( IFSG_NODE& aParent );
 
+    /**
+     * Function SetSinglePrecision
+     * selects single precision storage of the normals; normals are
+     * always passed in double precision and are converted on entry.
+     * GetNormalList() returns the node to double precision storage.
+     */
+    bool SetSinglePrecision( bool aSingle );
+
     bool GetNormalList( size_t& aListSize, SGVECTOR*& aNormalList );
     bool SetNormalList( size_t aListSize, const SGVECTOR* aNormalList );
+    bool SetNormalList( std::vector< SGVECTOR >&& aNormalList );
     bool AddNormal( double aXValue, double aYValue, double aZValue );
     bool AddNormal( const SGVECTOR& aNormal );
 };
@@ -40,7 +40,16 @@
 class SGLIB_API IFSG_TRANSFORM : public IFSG_NODE
 {
 public:
-    IFSG_TRANSFORM( bool create );
+    /**
+     * Constructor IFSG_TRANSFORM
+     * creates a new top level transform if create is true; if aUseArena
+     * is also true then the transform owns a memory arena from which all
+     * nodes subsequently created beneath it are allocated. Deleting such a
+     * transform releases all nodes of the arena at once; any node allocated
+     * from the arena is destroyed at that time even if it has since been
+     * moved to another scene graph.
+     */
+    IFSG_TRANSFORM( bool create, bool aUseArena = false );
     IFSG_TRANSFORM( SGNODE* aParent );
     // note: IFSG_TRANSFORM( IFSG_NODE& aParent ) does not exist
     // since a transform may own another transform and that construct
@@ -42,6 +42,7 @@ namespace S3D
         SGTYPE_COORDINDEX,
         SGTYPE_NORMALS,
         SGTYPE_SHAPE,
+        SGTYPE_LINESET,
         SGTYPE_END
     };
 };
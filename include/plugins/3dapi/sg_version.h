@@ -31,7 +31,7 @@
 #define SG_VERSION_H
 
 #define KICADSG_VERSION_MAJOR         2
-#define KICADSG_VERSION_MINOR         0
+#define KICADSG_VERSION_MINOR         1
 #define KICADSG_VERSION_PATCH         0
 #define KICADSG_VERSION_REVISION      0
 
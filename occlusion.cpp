@@ -0,0 +1,467 @@
+/*
+ * This program source code file is part of oce_vis, a STEP/IGES
+ * to VRML2 converter.
+ *
+ * Copyright (C) 2016 Cirilo Bernardo <cirilo.bernardo@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <cmath>
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <system_error>
+#include <thread>
+
+#include "occlusion.h"
+
+// range of the occlusion rays as a fraction of the bounding box diagonal
+#define OCC_RANGE (0.25)
+
+// offset of the ray origins as a fraction of the bounding box diagonal
+#define OCC_OFFSET (1.0e-5)
+
+// brightness of a fully occluded vertex
+#define OCC_FLOOR (0.2)
+
+// max. number of triangles in a BVH leaf
+#define BVH_LEAF 4
+
+// max. depth of the BVH traversal stack
+#define BVH_STACK 64
+
+// vertices processed by a thread at a time
+#define OCC_CHUNK 256
+
+
+namespace
+{
+
+struct BVHNODE
+{
+    double lower[3];    // bounding box of the triangles
+    double upper[3];
+    int    first;       // first triangle of a leaf or right child of a branch
+    int    count;       // number of triangles of a leaf; 0 for a branch
+};
+
+
+class OCCLUDER
+{
+public:
+    OCCLUDER( const std::vector< SGPOINT >& aVertices, const std::vector< int >& aIndices );
+
+    // return true if the ray hits a triangle at a distance 0 < t < aRange
+    bool Hit( const double* aOrigin, const double* aDir, double aRange ) const;
+
+private:
+    int build( int aFirst, int aCount, std::vector< double >& aCentroids );
+    bool hitTriangle( int aTriangle, const double* aOrigin, const double* aDir,
+        double aRange ) const;
+
+    const std::vector< SGPOINT >& m_vertices;
+    const std::vector< int >& m_indices;
+    std::vector< int > m_triangles;     // triangle order referenced by the leaves
+    std::vector< BVHNODE > m_nodes;     // left child of a branch is the next node
+};
+
+
+OCCLUDER::OCCLUDER( const std::vector< SGPOINT >& aVertices,
+    const std::vector< int >& aIndices ) :
+    m_vertices( aVertices ), m_indices( aIndices )
+{
+    int nTris = (int)( aIndices.size() / 3 );
+    std::vector< double > centroids( nTris * 3 );
+
+    m_triangles.resize( nTris );
+
+    for( int i = 0; i < nTris; ++i )
+    {
+        const SGPOINT& p0 = aVertices[aIndices[i * 3]];
+        const SGPOINT& p1 = aVertices[aIndices[i * 3 + 1]];
+        const SGPOINT& p2 = aVertices[aIndices[i * 3 + 2]];
+
+        m_triangles[i] = i;
+        centroids[i * 3] = ( p0.x + p1.x + p2.x ) / 3.0;
+        centroids[i * 3 + 1] = ( p0.y + p1.y + p2.y ) / 3.0;
+        centroids[i * 3 + 2] = ( p0.z + p1.z + p2.z ) / 3.0;
+    }
+
+    m_nodes.reserve( 2 * nTris / BVH_LEAF + 1 );
+
+    if( nTris > 0 )
+        build( 0, nTris, centroids );
+}
+
+
+// build the subtree holding m_triangles[aFirst .. aFirst + aCount - 1] by
+// splitting at the median centroid along the longest axis
+int OCCLUDER::build( int aFirst, int aCount, std::vector< double >& aCentroids )
+{
+    int idx = (int)m_nodes.size();
+    m_nodes.push_back( BVHNODE() );
+
+    BVHNODE node;
+    double clower[3];
+    double cupper[3];
+
+    for( int j = 0; j < 3; ++j )
+    {
+        node.lower[j] = clower[j] = HUGE_VAL;
+        node.upper[j] = cupper[j] = -HUGE_VAL;
+    }
+
+    for( int i = aFirst; i < aFirst + aCount; ++i )
+    {
+        int tri = m_triangles[i];
+
+        for( int k = 0; k < 3; ++k )
+        {
+            const SGPOINT& p = m_vertices[m_indices[tri * 3 + k]];
+            double v[3] = { p.x, p.y, p.z };
+
+            for( int j = 0; j < 3; ++j )
+            {
+                node.lower[j] = std::min( node.lower[j], v[j] );
+                node.upper[j] = std::max( node.upper[j], v[j] );
+            }
+        }
+
+        for( int j = 0; j < 3; ++j )
+        {
+            clower[j] = std::min( clower[j], aCentroids[tri * 3 + j] );
+            cupper[j] = std::max( cupper[j], aCentroids[tri * 3 + j] );
+        }
+    }
+
+    int axis = 0;
+
+    for( int j = 1; j < 3; ++j )
+    {
+        if( cupper[j] - clower[j] > cupper[axis] - clower[axis] )
+            axis = j;
+    }
+
+    // coincident centroids cannot be split
+    if( aCount <= BVH_LEAF || cupper[axis] - clower[axis] <= 0.0 )
+    {
+        node.first = aFirst;
+        node.count = aCount;
+        m_nodes[idx] = node;
+        return idx;
+    }
+
+    int half = aCount / 2;
+    std::vector< int >::iterator start = m_triangles.begin() + aFirst;
+
+    std::nth_element( start, start + half, start + aCount,
+        [&]( int a, int b ) { return aCentroids[a * 3 + axis] < aCentroids[b * 3 + axis]; } );
+
+    build( aFirst, half, aCentroids );
+    node.first = build( aFirst + half, aCount - half, aCentroids );
+    node.count = 0;
+    m_nodes[idx] = node;
+
+    return idx;
+}
+
+
+// Moller-Trumbore ray/triangle intersection
+bool OCCLUDER::hitTriangle( int aTriangle, const double* aOrigin, const double* aDir,
+    double aRange ) const
+{
+    const SGPOINT& p0 = m_vertices[m_indices[aTriangle * 3]];
+    const SGPOINT& p1 = m_vertices[m_indices[aTriangle * 3 + 1]];
+    const SGPOINT& p2 = m_vertices[m_indices[aTriangle * 3 + 2]];
+
+    double e1[3] = { p1.x - p0.x, p1.y - p0.y, p1.z - p0.z };
+    double e2[3] = { p2.x - p0.x, p2.y - p0.y, p2.z - p0.z };
+    double pv[3] = { aDir[1] * e2[2] - aDir[2] * e2[1],
+                     aDir[2] * e2[0] - aDir[0] * e2[2],
+                     aDir[0] * e2[1] - aDir[1] * e2[0] };
+    double det = e1[0] * pv[0] + e1[1] * pv[1] + e1[2] * pv[2];
+
+    // the occlusion is independent of the winding so both sides are hit
+    if( std::fabs( det ) < 1.0e-20 )
+        return false;
+
+    double inv = 1.0 / det;
+    double tv[3] = { aOrigin[0] - p0.x, aOrigin[1] - p0.y, aOrigin[2] - p0.z };
+    double u = ( tv[0] * pv[0] + tv[1] * pv[1] + tv[2] * pv[2] ) * inv;
+
+    if( u < 0.0 || u > 1.0 )
+        return false;
+
+    double qv[3] = { tv[1] * e1[2] - tv[2] * e1[1],
+                     tv[2] * e1[0] - tv[0] * e1[2],
+                     tv[0] * e1[1] - tv[1] * e1[0] };
+    double v = ( aDir[0] * qv[0] + aDir[1] * qv[1] + aDir[2] * qv[2] ) * inv;
+
+    if( v < 0.0 || u + v > 1.0 )
+        return false;
+
+    double t = ( e2[0] * qv[0] + e2[1] * qv[1] + e2[2] * qv[2] ) * inv;
+
+    return t > 0.0 && t < aRange;
+}
+
+
+bool OCCLUDER::Hit( const double* aOrigin, const double* aDir, double aRange ) const
+{
+    if( m_nodes.empty() )
+        return false;
+
+    double inv[3];
+
+    for( int j = 0; j < 3; ++j )
+        inv[j] = 1.0 / aDir[j];
+
+    int stack[BVH_STACK];
+    int depth = 0;
+    stack[depth++] = 0;
+
+    while( depth > 0 )
+    {
+        int idx = stack[--depth];
+        const BVHNODE& node = m_nodes[idx];
+        double tmin = 0.0;
+        double tmax = aRange;
+
+        // slab test; a zero direction component gives +/-inf which
+        // the comparisons below handle
+        for( int j = 0; j < 3 && tmin <= tmax; ++j )
+        {
+            double t0 = ( node.lower[j] - aOrigin[j] ) * inv[j];
+            double t1 = ( node.upper[j] - aOrigin[j] ) * inv[j];
+
+            if( t0 > t1 )
+                std::swap( t0, t1 );
+
+            tmin = std::max( tmin, t0 );
+            tmax = std::min( tmax, t1 );
+        }
+
+        if( tmin > tmax )
+            continue;
+
+        if( node.count > 0 )
+        {
+            for( int i = node.first; i < node.first + node.count; ++i )
+            {
+                if( hitTriangle( m_triangles[i], aOrigin, aDir, aRange ) )
+                    return true;
+            }
+
+            continue;
+        }
+
+        // the depth of a median split tree is log2 of the triangle
+        // count so the stack cannot overflow in practice
+        if( depth + 2 > BVH_STACK )
+            return false;
+
+        stack[depth++] = node.first;
+        stack[depth++] = idx + 1;
+    }
+
+    return false;
+}
+
+}   // namespace
+
+
+bool BakeOcclusion( const std::vector< SGPOINT >& aVertices,
+    const std::vector< int >& aIndices, std::vector< SGCOLOR >& aColors,
+    int aSamples, int aThreads )
+{
+    size_t nVerts = aVertices.size();
+
+    if( aSamples < 1 || nVerts == 0 || aColors.size() != nVerts
+        || aIndices.size() < 3 || aIndices.size() % 3 )
+        return false;
+
+    // area weighted vertex normals and the bounding box diagonal
+    std::vector< double > normals( nVerts * 3, 0.0 );
+    double lower[3] = { HUGE_VAL, HUGE_VAL, HUGE_VAL };
+    double upper[3] = { -HUGE_VAL, -HUGE_VAL, -HUGE_VAL };
+
+    for( size_t i = 0; i < aIndices.size(); i += 3 )
+    {
+        int i0 = aIndices[i];
+        int i1 = aIndices[i + 1];
+        int i2 = aIndices[i + 2];
+
+        if( i0 < 0 || i1 < 0 || i2 < 0 || i0 >= (int)nVerts
+            || i1 >= (int)nVerts || i2 >= (int)nVerts )
+            return false;
+
+        const SGPOINT& p0 = aVertices[i0];
+        const SGPOINT& p1 = aVertices[i1];
+        const SGPOINT& p2 = aVertices[i2];
+        double e1[3] = { p1.x - p0.x, p1.y - p0.y, p1.z - p0.z };
+        double e2[3] = { p2.x - p0.x, p2.y - p0.y, p2.z - p0.z };
+        double n[3] = { e1[1] * e2[2] - e1[2] * e2[1],
+                        e1[2] * e2[0] - e1[0] * e2[2],
+                        e1[0] * e2[1] - e1[1] * e2[0] };
+        int tri[3] = { i0, i1, i2 };
+
+        for( int k = 0; k < 3; ++k )
+        {
+            for( int j = 0; j < 3; ++j )
+                normals[tri[k] * 3 + j] += n[j];
+        }
+    }
+
+    for( size_t i = 0; i < nVerts; ++i )
+    {
+        double v[3] = { aVertices[i].x, aVertices[i].y, aVertices[i].z };
+
+        for( int j = 0; j < 3; ++j )
+        {
+            lower[j] = std::min( lower[j], v[j] );
+            upper[j] = std::max( upper[j], v[j] );
+        }
+    }
+
+    double diag = std::sqrt( ( upper[0] - lower[0] ) * ( upper[0] - lower[0] )
+        + ( upper[1] - lower[1] ) * ( upper[1] - lower[1] )
+        + ( upper[2] - lower[2] ) * ( upper[2] - lower[2] ) );
+
+    if( diag <= 0.0 )
+        return false;
+
+    double range = diag * OCC_RANGE;
+    double offset = diag * OCC_OFFSET;
+    OCCLUDER occluder( aVertices, aIndices );
+    std::vector< float > access( nVerts, 1.0f );
+    std::atomic< size_t > next( 0 );
+
+    // each vertex has its own random sequence so the result does not
+    // depend on the number of threads
+    auto worker = [&]()
+    {
+        size_t start;
+
+        while( ( start = next.fetch_add( OCC_CHUNK ) ) < nVerts )
+        {
+            size_t end = std::min( start + OCC_CHUNK, nVerts );
+
+            for( size_t i = start; i < end; ++i )
+            {
+                double n[3] = { normals[i * 3], normals[i * 3 + 1], normals[i * 3 + 2] };
+                double len = std::sqrt( n[0] * n[0] + n[1] * n[1] + n[2] * n[2] );
+
+                // unreferenced or degenerate vertex
+                if( len <= 0.0 )
+                    continue;
+
+                for( int j = 0; j < 3; ++j )
+                    n[j] /= len;
+
+                // orthonormal basis about the normal
+                double t[3];
+
+                if( std::fabs( n[0] ) > 0.9 )
+                {
+                    t[0] = -n[1] * n[0];
+                    t[1] = 1.0 - n[1] * n[1];
+                    t[2] = -n[1] * n[2];
+                }
+                else
+                {
+                    t[0] = 1.0 - n[0] * n[0];
+                    t[1] = -n[0] * n[1];
+                    t[2] = -n[0] * n[2];
+                }
+
+                len = std::sqrt( t[0] * t[0] + t[1] * t[1] + t[2] * t[2] );
+
+                for( int j = 0; j < 3; ++j )
+                    t[j] /= len;
+
+                double b[3] = { n[1] * t[2] - n[2] * t[1],
+                                n[2] * t[0] - n[0] * t[2],
+                                n[0] * t[1] - n[1] * t[0] };
+
+                double origin[3] = { aVertices[i].x + n[0] * offset,
+                                     aVertices[i].y + n[1] * offset,
+                                     aVertices[i].z + n[2] * offset };
+
+                std::mt19937 rng( (unsigned int)( i * 2654435761u ) );
+                std::uniform_real_distribution< double > uniform( 0.0, 1.0 );
+                int hits = 0;
+
+                for( int s = 0; s < aSamples; ++s )
+                {
+                    // cosine weighted direction
+                    double phi = 2.0 * M_PI * uniform( rng );
+                    double r2 = uniform( rng );
+                    double r = std::sqrt( r2 );
+                    double lx = r * std::cos( phi );
+                    double ly = r * std::sin( phi );
+                    double lz = std::sqrt( 1.0 - r2 );
+                    double dir[3];
+
+                    for( int j = 0; j < 3; ++j )
+                        dir[j] = t[j] * lx + b[j] * ly + n[j] * lz;
+
+                    if( occluder.Hit( origin, dir, range ) )
+                        ++hits;
+                }
+
+                access[i] = 1.0f - (float)hits / (float)aSamples;
+            }
+        }
+    };
+
+    if( aThreads <= 0 )
+        aThreads = (int)std::thread::hardware_concurrency();
+
+    std::vector< std::thread > threads;
+
+    // the calling thread also does its share; if a thread cannot be
+    // started the remaining work is done by the threads already running
+    for( int i = 1; i < aThreads; ++i )
+    {
+        try
+        {
+            threads.push_back( std::thread( worker ) );
+        }
+        catch( const std::system_error& )
+        {
+            break;
+        }
+    }
+
+    worker();
+
+    for( size_t i = 0; i < threads.size(); ++i )
+        threads[i].join();
+
+    for( size_t i = 0; i < nVerts; ++i )
+    {
+        float r, g, b;
+        float scale = (float)( OCC_FLOOR + ( 1.0 - OCC_FLOOR ) * access[i] );
+
+        aColors[i].GetColor( r, g, b );
+        aColors[i].SetColor( r * scale, g * scale, b * scale );
+    }
+
+    return true;
+}
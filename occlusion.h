@@ -0,0 +1,59 @@
+/*
+ * This program source code file is part of oce_vis, a STEP/IGES
+ * to VRML2 converter.
+ *
+ * Copyright (C) 2016 Cirilo Bernardo <cirilo.bernardo@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file occlusion.h
+ * declares the ambient occlusion stage of oce_vis; the occlusion of each
+ * vertex of a triangle set is estimated by casting a hemisphere of rays
+ * against the triangle set and is baked into the per-vertex colors.
+ */
+
+#ifndef OCCLUSION_H
+#define OCCLUSION_H
+
+#include <vector>
+
+#include "plugins/3dapi/sg_base.h"
+
+/**
+ * Function BakeOcclusion
+ * darkens the per-vertex colors of a triangle set by the fraction of a
+ * cosine weighted hemisphere of rays about each vertex normal which hit
+ * the triangle set within a quarter of its bounding box diagonal. Only the
+ * given triangles occlude; oce_vis passes the faces of a single solid since
+ * the result is shared by every occurrence of the solid, so neighbouring
+ * solids of an assembly do not darken each other.
+ *
+ * @param aVertices is the list of vertices
+ * @param aIndices is the list of triangles as vertex index triplets
+ * @param aColors is the list of per-vertex colors to be darkened
+ * @param aSamples is the number of rays cast per vertex
+ * @param aThreads is the number of threads to use; 0 to use all cores
+ * @return true if the colors were updated
+ */
+bool BakeOcclusion( const std::vector< SGPOINT >& aVertices,
+    const std::vector< int >& aIndices, std::vector< SGCOLOR >& aColors,
+    int aSamples, int aThreads );
+
+#endif  // OCCLUSION_H
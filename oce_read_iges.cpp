@@ -0,0 +1,76 @@
+/*
+ * This program source code file is part of oce_vis, a STEP/IGES
+ * to VRML2 converter.
+ *
+ * Copyright (C) 2016 Cirilo Bernardo <cirilo.bernardo@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/*
+ * IGES reader module for oce_vis; loaded on demand so that the IGES
+ * data exchange toolkits are only mapped when an IGES model is read.
+ */
+
+#include <iostream>
+
+#include <TDocStd_Document.hxx>
+#include <IGESCAFControl_Reader.hxx>
+#include <Interface_Static.hxx>
+
+#include "oce_reader.h"
+
+
+extern "C" APIEXPORT bool ReadModel( Handle(TDocStd_Document)& m_doc,
+    const char* fname, double aPrecision )
+{
+    IGESCAFControl_Reader reader;
+    IFSelect_ReturnStatus stat  = reader.ReadFile( fname );
+    reader.PrintCheckLoad( Standard_False, IFSelect_ItemsByEntity ); 
+
+    if( stat != IFSelect_RetDone )
+        return false;
+
+    // Enable user-defined shape precision
+    if( !Interface_Static::SetIVal( "read.precision.mode", 1 ) )
+        return false;
+
+    // Set the shape conversion precision (default 0.0001 has too many triangles)
+    if( !Interface_Static::SetRVal( "read.precision.val", aPrecision ) )  
+        return false;
+
+    Interface_Static::SetRVal( "ShapeProcess.FixFaceSize.Tolerance", aPrecision );
+
+    // set other translation options
+    reader.SetColorMode(true);  // use model colors
+    reader.SetNameMode(false);  // don't use IGES label names
+    reader.SetLayerMode(false); // ignore LAYER data
+
+    if ( !reader.Transfer( m_doc ) )
+    {
+        std::cerr << "* Translation failed\n";
+        m_doc->Close();
+        return false;
+    }
+
+    // are there any shapes to translate?
+    if( reader.NbShapes() < 1 )
+        return false;
+    
+    return true;
+}
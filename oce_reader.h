@@ -0,0 +1,54 @@
+/*
+ * This program source code file is part of oce_vis, a STEP/IGES
+ * to VRML2 converter.
+ *
+ * Copyright (C) 2016 Cirilo Bernardo <cirilo.bernardo@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file oce_reader.h
+ * declares the entry point exported by the IGES and STEP reader modules;
+ * the modules are loaded by oce_vis on demand so that the large OCE data
+ * exchange toolkits are only mapped when a model of that type is read.
+ */
+
+#ifndef OCE_READER_H
+#define OCE_READER_H
+
+#include <TDocStd_Document.hxx>
+
+#include "plugins/3dapi/ifsg_defs.h"
+
+// name of the function exported by each reader module
+#define OCE_READER_ENTRY "ReadModel"
+
+/**
+ * Function OCE_READER_FUNC
+ * transfers the model in the given file into an XCAF document
+ *
+ * @param aDoc is the document to receive the model
+ * @param aFileName is the name of the IGES or STEP file
+ * @param aPrecision is the shape conversion precision in mm
+ * @return true if at least one shape was transferred
+ */
+typedef bool (*OCE_READER_FUNC)( Handle(TDocStd_Document)& aDoc,
+    const char* aFileName, double aPrecision );
+
+#endif  // OCE_READER_H
@@ -0,0 +1,176 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2016 Cirilo Bernardo <cirilo.bernardo@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+
+/**
+ * @file sg_bench_cache.cpp
+ * times the reading of synthetic cache files holding a large number of
+ * references; in the chained layout each transform references the shape
+ * of the previous transform while in the shallow layout all references
+ * point at the shapes of a single transform.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "plugins/3dapi/ifsg_all.h"
+
+
+// number of shapes referenced by each transform of the shallow layout
+#define NSHALLOW 10
+
+
+static double elapsed( const std::chrono::steady_clock::time_point& aStart )
+{
+    std::chrono::duration< double, std::milli > dt = std::chrono::steady_clock::now() - aStart;
+    return dt.count();
+}
+
+
+static SGNODE* addShape( SGNODE* aParent )
+{
+    SGPOINT points[3] = { SGPOINT( 0, 0, 0 ), SGPOINT( 1, 0, 0 ), SGPOINT( 0, 1, 0 ) };
+    int indices[3] = { 0, 1, 2 };
+
+    IFSG_SHAPE shape( aParent );
+    IFSG_FACESET faceset( shape );
+    IFSG_COORDS coords( faceset );
+    IFSG_COORDINDEX coordIdx( faceset );
+    coords.SetCoordsList( 3, points );
+    coordIdx.SetIndices( 3, indices );
+
+    return shape.GetRawPtr();
+}
+
+
+static SGNODE* makeChained( int aNRefs )
+{
+    IFSG_TRANSFORM top( true );
+    SGNODE* shape = NULL;
+
+    for( int i = 0; i <= aNRefs; ++i )
+    {
+        IFSG_TRANSFORM tx( top.GetRawPtr() );
+        tx.SetTranslation( SGPOINT( i, 0, 0 ) );
+
+        if( NULL != shape )
+            S3D::AddSGNodeRef( tx.GetRawPtr(), shape );
+
+        shape = addShape( tx.GetRawPtr() );
+    }
+
+    return top.GetRawPtr();
+}
+
+
+static SGNODE* makeShallow( int aNRefs )
+{
+    IFSG_TRANSFORM top( true );
+    IFSG_TRANSFORM owner( top.GetRawPtr() );
+    SGNODE* shapes[NSHALLOW];
+
+    for( int i = 0; i < NSHALLOW; ++i )
+        shapes[i] = addShape( owner.GetRawPtr() );
+
+    for( int i = 0; i < aNRefs / NSHALLOW; ++i )
+    {
+        IFSG_TRANSFORM tx( top.GetRawPtr() );
+        tx.SetTranslation( SGPOINT( i, 0, 0 ) );
+
+        for( int j = 0; j < NSHALLOW; ++j )
+            S3D::AddSGNodeRef( tx.GetRawPtr(), shapes[j] );
+    }
+
+    return top.GetRawPtr();
+}
+
+
+static bool runLayout( const char* aLayout, SGNODE* aScene, const std::string& aFileName )
+{
+    SGSTATS wstats = S3D::GetStats( aScene );
+    bool ok = S3D::WriteCache( aFileName.c_str(), true, aScene, "sg_bench_cache" );
+    S3D::DestroyNode( aScene );
+
+    if( !ok )
+    {
+        std::cerr << "could not write '" << aFileName << "'\n";
+        return false;
+    }
+
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    SGNODE* np = S3D::ReadCache( aFileName.c_str(), NULL, NULL );
+    double dt = elapsed( t0 );
+    remove( aFileName.c_str() );
+
+    if( NULL == np )
+    {
+        std::cerr << "could not read '" << aFileName << "'\n";
+        return false;
+    }
+
+    SGSTATS rstats = S3D::GetStats( np );
+    S3D::DestroyNode( np );
+
+    if( rstats.references != wstats.references || rstats.uniqueNodes != wstats.uniqueNodes )
+    {
+        std::cerr << aLayout << ": read " << rstats.references << " references of "
+            << rstats.uniqueNodes << " nodes, expected " << wstats.references
+            << " references of " << wstats.uniqueNodes << " nodes\n";
+        return false;
+    }
+
+    std::cout << aLayout << ": " << rstats.references << " references read: "
+        << dt << " ms\n";
+
+    return true;
+}
+
+
+int main( int argc, char** argv )
+{
+    int nRefs = 50000;
+    std::string fileName = "sg_bench_cache.3dc";
+
+    if( argc > 1 )
+        nRefs = atoi( argv[1] );
+
+    if( argc > 2 )
+        fileName = argv[2];
+
+    if( nRefs < NSHALLOW )
+    {
+        std::cerr << "usage: " << argv[0] << " [number of references] [cache file]\n";
+        return -1;
+    }
+
+    if( !runLayout( "chained", makeChained( nRefs ), fileName ) )
+        return -1;
+
+    if( !runLayout( "shallow", makeShallow( nRefs ), fileName ) )
+        return -1;
+
+    return 0;
+}
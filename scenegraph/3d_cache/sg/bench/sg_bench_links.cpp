@@ -0,0 +1,125 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2016 Cirilo Bernardo <cirilo.bernardo@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+
+/**
+ * @file sg_bench_links.cpp
+ * times the linking and unlinking of a large number of shapes which
+ * are owned or referenced by a single transform
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "plugins/3dapi/ifsg_all.h"
+
+
+static double elapsed( const std::chrono::steady_clock::time_point& aStart )
+{
+    std::chrono::duration< double, std::milli > dt = std::chrono::steady_clock::now() - aStart;
+    return dt.count();
+}
+
+
+int main( int argc, char** argv )
+{
+    int nShapes = 100000;
+
+    if( argc > 1 )
+        nShapes = atoi( argv[1] );
+
+    if( nShapes < 2 )
+    {
+        std::cerr << "usage: " << argv[0] << " [number of shapes]\n";
+        return -1;
+    }
+
+    IFSG_TRANSFORM top( true );
+    IFSG_TRANSFORM holder( top.GetRawPtr() );
+    IFSG_TRANSFORM owner( top.GetRawPtr() );
+    std::vector< SGNODE* > shapes;
+    shapes.reserve( nShapes );
+
+    // add children
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+
+    for( int i = 0; i < nShapes; ++i )
+    {
+        IFSG_SHAPE shape( owner );
+        shapes.push_back( shape.GetRawPtr() );
+    }
+
+    std::cout << nShapes << " shapes added: " << elapsed( t0 ) << " ms\n";
+
+    // add references
+    t0 = std::chrono::steady_clock::now();
+
+    for( int i = 0; i < nShapes; ++i )
+    {
+        if( !S3D::AddSGNodeRef( holder.GetRawPtr(), shapes[i] ) )
+        {
+            std::cerr << "could not add reference " << i << "\n";
+            top.Destroy();
+            return -1;
+        }
+    }
+
+    std::cout << nShapes << " references added: " << elapsed( t0 ) << " ms\n";
+
+    // destroy the middle half of the shapes; each destruction unlinks
+    // the shape from both the owner and the holder
+    int first = nShapes / 4;
+    int last = first + nShapes / 2;
+    t0 = std::chrono::steady_clock::now();
+
+    for( int i = first; i < last; ++i )
+        S3D::DestroyNode( shapes[i] );
+
+    std::cout << ( last - first ) << " shapes destroyed from the middle: "
+        << elapsed( t0 ) << " ms\n";
+
+    // destroy the remaining shapes in the order of creation
+    t0 = std::chrono::steady_clock::now();
+
+    for( int i = 0; i < first; ++i )
+        S3D::DestroyNode( shapes[i] );
+
+    for( int i = last; i < nShapes; ++i )
+        S3D::DestroyNode( shapes[i] );
+
+    std::cout << ( nShapes - last + first ) << " shapes destroyed in order: "
+        << elapsed( t0 ) << " ms\n";
+
+    SGSTATS stats = S3D::GetStats( top.GetRawPtr() );
+    top.Destroy();
+
+    if( stats.nodes[S3D::SGTYPE_SHAPE] != 0 )
+    {
+        std::cerr << stats.nodes[S3D::SGTYPE_SHAPE] << " shapes were not unlinked\n";
+        return -1;
+    }
+
+    return 0;
+}
@@ -24,6 +24,10 @@
 #include <iostream>
 #include <sstream>
 #include <fstream>
+#include <cstdint>
+#include <mutex>
+#include <cstring>
+#include <unordered_set>
 #include <wx/filename.h>
 #include <wx/log.h>
 #include "plugins/3dapi/ifsg_api.h"
@@ -32,7 +36,15 @@
 #include "3d_cache/sg/scenegraph.h"
 #include "3d_cache/sg/sg_appearance.h"
 #include "3d_cache/sg/sg_shape.h"
+#include "3d_cache/sg/sg_faceset.h"
+#include "3d_cache/sg/sg_lineset.h"
+#include "3d_cache/sg/sg_colors.h"
+#include "3d_cache/sg/sg_coords.h"
+#include "3d_cache/sg/sg_coordindex.h"
+#include "3d_cache/sg/sg_normals.h"
 #include "3d_cache/sg/sg_helpers.h"
+#include "3d_cache/sg/sg_arena.h"
+#include "3d_cache/sg/sg_visitor.h"
 
 
 #ifdef DEBUG
@@ -40,7 +52,7 @@ static char BadNode[] = " * [BUG] NULL pointer passed for aNode\n";
 #endif
 
 // version format of the cache file
-#define SG_VERSION_TAG "VERSION:2"
+#define SG_VERSION_TAG "VERSION:4"
 
 
 static void formatMaterial( SMATERIAL& mat, SGAPPEARANCE const* app )
@@ -77,24 +89,40 @@ static void formatMaterial( SMATERIAL& mat, SGAPPEARANCE const* app )
 }
 
 
+// the numerics locale is process wide; concurrent writers share the
+// switch to "C" and the last writer to finish reverts it
 class VRML_LOCALE
 {
 private:
-    std::string lname;
+    static std::mutex lock;
+    static int        users;
+    static std::string lname;
 
 public:
     VRML_LOCALE()
     {
-        lname = setlocale( LC_NUMERIC, NULL );
-        setlocale( LC_NUMERIC, "C" );   // switch the numerics locale to "C"
+        std::lock_guard< std::mutex > guard( lock );
+
+        if( 0 == users++ )
+        {
+            lname = setlocale( LC_NUMERIC, NULL );
+            setlocale( LC_NUMERIC, "C" );   // switch the numerics locale to "C"
+        }
     }
 
     ~VRML_LOCALE()
     {
-        setlocale( LC_NUMERIC, lname.c_str() ); // revert to the previous locale
+        std::lock_guard< std::mutex > guard( lock );
+
+        if( 0 == --users )
+            setlocale( LC_NUMERIC, lname.c_str() ); // revert to the previous locale
     }
 };
 
+std::mutex  VRML_LOCALE::lock;
+int         VRML_LOCALE::users = 0;
+std::string VRML_LOCALE::lname;
+
 
 bool S3D::WriteVRML( const char* filename, bool overwrite, SGNODE* aTopNode,
     bool reuse, bool renameNodes )
@@ -159,13 +187,10 @@ bool S3D::WriteVRML( const char* filename, bool overwrite, SGNODE* aTopNode,
 
     op << "#VRML V2.0 utf8\n";
 
-    if( renameNodes )
-    {
-        aTopNode->ResetNodeIndex();
-        aTopNode->ReNameNodes();
-    }
-
-    aTopNode->WriteVRML( op, reuse );
+    // the nodes written and any generated names are held by the
+    // write state so that the scene graph is not modified
+    SGWRITE state( aTopNode, renameNodes );
+    aTopNode->WriteVRML( op, reuse, state );
 
     if( !op.fail() )
     {
@@ -225,7 +250,7 @@ void S3D::RenameNodes( SGNODE* aNode )
         return;
     }
 
-    aNode->ReNameNodes();
+    aNode->ReNameNodes( aNode->GetNameContext() );
 
     return;
 }
@@ -253,6 +278,171 @@ void S3D::DestroyNode( SGNODE* aNode )
 }
 
 
+/**
+ * Class SGSTATS_VISITOR
+ * accumulates SGSTATS over a traversal which follows references
+ */
+class SGSTATS_VISITOR : public SGVISITOR
+{
+private:
+    SGSTATS& m_Stats;
+    std::unordered_set< const SGNODE* > m_Seen;
+
+    // memory of the node object itself, including its allocation header
+    static size_t objectBytes( const SGNODE* aNode )
+    {
+        size_t nb = sizeof( SGALLOC );
+
+        switch( aNode->GetNodeType() )
+        {
+        case S3D::SGTYPE_TRANSFORM:  nb += sizeof( SCENEGRAPH );   break;
+        case S3D::SGTYPE_APPEARANCE: nb += sizeof( SGAPPEARANCE ); break;
+        case S3D::SGTYPE_COLORS:     nb += sizeof( SGCOLORS );     break;
+        case S3D::SGTYPE_COORDS:     nb += sizeof( SGCOORDS );     break;
+        case S3D::SGTYPE_COORDINDEX: nb += sizeof( SGCOORDINDEX ); break;
+        case S3D::SGTYPE_NORMALS:    nb += sizeof( SGNORMALS );    break;
+        case S3D::SGTYPE_FACESET:    nb += sizeof( SGFACESET );    break;
+        case S3D::SGTYPE_LINESET:    nb += sizeof( SGLINESET );    break;
+        case S3D::SGTYPE_SHAPE:      nb += sizeof( SGSHAPE );      break;
+        default:                     break;
+        }
+
+        return nb;
+    }
+
+public:
+    SGSTATS_VISITOR( SGSTATS& aStats ) : m_Stats( aStats )
+    {
+        return;
+    }
+
+    SGVISIT_ACTION Pre( const SGVISIT& aVisit )
+    {
+        SGNODE* np = aVisit.node;
+        S3D::SGTYPES type = np->GetNodeType();
+        bool first = m_Seen.insert( np ).second;
+
+        ++m_Stats.instances;
+
+        if( aVisit.isRef )
+            ++m_Stats.references;
+
+        size_t nv = 0;
+        size_t ni = 0;
+        size_t data = 0;
+
+        switch( type )
+        {
+        case S3D::SGTYPE_COORDS:
+            {
+                SGCOORDS* cp = static_cast< SGCOORDS* >( np );
+                nv = cp->GetSize();
+                data = cp->GetDataBytes();
+            }
+            break;
+
+        case S3D::SGTYPE_NORMALS:
+            data = static_cast< SGNORMALS* >( np )->GetDataBytes();
+            break;
+
+        case S3D::SGTYPE_COLORS:
+            {
+                const std::vector< SGCOLOR >& list = static_cast< SGCOLORS* >( np )->colors;
+                data = list.capacity() * sizeof( SGCOLOR );
+            }
+            break;
+
+        case S3D::SGTYPE_COORDINDEX:
+            {
+                const std::vector< int >& list = static_cast< SGCOORDINDEX* >( np )->index;
+                ni = list.size();
+                data = list.capacity() * sizeof( int );
+            }
+            break;
+
+        default:
+            break;
+        }
+
+        // a coordinate index only describes triangles within a face set
+        size_t nt = 0;
+
+        if( ni && NULL != aVisit.parent
+            && S3D::SGTYPE_FACESET == aVisit.parent->GetNodeType() )
+            nt = ni / 3;
+
+        m_Stats.vertices += nv;
+        m_Stats.indices += ni;
+        m_Stats.triangles += nt;
+
+        // the memory of a referenced node is accounted for at its first
+        // occurrence; the nodes beneath it are still visited as instances
+        if( !first )
+            return SGVISIT_CONTINUE;
+
+        size_t link = np->GetLinkBytes();
+
+        if( S3D::SGTYPE_TRANSFORM == type )
+            link += static_cast< SCENEGRAPH* >( np )->GetListBytes();
+
+        size_t obj = objectBytes( np );
+        size_t name = np->GetNameBytes();
+
+        ++m_Stats.uniqueNodes;
+        ++m_Stats.nodes[type];
+        m_Stats.bytes[type] += obj + link + name + data;
+        m_Stats.uniqueVertices += nv;
+        m_Stats.uniqueIndices += ni;
+        m_Stats.uniqueTriangles += nt;
+        m_Stats.nodeBytes += obj;
+        m_Stats.linkBytes += link;
+        m_Stats.nameBytes += name;
+        m_Stats.dataBytes += data;
+
+        return SGVISIT_CONTINUE;
+    }
+};
+
+
+SGSTATS S3D::GetStats( SGNODE* aNode )
+{
+    SGSTATS stats;
+    memset( &stats, 0, sizeof( stats ) );
+
+    if( NULL == aNode )
+        return stats;
+
+    SGSTATS_VISITOR visitor( stats );
+    S3D::Walk( aNode, visitor, SGWALK_REFS );
+
+    stats.totalBytes = stats.nodeBytes + stats.linkBytes + stats.nameBytes + stats.dataBytes;
+
+    return stats;
+}
+
+
+bool S3D::GetBounds( SGNODE* aNode, SGPOINT& aMin, SGPOINT& aMax )
+{
+    SGBOUNDS bounds;
+
+    if( NULL == aNode || !aNode->GetBounds( bounds ) )
+        return false;
+
+    // a transform node is placed by its own transform as in GetModel()
+    if( S3D::SGTYPE_TRANSFORM == aNode->GetNodeType() )
+    {
+        SGBOUNDS local = bounds;
+        bounds = SGBOUNDS();
+        bounds.Add( local, static_cast< SCENEGRAPH* >( aNode )->GetTransform() );
+    }
+
+    aMin = SGPOINT( bounds.lower.x, bounds.lower.y, bounds.lower.z );
+    aMax = SGPOINT( bounds.upper.x, bounds.upper.y, bounds.upper.z );
+
+    return true;
+}
+
+
 bool S3D::WriteCache( const char* aFileName, bool overwrite, SGNODE* aNode,
     const char* aPluginInfo )
 {
@@ -275,6 +465,23 @@ bool S3D::WriteCache( const char* aFileName, bool overwrite, SGNODE* aNode,
         return false;
     }
 
+    // the cache file holds the entire scene graph
+    while( NULL != aNode->GetParent() )
+        aNode = aNode->GetParent();
+
+    if( S3D::SGTYPE_TRANSFORM != aNode->GetNodeType() )
+    {
+        #ifdef DEBUG
+        do {
+            std::ostringstream ostr;
+            ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
+            ostr << " * [BUG] top level node is not a SCENEGRAPH object";
+            wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
+        } while( 0 );
+        #endif
+
+        return false;
+    }
 
     if( wxFileName::Exists( ofile ) )
     {
@@ -324,7 +531,8 @@ bool S3D::WriteCache( const char* aFileName, bool overwrite, SGNODE* aNode,
     else
         output << "(INTERNAL:0.0.0.0)";
 
-    bool rval = aNode->WriteCache( output, NULL );
+    SGWRITE state( aNode, true );
+    bool rval = aNode->WriteCache( output, state );
     output.close();
 
     if( !rval )
@@ -347,6 +555,35 @@ bool S3D::WriteCache( const char* aFileName, bool overwrite, SGNODE* aNode,
 }
 
 
+/**
+ * Class SGVALIDATE
+ * validates the geometry of a scene graph in advance of its use
+ * so that readers find the results of the validation in place
+ */
+class SGVALIDATE : public SGVISITOR
+{
+public:
+    SGVISIT_ACTION Pre( const SGVISIT& aVisit )
+    {
+        switch( aVisit.node->GetNodeType() )
+        {
+        case S3D::SGTYPE_FACESET:
+            static_cast< SGFACESET* >( aVisit.node )->validate();
+            return SGVISIT_SKIP;
+
+        case S3D::SGTYPE_LINESET:
+            static_cast< SGLINESET* >( aVisit.node )->validate();
+            return SGVISIT_SKIP;
+
+        default:
+            break;
+        }
+
+        return SGVISIT_CONTINUE;
+    }
+};
+
+
 SGNODE* S3D::ReadCache( const char* aFileName, void* aPluginMgr,
         bool (*aTagCheck)( const char*, void* ) )
 {
@@ -367,7 +604,9 @@ SGNODE* S3D::ReadCache( const char* aFileName, void* aPluginMgr,
         return NULL;
     }
 
-    SGNODE* np = new SCENEGRAPH( NULL );
+    // all nodes read from the cache are allocated from the arena of
+    // the new scene graph so that they are released together
+    SGNODE* np = SGARENA::NewScene();
 
     if( NULL == np )
     {
@@ -479,7 +718,10 @@ SGNODE* S3D::ReadCache( const char* aFileName, void* aPluginMgr,
 
     } while( 0 );
 
+    // references are resolved via the name index of the new scene
+    // graph which is discarded once the file has been read
     bool rval = np->ReadCache( file, NULL );
+    np->GetNameContext().ClearNodes();
     file.close();
 
     if( !rval )
@@ -494,6 +736,12 @@ SGNODE* S3D::ReadCache( const char* aFileName, void* aPluginMgr,
         return NULL;
     }
 
+    // a scene graph read from a cache file is typically shared by the
+    // threads which render it and is not modified further; every node is
+    // owned by the new scene graph so references need not be followed
+    SGVALIDATE validator;
+    S3D::Walk( np, validator, 0 );
+
     return np;
 }
 
@@ -508,6 +756,7 @@ S3DMODEL* S3D::GetModel( SCENEGRAPH* aNode )
 
     S3D::MATLIST materials;
     std::vector< SMESH > meshes;
+    std::vector< SLINESET > lines;
 
     // the materials list shall have a default color; although the VRML
     // default is an opaque black, the default used here shall be a median
@@ -524,9 +773,10 @@ S3DMODEL* S3D::GetModel( SCENEGRAPH* aNode )
     materials.matorder.push_back( &app );
     materials.matmap.insert( std::pair< SGAPPEARANCE const*, int >( &app, 0 ) );
 
-    if( aNode->Prepare( NULL, materials, meshes ) )
+    if( aNode->Prepare( NULL, materials, meshes, lines ) )
     {
-        if( meshes.empty() )
+        // a model may consist of line sets only
+        if( meshes.empty() && lines.empty() )
             return NULL;
 
         S3DMODEL* model = S3D::New3DModel();
@@ -541,15 +791,33 @@ S3DMODEL* S3D::GetModel( SCENEGRAPH* aNode )
         model->m_Materials = lmat;
         model->m_MaterialsSize = j;
 
-        // add all the meshes
+        // add the meshes, if any
         j = meshes.size();
-        SMESH* lmesh = new SMESH[j];
 
-        for( size_t i = 0; i < j; ++i )
-            lmesh[i] = meshes[i];
+        if( j > 0 )
+        {
+            SMESH* lmesh = new SMESH[j];
+
+            for( size_t i = 0; i < j; ++i )
+                lmesh[i] = meshes[i];
+
+            model->m_Meshes = lmesh;
+            model->m_MeshesSize = j;
+        }
 
-        model->m_Meshes = lmesh;
-        model->m_MeshesSize = j;
+        // add the line sets, if any
+        j = lines.size();
+
+        if( j > 0 )
+        {
+            SLINESET* lline = new SLINESET[j];
+
+            for( size_t i = 0; i < j; ++i )
+                lline[i] = lines[i];
+
+            model->m_LineSets = lline;
+            model->m_LineSetsSize = j;
+        }
 
         return model;
     }
@@ -559,6 +827,11 @@ S3DMODEL* S3D::GetModel( SCENEGRAPH* aNode )
     for( size_t i = 0; i < j; ++i )
         S3D::Free3DMesh( meshes[i] );
 
+    j = lines.size();
+
+    for( size_t i = 0; i < j; ++i )
+        S3D::FREE_SLINESET( lines[i] );
+
     return NULL;
 }
 
@@ -690,6 +963,106 @@ bool S3D::AddSGNodeChild( SGNODE* aParent, SGNODE* aChild )
 }
 
 
+// grafts are serialized on the nodes which they modify via a fixed
+// set of locks selected by the address of the node
+#define GRAFT_LOCKS 64
+
+static std::mutex graft_locks[GRAFT_LOCKS];
+
+
+static std::mutex& graftLock( const SGNODE* aNode )
+{
+    return graft_locks[( (uintptr_t) aNode >> 6 ) % GRAFT_LOCKS];
+}
+
+
+// discarding the bounds held above the parent of a graft walks the
+// parents and back-pointers of its holders, which may be shared with
+// any other graft; such walks and the back-pointers added by grafts
+// are therefore serialized by a single lock
+static std::mutex graft_bounds_lock;
+
+
+bool S3D::GraftSGNodeChild( SGNODE* aParent, SGNODE* aChild )
+{
+    if( NULL == aParent || NULL == aChild )
+        return false;
+
+    // only the top node of an independent tree may be grafted
+    if( NULL != aChild->GetParent() )
+    {
+        #ifdef DEBUG
+        std::ostringstream ostr;
+        ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
+        ostr << " * [BUG] grafted node already has a parent";
+        wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
+        #endif
+
+        return false;
+    }
+
+    do
+    {
+        std::lock_guard< std::mutex > guard( graftLock( aParent ) );
+
+        SGNODE::deferHolderBounds( true );
+        bool rval = aParent->AddChildNode( aChild );
+        SGNODE::deferHolderBounds( false );
+
+        if( !rval )
+            return false;
+
+    } while( 0 );
+
+    // the bounds of aParent were discarded by the link itself, so the
+    // walk starts at its holders
+    std::lock_guard< std::mutex > guard( graft_bounds_lock );
+    aParent->invalidateHolderBounds();
+
+    return true;
+}
+
+
+bool S3D::GraftSGNodeRef( SGNODE* aParent, SGNODE* aNode )
+{
+    if( NULL == aParent || NULL == aNode )
+        return false;
+
+    // a referenced node must be owned by a scene graph
+    if( NULL == aNode->GetParent() )
+    {
+        #ifdef DEBUG
+        std::ostringstream ostr;
+        ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
+        ostr << " * [BUG] referenced node has no parent";
+        wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
+        #endif
+
+        return false;
+    }
+
+    // the referring node and the back-pointers of the referenced node
+    // are both modified; the back-pointers are also read by the walks
+    // discarding bounds, so the walk is made under the same locks
+    std::mutex& lock0 = graftLock( aParent );
+    std::mutex& lock1 = graftLock( aNode );
+
+    if( &lock0 == &lock1 )
+    {
+        std::lock_guard< std::mutex > guard( lock0 );
+        std::lock_guard< std::mutex > bguard( graft_bounds_lock );
+        return aParent->AddRefNode( aNode );
+    }
+
+    std::lock( lock0, lock1 );
+    std::lock_guard< std::mutex > guard0( lock0, std::adopt_lock );
+    std::lock_guard< std::mutex > guard1( lock1, std::adopt_lock );
+    std::lock_guard< std::mutex > bguard( graft_bounds_lock );
+
+    return aParent->AddRefNode( aNode );
+}
+
+
 void S3D::AssociateSGNodeWrapper( SGNODE* aObject, SGNODE** aRefPtr )
 {
     if( NULL == aObject || NULL == aRefPtr || aObject != *aRefPtr )
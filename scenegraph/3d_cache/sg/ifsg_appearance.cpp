@@ -53,7 +53,7 @@ IFSG_APPEARANCE::IFSG_APPEARANCE( bool create )
 
 IFSG_APPEARANCE::IFSG_APPEARANCE( SGNODE* aParent )
 {
-    m_node = new SGAPPEARANCE( NULL );
+    m_node = new( aParent ) SGAPPEARANCE( NULL );
 
     if( m_node )
     {
@@ -95,7 +95,7 @@ IFSG_APPEARANCE::IFSG_APPEARANCE( IFSG_NODE& aParent )
     }
     #endif
 
-    m_node = new SGAPPEARANCE( NULL );
+    m_node = new( pp ) SGAPPEARANCE( NULL );
 
     if( m_node )
     {
@@ -148,7 +148,7 @@ bool IFSG_APPEARANCE::NewNode( SGNODE* aParent )
     if( m_node )
         m_node->DisassociateWrapper( &m_node );
 
-    m_node = new SGAPPEARANCE( aParent );
+    m_node = new( aParent ) SGAPPEARANCE( aParent );
 
     if( aParent != m_node->GetParent() )
     {
@@ -23,6 +23,7 @@
 
 #include <iostream>
 #include <sstream>
+#include <utility>
 #include <wx/log.h>
 
 #include "plugins/3dapi/ifsg_colors.h"
@@ -52,7 +53,7 @@ IFSG_COLORS::IFSG_COLORS( bool create )
 
 IFSG_COLORS::IFSG_COLORS( SGNODE* aParent )
 {
-    m_node = new SGCOLORS( NULL );
+    m_node = new( aParent ) SGCOLORS( NULL );
 
     if( m_node )
     {
@@ -92,7 +93,7 @@ IFSG_COLORS::IFSG_COLORS( IFSG_NODE& aParent )
     }
     #endif
 
-    m_node = new SGCOLORS( NULL );
+    m_node = new( pp ) SGCOLORS( NULL );
 
     if( m_node )
     {
@@ -145,7 +146,7 @@ bool IFSG_COLORS::NewNode( SGNODE* aParent )
     if( m_node )
         m_node->DisassociateWrapper( &m_node );
 
-    m_node = new SGCOLORS( aParent );
+    m_node = new( aParent ) SGCOLORS( aParent );
 
     if( aParent != m_node->GetParent() )
     {
@@ -227,6 +228,26 @@ bool IFSG_COLORS::SetColorList( size_t aListSize, const SGCOLOR* aColorList )
 }
 
 
+bool IFSG_COLORS::SetColorList( std::vector< SGCOLOR >&& aColorList )
+{
+    if( NULL == m_node )
+    {
+        #ifdef DEBUG
+        std::ostringstream ostr;
+        ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
+        ostr << BadObject;
+        wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
+        #endif
+
+        return false;
+    }
+
+    ((SGCOLORS*)m_node)->SetColorList( std::move( aColorList ) );
+
+    return true;
+}
+
+
 bool IFSG_COLORS::AddColor( double aRedValue, double aGreenValue, double aBlueValue )
 {
     if( NULL == m_node )
@@ -54,7 +54,7 @@ IFSG_COORDINDEX::IFSG_COORDINDEX( bool create )
 
 IFSG_COORDINDEX::IFSG_COORDINDEX( SGNODE* aParent )
 {
-    m_node = new SGCOORDINDEX( NULL );
+    m_node = new( aParent ) SGCOORDINDEX( NULL );
 
     if( !m_node->SetParent( aParent ) )
     {
@@ -93,7 +93,7 @@ IFSG_COORDINDEX::IFSG_COORDINDEX( IFSG_NODE& aParent )
         return;
     }
 
-    m_node = new SGCOORDINDEX( NULL );
+    m_node = new( pp ) SGCOORDINDEX( NULL );
 
     if( !m_node->SetParent( pp ) )
     {
@@ -142,7 +142,7 @@ bool IFSG_COORDINDEX::NewNode( SGNODE* aParent )
     if( m_node )
         m_node->DisassociateWrapper( &m_node );
 
-    m_node = new SGCOORDINDEX( aParent );
+    m_node = new( aParent ) SGCOORDINDEX( aParent );
 
     if( aParent != m_node->GetParent() )
     {
@@ -23,6 +23,7 @@
 
 #include <iostream>
 #include <sstream>
+#include <utility>
 #include <wx/log.h>
 
 #include "plugins/3dapi/ifsg_coords.h"
@@ -52,7 +53,7 @@ IFSG_COORDS::IFSG_COORDS( bool create )
 
 IFSG_COORDS::IFSG_COORDS( SGNODE* aParent )
 {
-    m_node = new SGCOORDS( NULL );
+    m_node = new( aParent ) SGCOORDS( NULL );
 
     if( m_node )
     {
@@ -92,7 +93,7 @@ IFSG_COORDS::IFSG_COORDS( IFSG_NODE& aParent )
     }
     #endif
 
-    m_node = new SGCOORDS( NULL );
+    m_node = new( pp ) SGCOORDS( NULL );
 
     if( m_node )
     {
@@ -145,7 +146,7 @@ bool IFSG_COORDS::NewNode( SGNODE* aParent )
     if( m_node )
         m_node->DisassociateWrapper( &m_node );
 
-    m_node = new SGCOORDS( aParent );
+    m_node = new( aParent ) SGCOORDS( aParent );
 
     if( aParent != m_node->GetParent() )
     {
@@ -189,6 +190,26 @@ bool IFSG_COORDS::NewNode( IFSG_NODE& aParent )
 }
 
 
+bool IFSG_COORDS::SetSinglePrecision( bool aSingle )
+{
+    if( NULL == m_node )
+    {
+        #ifdef DEBUG
+        std::ostringstream ostr;
+        ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
+        ostr << BadObject;
+        wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
+        #endif
+
+        return false;
+    }
+
+    ((SGCOORDS*)m_node)->SetSinglePrecision( aSingle );
+
+    return true;
+}
+
+
 bool IFSG_COORDS::GetCoordsList( size_t& aListSize, SGPOINT*& aCoordsList )
 {
     if( NULL == m_node )
@@ -227,6 +248,26 @@ bool IFSG_COORDS::SetCoordsList( size_t aListSize, const SGPOINT* aCoordsList )
 }
 
 
+bool IFSG_COORDS::SetCoordsList( std::vector< SGPOINT >&& aCoordsList )
+{
+    if( NULL == m_node )
+    {
+        #ifdef DEBUG
+        std::ostringstream ostr;
+        ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
+        ostr << BadObject;
+        wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
+        #endif
+
+        return false;
+    }
+
+    ((SGCOORDS*)m_node)->SetCoordsList( std::move( aCoordsList ) );
+
+    return true;
+}
+
+
 bool IFSG_COORDS::AddCoord( double aXValue, double aYValue, double aZValue )
 {
     if( NULL == m_node )
@@ -53,7 +53,7 @@ IFSG_FACESET::IFSG_FACESET( bool create )
 
 IFSG_FACESET::IFSG_FACESET( SGNODE* aParent )
 {
-    m_node = new SGFACESET( NULL );
+    m_node = new( aParent ) SGFACESET( NULL );
 
     if( m_node )
     {
@@ -93,7 +93,7 @@ IFSG_FACESET::IFSG_FACESET( IFSG_NODE& aParent )
     }
     #endif
 
-    m_node = new SGFACESET( NULL );
+    m_node = new( pp ) SGFACESET( NULL );
 
     if( m_node )
     {
@@ -146,7 +146,7 @@ bool IFSG_FACESET::NewNode( SGNODE* aParent )
     if( m_node )
         m_node->DisassociateWrapper( &m_node );
 
-    m_node = new SGFACESET( aParent );
+    m_node = new( aParent ) SGFACESET( aParent );
 
     if( aParent != m_node->GetParent() )
     {
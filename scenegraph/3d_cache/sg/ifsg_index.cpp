@@ -24,6 +24,7 @@
 
 #include <iostream>
 #include <sstream>
+#include <utility>
 #include <wx/log.h>
 
 #include "plugins/3dapi/ifsg_index.h"
@@ -80,6 +81,26 @@ bool IFSG_INDEX::SetIndices( size_t nIndices, int* aIndexList )
 }
 
 
+bool IFSG_INDEX::SetIndices( std::vector< int >&& aIndexList )
+{
+    if( NULL == m_node )
+    {
+        #ifdef DEBUG
+        std::ostringstream ostr;
+        ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
+        ostr << BadObject;
+        wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
+        #endif
+
+        return false;
+    }
+
+    ((SGINDEX*)m_node)->SetIndices( std::move( aIndexList ) );
+
+    return true;
+}
+
+
 bool IFSG_INDEX::AddIndex( int aIndex )
 {
     if( NULL == m_node )
@@ -24,6 +24,7 @@
 
 #include <iostream>
 #include <sstream>
+#include <utility>
 #include <wx/log.h>
 
 #include "plugins/3dapi/ifsg_normals.h"
@@ -54,7 +55,7 @@ IFSG_NORMALS::IFSG_NORMALS( bool create )
 
 IFSG_NORMALS::IFSG_NORMALS( SGNODE* aParent )
 {
-    m_node = new SGNORMALS( NULL );
+    m_node = new( aParent ) SGNORMALS( NULL );
 
     if( m_node )
     {
@@ -94,7 +95,7 @@ IFSG_NORMALS::IFSG_NORMALS( IFSG_NODE& aParent )
     }
     #endif
 
-    m_node = new SGNORMALS( NULL );
+    m_node = new( pp ) SGNORMALS( NULL );
 
     if( m_node )
     {
@@ -147,7 +148,7 @@ bool IFSG_NORMALS::NewNode( SGNODE* aParent )
     if( m_node )
         m_node->DisassociateWrapper( &m_node );
 
-    m_node = new SGNORMALS( aParent );
+    m_node = new( aParent ) SGNORMALS( aParent );
 
     if( aParent != m_node->GetParent() )
     {
@@ -191,6 +192,26 @@ bool IFSG_NORMALS::NewNode( IFSG_NODE& aParent )
 }
 
 
+bool IFSG_NORMALS::SetSinglePrecision( bool aSingle )
+{
+    if( NULL == m_node )
+    {
+        #ifdef DEBUG
+        std::ostringstream ostr;
+        ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
+        ostr << BadObject;
+        wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
+        #endif
+
+        return false;
+    }
+
+    ((SGNORMALS*)m_node)->SetSinglePrecision( aSingle );
+
+    return true;
+}
+
+
 bool IFSG_NORMALS::GetNormalList( size_t& aListSize, SGVECTOR*& aNormalList )
 {
     if( NULL == m_node )
@@ -228,6 +249,25 @@ bool IFSG_NORMALS::SetNormalList( size_t aListSize, const SGVECTOR* aNormalList
 }
 
 
+bool IFSG_NORMALS::SetNormalList( std::vector< SGVECTOR >&& aNormalList )
+{
+    if( NULL == m_node )
+    {
+        #ifdef DEBUG
+        std::ostringstream ostr;
+        ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
+        ostr << BadObject;
+        wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
+        #endif
+
+        return false;
+    }
+
+    ((SGNORMALS*)m_node)->SetNormalList( std::move( aNormalList ) );
+    return true;
+}
+
+
 bool IFSG_NORMALS::AddNormal( double aXValue, double aYValue, double aZValue )
 {
     if( NULL == m_node )
@@ -54,7 +54,7 @@ IFSG_SHAPE::IFSG_SHAPE( bool create )
 
 IFSG_SHAPE::IFSG_SHAPE( SGNODE* aParent )
 {
-    m_node = new SGSHAPE( NULL );
+    m_node = new( aParent ) SGSHAPE( NULL );
 
     if( m_node )
     {
@@ -94,7 +94,7 @@ IFSG_SHAPE::IFSG_SHAPE( IFSG_NODE& aParent )
     }
     #endif
 
-    m_node = new SGSHAPE( NULL );
+    m_node = new( pp ) SGSHAPE( NULL );
 
     if( m_node )
     {
@@ -147,7 +147,7 @@ bool IFSG_SHAPE::NewNode( SGNODE* aParent )
     if( m_node )
         m_node->DisassociateWrapper( &m_node );
 
-    m_node = new SGSHAPE( aParent );
+    m_node = new( aParent ) SGSHAPE( aParent );
 
     if( aParent != m_node->GetParent() )
     {
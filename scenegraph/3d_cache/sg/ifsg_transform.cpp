@@ -28,6 +28,7 @@
 
 #include "plugins/3dapi/ifsg_transform.h"
 #include "3d_cache/sg/scenegraph.h"
+#include "3d_cache/sg/sg_arena.h"
 
 
 extern char BadObject[];
@@ -35,14 +36,17 @@ extern char BadOperand[];
 extern char BadParent[];
 extern char WrongParent[];
 
-IFSG_TRANSFORM::IFSG_TRANSFORM( bool create )
+IFSG_TRANSFORM::IFSG_TRANSFORM( bool create, bool aUseArena )
 {
     m_node = NULL;
 
     if( !create )
         return;
 
-    m_node = new SCENEGRAPH( NULL );
+    if( aUseArena )
+        m_node = SGARENA::NewScene();
+    else
+        m_node = new SCENEGRAPH( NULL );
 
     if( m_node )
         m_node->AssociateWrapper( &m_node );
@@ -53,7 +57,7 @@ IFSG_TRANSFORM::IFSG_TRANSFORM( bool create )
 
 IFSG_TRANSFORM::IFSG_TRANSFORM( SGNODE* aParent )
 {
-    m_node = new SCENEGRAPH( NULL );
+    m_node = new( aParent ) SCENEGRAPH( NULL );
 
     if( m_node )
     {
@@ -106,7 +110,7 @@ bool IFSG_TRANSFORM::NewNode( SGNODE* aParent )
     if( m_node )
         m_node->DisassociateWrapper( &m_node );
 
-    m_node = new SCENEGRAPH( aParent );
+    m_node = new( aParent ) SCENEGRAPH( aParent );
 
     if( aParent != m_node->GetParent() )
     {
@@ -166,6 +170,7 @@ bool IFSG_TRANSFORM::SetRotation( const SGVECTOR& aRotationAxis, double aAngle )
 
     ((SCENEGRAPH*)m_node)->rotation_axis = aRotationAxis;
     ((SCENEGRAPH*)m_node)->rotation_angle = aAngle;
+    m_node->invalidateHolderBounds();
 
     return true;
 }
@@ -186,6 +191,7 @@ bool IFSG_TRANSFORM::SetScale( const SGPOINT& aScale )
     }
 
     ((SCENEGRAPH*)m_node)->scale = aScale;
+    m_node->invalidateHolderBounds();
 
     return true;
 }
@@ -218,6 +224,7 @@ bool IFSG_TRANSFORM::SetScale( double aScale )
     }
 
     ((SCENEGRAPH*)m_node)->scale = SGPOINT( aScale, aScale, aScale );
+    m_node->invalidateHolderBounds();
 
     return true;
 }
@@ -238,6 +245,7 @@ bool IFSG_TRANSFORM::SetTranslation( const SGPOINT& aTranslation )
     }
 
     ((SCENEGRAPH*)m_node)->translation = aTranslation;
+    m_node->invalidateHolderBounds();
 
     return true;
 }
@@ -259,6 +267,7 @@ bool IFSG_TRANSFORM::SetScaleOrientation( const SGVECTOR& aScaleAxis, double aAn
 
     ((SCENEGRAPH*)m_node)->scale_axis = aScaleAxis;
     ((SCENEGRAPH*)m_node)->scale_angle = aAngle;
+    m_node->invalidateHolderBounds();
 
     return true;
 }
@@ -279,6 +288,7 @@ bool IFSG_TRANSFORM::SetCenter( const SGPOINT& aCenter )
     }
 
     ((SCENEGRAPH*)m_node)->center = aCenter;
+    m_node->invalidateHolderBounds();
 
     return true;
 }
@@ -32,11 +32,14 @@
 #include "3d_cache/sg/scenegraph.h"
 #include "3d_cache/sg/sg_shape.h"
 #include "3d_cache/sg/sg_helpers.h"
+#include "3d_cache/sg/sg_arena.h"
 
 
 SCENEGRAPH::SCENEGRAPH( SGNODE* aParent ) : SGNODE( aParent )
 {
     m_SGtype = S3D::SGTYPE_TRANSFORM;
+    m_Names = NULL;
+    m_Holes = 0;
     rotation_angle = 0.0;
     scale_angle = 0.0;
 
@@ -67,6 +70,13 @@ SCENEGRAPH::SCENEGRAPH( SGNODE* aParent ) : SGNODE( aParent )
 
 SCENEGRAPH::~SCENEGRAPH()
 {
+    // if this node owns an arena then the nodes held by the arena
+    // are destroyed in bulk once this node has been destroyed
+    SGARENA* arena = SGARENA::Of( this );
+
+    if( NULL != arena )
+        arena->BeginRelease( this );
+
     // drop references
     DROP_REFS( SCENEGRAPH, m_RTransforms );
     DROP_REFS( SGSHAPE, m_RShape );
@@ -75,10 +85,27 @@ SCENEGRAPH::~SCENEGRAPH()
     DEL_OBJS( SCENEGRAPH, m_Transforms );
     DEL_OBJS( SGSHAPE, m_Shape );
 
+    delete m_Names;
+
     return;
 }
 
 
+SGNAMES* SCENEGRAPH::GetNames( void )
+{
+    if( NULL == m_Names )
+        m_Names = new SGNAMES;
+
+    return m_Names;
+}
+
+
+const SGNAMES* SCENEGRAPH::PeekNames( void ) const
+{
+    return m_Names;
+}
+
+
 bool SCENEGRAPH::SetParent( SGNODE* aParent, bool notify )
 {
     if( NULL != m_Parent )
@@ -114,7 +141,7 @@ SGNODE* SCENEGRAPH::FindNode(const char *aNodeName, const SGNODE *aCaller)
     if( NULL == aNodeName || 0 == aNodeName[0] )
         return NULL;
 
-    if( !m_Name.compare( aNodeName ) )
+    if( isNamed( aNodeName ) )
         return this;
 
     FIND_NODE( SCENEGRAPH, aNodeName, m_Transforms, aCaller );
@@ -133,6 +160,8 @@ void SCENEGRAPH::unlinkNode( const SGNODE* aNode, bool isChild )
     if( NULL == aNode )
         return;
 
+    invalidateBounds();
+
     UNLINK_NODE( S3D::SGTYPE_TRANSFORM, SCENEGRAPH, aNode, m_Transforms, m_RTransforms, isChild );
     UNLINK_NODE( S3D::SGTYPE_SHAPE, SGSHAPE, aNode, m_Shape, m_RShape, isChild );
 
@@ -149,6 +178,18 @@ void SCENEGRAPH::unlinkNode( const SGNODE* aNode, bool isChild )
 }
 
 
+void SCENEGRAPH::compactLists( void )
+{
+    S3D::CompactList( m_Transforms, m_Links );
+    S3D::CompactList( m_RTransforms, m_Links );
+    S3D::CompactList( m_Shape, m_Links );
+    S3D::CompactList( m_RShape, m_Links );
+    m_Holes = 0;
+
+    return;
+}
+
+
 void SCENEGRAPH::unlinkChildNode( const SGNODE* aNode )
 {
     unlinkNode( aNode, true );
@@ -177,6 +218,8 @@ bool SCENEGRAPH::addNode( SGNODE* aNode, bool isChild )
         return false;
     }
 
+    invalidateBounds();
+
     ADD_NODE( S3D::SGTYPE_TRANSFORM, SCENEGRAPH, aNode, m_Transforms, m_RTransforms, isChild );
     ADD_NODE( S3D::SGTYPE_SHAPE, SGSHAPE, aNode, m_Shape, m_RShape, isChild );
 
@@ -206,47 +249,7 @@ bool SCENEGRAPH::AddChildNode( SGNODE* aNode )
 }
 
 
-void SCENEGRAPH::ReNameNodes( void )
-{
-    m_written = false;
-
-    // rename this node
-    m_Name.clear();
-    GetName();
-
-    // rename all shapes
-    do
-    {
-        std::vector< SGSHAPE* >::iterator sL = m_Shape.begin();
-        std::vector< SGSHAPE* >::iterator eL = m_Shape.end();
-
-        while( sL != eL )
-        {
-            (*sL)->ReNameNodes();
-            ++sL;
-        }
-
-    } while(0);
-
-    // rename all transforms
-    do
-    {
-        std::vector< SCENEGRAPH* >::iterator sL = m_Transforms.begin();
-        std::vector< SCENEGRAPH* >::iterator eL = m_Transforms.end();
-
-        while( sL != eL )
-        {
-            (*sL)->ReNameNodes();
-            ++sL;
-        }
-
-    } while(0);
-
-    return;
-}
-
-
-bool SCENEGRAPH::WriteVRML( std::ofstream& aFile, bool aReuseFlag )
+bool SCENEGRAPH::WriteVRML( std::ofstream& aFile, bool aReuseFlag, SGWRITE& aState ) const
 {
     if( m_Transforms.empty() && m_RTransforms.empty()
         && m_Shape.empty() && m_RShape.empty() )
@@ -258,14 +261,13 @@ bool SCENEGRAPH::WriteVRML( std::ofstream& aFile, bool aReuseFlag )
 
     if( aReuseFlag )
     {
-        if( !m_written )
+        if( aState.SetWritten( this ) )
         {
-            aFile << "DEF " << GetName() << " Transform {\n";
-            m_written = true;
+            aFile << "DEF " << aState.Name( this ) << " Transform {\n";
         }
         else
         {
-            aFile << "USE " << GetName() << "\n";
+            aFile << "USE " << aState.Name( this ) << "\n";
             return true;
         }
     }
@@ -297,52 +299,74 @@ bool SCENEGRAPH::WriteVRML( std::ofstream& aFile, bool aReuseFlag )
     S3D::FormatPoint( tmp, pt );
     aFile << "  translation " << tmp << "\n";
 
+    // the bounds allow a viewer to cull the children without reading them
+    SGBOUNDS bounds;
+
+    if( GetBounds( bounds ) )
+    {
+        pt.x = ( bounds.lower.x + bounds.upper.x ) * 0.5 / 2.54;
+        pt.y = ( bounds.lower.y + bounds.upper.y ) * 0.5 / 2.54;
+        pt.z = ( bounds.lower.z + bounds.upper.z ) * 0.5 / 2.54;
+        S3D::FormatPoint( tmp, pt );
+        aFile << "  bboxCenter " << tmp << "\n";
+
+        pt.x = ( bounds.upper.x - bounds.lower.x ) / 2.54;
+        pt.y = ( bounds.upper.y - bounds.lower.y ) / 2.54;
+        pt.z = ( bounds.upper.z - bounds.lower.z ) / 2.54;
+        S3D::FormatPoint( tmp, pt );
+        aFile << "  bboxSize " << tmp << "\n";
+    }
+
     aFile << " children [\n";
 
     if( !m_Transforms.empty() )
     {
-        std::vector< SCENEGRAPH* >::iterator sL = m_Transforms.begin();
-        std::vector< SCENEGRAPH* >::iterator eL = m_Transforms.end();
+        std::vector< SCENEGRAPH* >::const_iterator sL = m_Transforms.begin();
+        std::vector< SCENEGRAPH* >::const_iterator eL = m_Transforms.end();
 
         while( sL != eL )
         {
-            (*sL)->WriteVRML( aFile, aReuseFlag );
+            if( NULL != *sL )
+                (*sL)->WriteVRML( aFile, aReuseFlag, aState );
             ++sL;
         }
     }
 
     if( !m_RTransforms.empty() )
     {
-        std::vector< SCENEGRAPH* >::iterator sL = m_RTransforms.begin();
-        std::vector< SCENEGRAPH* >::iterator eL = m_RTransforms.end();
+        std::vector< SCENEGRAPH* >::const_iterator sL = m_RTransforms.begin();
+        std::vector< SCENEGRAPH* >::const_iterator eL = m_RTransforms.end();
 
         while( sL != eL )
         {
-            (*sL)->WriteVRML( aFile, aReuseFlag );
+            if( NULL != *sL )
+                (*sL)->WriteVRML( aFile, aReuseFlag, aState );
             ++sL;
         }
     }
 
     if( !m_Shape.empty() )
     {
-        std::vector< SGSHAPE* >::iterator sL = m_Shape.begin();
-        std::vector< SGSHAPE* >::iterator eL = m_Shape.end();
+        std::vector< SGSHAPE* >::const_iterator sL = m_Shape.begin();
+        std::vector< SGSHAPE* >::const_iterator eL = m_Shape.end();
 
         while( sL != eL )
         {
-            (*sL)->WriteVRML( aFile, aReuseFlag );
+            if( NULL != *sL )
+                (*sL)->WriteVRML( aFile, aReuseFlag, aState );
             ++sL;
         }
     }
 
     if( !m_RShape.empty() )
     {
-        std::vector< SGSHAPE* >::iterator sL = m_RShape.begin();
-        std::vector< SGSHAPE* >::iterator eL = m_RShape.end();
+        std::vector< SGSHAPE* >::const_iterator sL = m_RShape.begin();
+        std::vector< SGSHAPE* >::const_iterator eL = m_RShape.end();
 
         while( sL != eL )
         {
-            (*sL)->WriteVRML( aFile, aReuseFlag );
+            if( NULL != *sL )
+                (*sL)->WriteVRML( aFile, aReuseFlag, aState );
             ++sL;
         }
     }
@@ -353,43 +377,8 @@ bool SCENEGRAPH::WriteVRML( std::ofstream& aFile, bool aReuseFlag )
 }
 
 
-bool SCENEGRAPH::WriteCache( std::ofstream& aFile, SGNODE* parentNode )
+bool SCENEGRAPH::WriteCache( std::ofstream& aFile, SGWRITE& aState ) const
 {
-    if( NULL == parentNode && NULL != m_Parent )
-    {
-        SGNODE* np = m_Parent;
-
-        while( NULL != np->GetParent() )
-            np = np->GetParent();
-
-        if( np->WriteCache( aFile, NULL ) )
-        {
-            m_written = true;
-            return true;
-        }
-
-        return false;
-    }
-
-    if( parentNode != m_Parent )
-    {
-        #ifdef DEBUG
-        std::ostringstream ostr;
-        ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
-        ostr << " * [BUG] corrupt data; parentNode != m_aParent";
-        wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
-        #endif
-
-        return false;
-    }
-
-    if( NULL == m_Parent )
-    {
-        // ensure unique node names
-        ResetNodeIndex();
-        ReNameNodes();
-    }
-
     if( aFile.fail() )
     {
         #ifdef DEBUG
@@ -402,7 +391,8 @@ bool SCENEGRAPH::WriteCache( std::ofstream& aFile, SGNODE* parentNode )
         return false;
     }
 
-    aFile << "[" << GetName() << "]";
+    aState.SetWritten( this );
+    aFile << "[" << aState.Name( this ) << "]";
     S3D::WritePoint( aFile, center );
     S3D::WritePoint( aFile, translation );
     S3D::WriteVector( aFile, rotation_axis );
@@ -411,47 +401,30 @@ bool SCENEGRAPH::WriteCache( std::ofstream& aFile, SGNODE* parentNode )
     S3D::WriteVector( aFile, scale_axis );
     aFile.write( (char*)&scale_angle, sizeof( scale_angle ) );
 
-    // Transfer ownership of any Transform references which hadn't been written
-    size_t asize = m_RTransforms.size();
-    size_t i;
-
-    for( i = 0; i < asize; ++i )
-    {
-        if( !m_RTransforms[i]->isWritten() )
-        {
-            m_RTransforms[i]->SwapParent( this );
-            --asize;
-            --i;
-        }
-    }
-
-    // Transfer ownership of any Shape references which hadn't been written
-    asize = m_RShape.size();
+    // any references which hadn't been written are written in full
+    std::vector< SCENEGRAPH* > transforms;
+    std::vector< SCENEGRAPH* > rtransforms;
+    std::vector< SGSHAPE* > shapes;
+    std::vector< SGSHAPE* > rshapes;
 
-    for( i = 0; i < asize; ++i )
-    {
-        if( !m_RShape[i]->isWritten() )
-        {
-            m_RShape[i]->SwapParent( this );
-            --asize;
-            --i;
-        }
-    }
+    aState.SplitNodes( m_Transforms, m_RTransforms, transforms, rtransforms );
+    aState.SplitNodes( m_Shape, m_RShape, shapes, rshapes );
 
-    asize = m_Transforms.size();
+    size_t asize = transforms.size();
     aFile.write( (char*)&asize, sizeof( size_t ) );
-    asize = m_RTransforms.size();
+    asize = rtransforms.size();
     aFile.write( (char*)&asize, sizeof( size_t ) );
-    asize = m_Shape.size();
+    asize = shapes.size();
     aFile.write( (char*)&asize, sizeof( size_t ) );
-    asize = m_RShape.size();
+    asize = rshapes.size();
     aFile.write( (char*)&asize, sizeof( size_t ) );
-    asize = m_Transforms.size();
+    asize = transforms.size();
+    size_t i;
 
     // write child transforms
     for( i = 0; i < asize; ++i )
     {
-        if( !m_Transforms[i]->WriteCache( aFile, this ) )
+        if( !transforms[i]->WriteCache( aFile, aState ) )
         {
             #ifdef DEBUG
             std::ostringstream ostr;
@@ -465,15 +438,15 @@ bool SCENEGRAPH::WriteCache( std::ofstream& aFile, SGNODE* parentNode )
     }
 
     // write referenced transform names
-    asize = m_RTransforms.size();
+    asize = rtransforms.size();
     for( i = 0; i < asize; ++i )
-        aFile << "[" << m_RTransforms[i]->GetName() << "]";
+        aFile << "[" << aState.Name( rtransforms[i] ) << "]";
 
     // write child shapes
-    asize = m_Shape.size();
+    asize = shapes.size();
     for( i = 0; i < asize; ++i )
     {
-        if( !m_Shape[i]->WriteCache( aFile, this ) )
+        if( !shapes[i]->WriteCache( aFile, aState ) )
         {
             #ifdef DEBUG
             std::ostringstream ostr;
@@ -487,14 +460,13 @@ bool SCENEGRAPH::WriteCache( std::ofstream& aFile, SGNODE* parentNode )
     }
 
     // write referenced transform names
-    asize = m_RShape.size();
+    asize = rshapes.size();
     for( i = 0; i < asize; ++i )
-        aFile << "[" << m_RShape[i]->GetName() << "]";
+        aFile << "[" << aState.Name( rshapes[i] ) << "]";
 
     if( aFile.fail() )
         return false;
 
-    m_written = true;
     return true;
 }
 
@@ -532,7 +504,7 @@ bool SCENEGRAPH::ReadCache( std::ifstream& aFile, SGNODE* parentNode )
             return false;
         }
 
-        m_Name = name;
+        readName( name );
     }
 
     // read fixed member data
@@ -572,8 +544,8 @@ bool SCENEGRAPH::ReadCache( std::ifstream& aFile, SGNODE* parentNode )
             return false;
         }
 
-        SCENEGRAPH* sp = new SCENEGRAPH( this );
-        sp->SetName( name.c_str() );
+        SCENEGRAPH* sp = new( this ) SCENEGRAPH( this );
+        sp->readName( name );
 
         if( !sp->ReadCache( aFile, this ) )
         {
@@ -605,7 +577,7 @@ bool SCENEGRAPH::ReadCache( std::ifstream& aFile, SGNODE* parentNode )
             return false;
         }
 
-        SGNODE* sp = FindNode( name.c_str(), this );
+        SGNODE* sp = findReadNode( name );
 
         if( !sp )
         {
@@ -652,8 +624,8 @@ bool SCENEGRAPH::ReadCache( std::ifstream& aFile, SGNODE* parentNode )
             return false;
         }
 
-        SGSHAPE* sp = new SGSHAPE( this );
-        sp->SetName( name.c_str() );
+        SGSHAPE* sp = new( this ) SGSHAPE( this );
+        sp->readName( name );
 
         if( !sp->ReadCache( aFile, this ) )
         {
@@ -685,7 +657,7 @@ bool SCENEGRAPH::ReadCache( std::ifstream& aFile, SGNODE* parentNode )
             return false;
         }
 
-        SGNODE* sp = FindNode( name.c_str(), this );
+        SGNODE* sp = findReadNode( name );
 
         if( !sp )
         {
@@ -723,10 +695,21 @@ bool SCENEGRAPH::ReadCache( std::ifstream& aFile, SGNODE* parentNode )
 }
 
 
-bool SCENEGRAPH::Prepare( const glm::dmat4* aTransform,
-                      S3D::MATLIST& materials, std::vector< SMESH >& meshes )
+size_t SCENEGRAPH::GetListBytes( void ) const
+{
+    size_t nb = ( m_Transforms.capacity() + m_RTransforms.capacity() ) * sizeof( SCENEGRAPH* )
+                + ( m_Shape.capacity() + m_RShape.capacity() ) * sizeof( SGSHAPE* )
+                + S3D::HashBytes( m_Links );
+
+    if( NULL != m_Names )
+        nb += sizeof( SGNAMES );
+
+    return nb;
+}
+
+
+glm::dmat4 SCENEGRAPH::GetTransform( void ) const
 {
-    // calculate the accumulated transform
     double rX, rY, rZ;
     // rotation
     rotation_axis.GetVector( rX, rY, rZ );
@@ -747,12 +730,64 @@ bool SCENEGRAPH::Prepare( const glm::dmat4* aTransform,
     // P' = T x C x R x SR x S x -SR x -C x P
     // resultant transform:
     // tx0 = tM * cM * rM * srM * sM * nsrM * ncM
+    return tM * cM * rM * srM * sM * nsrM * ncM;
+}
+
+
+bool SCENEGRAPH::resetBounds( void )
+{
+    return m_Bounds.Reset();
+}
+
+
+bool SCENEGRAPH::GetBounds( SGBOUNDS& aBounds ) const
+{
+    if( m_Bounds.Get( aBounds ) )
+        return !aBounds.IsEmpty();
+
+    SGBOUNDS bounds;
+    aBounds = SGBOUNDS();
+
+    for( size_t i = 0; i < m_Shape.size(); ++i )
+    {
+        if( NULL != m_Shape[i] && m_Shape[i]->GetBounds( bounds ) )
+            aBounds.Add( bounds );
+    }
+
+    for( size_t i = 0; i < m_RShape.size(); ++i )
+    {
+        if( NULL != m_RShape[i] && m_RShape[i]->GetBounds( bounds ) )
+            aBounds.Add( bounds );
+    }
+
+    // the bounds of a child are held in its own coordinate system
+    for( size_t i = 0; i < m_Transforms.size(); ++i )
+    {
+        if( NULL != m_Transforms[i] && m_Transforms[i]->GetBounds( bounds ) )
+            aBounds.Add( bounds, m_Transforms[i]->GetTransform() );
+    }
+
+    for( size_t i = 0; i < m_RTransforms.size(); ++i )
+    {
+        if( NULL != m_RTransforms[i] && m_RTransforms[i]->GetBounds( bounds ) )
+            aBounds.Add( bounds, m_RTransforms[i]->GetTransform() );
+    }
+
+    m_Bounds.Set( aBounds );
+    return !aBounds.IsEmpty();
+}
+
+
+bool SCENEGRAPH::Prepare( const glm::dmat4* aTransform, S3D::MATLIST& materials,
+                      std::vector< SMESH >& meshes, std::vector< SLINESET >& lines )
+{
+    // calculate the accumulated transform
     glm::dmat4 tx0;
 
     if( NULL != aTransform )
-        tx0  = (*aTransform) * tM * cM * rM * srM * sM * nsrM * ncM;
+        tx0 = (*aTransform) * GetTransform();
     else
-        tx0  = tM * cM * rM * srM * sM * nsrM * ncM;
+        tx0 = GetTransform();
 
     bool ok = true;
 
@@ -764,7 +799,8 @@ bool SCENEGRAPH::Prepare( const glm::dmat4* aTransform,
 
         while( sL != eL && ok )
         {
-            ok = (*sL)->Prepare( &tx0, materials, meshes );
+            if( NULL != *sL )
+                ok = (*sL)->Prepare( &tx0, materials, meshes, lines );
             ++sL;
         }
 
@@ -773,7 +809,8 @@ bool SCENEGRAPH::Prepare( const glm::dmat4* aTransform,
 
         while( sL != eL && ok )
         {
-            ok = (*sL)->Prepare( &tx0, materials, meshes );
+            if( NULL != *sL )
+                ok = (*sL)->Prepare( &tx0, materials, meshes, lines );
             ++sL;
         }
 
@@ -787,7 +824,8 @@ bool SCENEGRAPH::Prepare( const glm::dmat4* aTransform,
 
         while( sL != eL && ok )
         {
-            ok = (*sL)->Prepare( &tx0, materials, meshes );
+            if( NULL != *sL )
+                ok = (*sL)->Prepare( &tx0, materials, meshes, lines );
             ++sL;
         }
 
@@ -796,7 +834,8 @@ bool SCENEGRAPH::Prepare( const glm::dmat4* aTransform,
 
         while( sL != eL && ok )
         {
-            ok = (*sL)->Prepare( &tx0, materials, meshes );
+            if( NULL != *sL )
+                ok = (*sL)->Prepare( &tx0, materials, meshes, lines );
             ++sL;
         }
 
@@ -34,12 +34,15 @@
 #define SCENE_GRAPH_H
 
 #include <vector>
+#include <unordered_map>
 #include "3d_cache/sg/sg_node.h"
 
 class SGSHAPE;
 
 class SCENEGRAPH : public SGNODE
 {
+    friend class SGWALK;
+
 private:
     // The following are items which may be defined for reuse
     // in a VRML output file. They do not necessarily correspond
@@ -53,8 +56,25 @@ private:
     std::vector< SCENEGRAPH* > m_RTransforms;   // referenced Transform nodes
     std::vector< SGSHAPE* > m_RShape;           // referenced Shape nodes
 
+    // all owned and referenced nodes mapped to their positions within the
+    // lists; used by ADD_NODE and UNLINK_NODE to find nodes without
+    // searching the lists
+    std::unordered_map< const SGNODE*, size_t > m_Links;
+
+    // number of empty slots left in the lists by unlinked nodes
+    size_t m_Holes;
+
+    SGNAMES* m_Names;   // naming context; only created for a top level node
+    SGBOUNDSCACHE m_Bounds; // bounds of the shapes and transforms once computed
+
     void unlinkNode( const SGNODE* aNode, bool isChild );
     bool addNode( SGNODE* aNode, bool isChild );
+    void compactLists( void );
+
+protected:
+    SGNAMES* GetNames( void );
+    const SGNAMES* PeekNames( void ) const;
+    bool resetBounds( void );
 
 public:
     void unlinkChildNode( const SGNODE* aNode );
@@ -78,14 +98,35 @@ public:
     bool AddRefNode( SGNODE* aNode );
     bool AddChildNode( SGNODE* aNode );
 
-    void ReNameNodes( void );
-    bool WriteVRML( std::ofstream& aFile, bool aReuseFlag );
+    bool WriteVRML( std::ofstream& aFile, bool aReuseFlag, SGWRITE& aState ) const;
 
-    bool WriteCache( std::ofstream& aFile, SGNODE* parentNode );
+    bool WriteCache( std::ofstream& aFile, SGWRITE& aState ) const;
     bool ReadCache( std::ifstream& aFile, SGNODE* parentNode );
 
-    bool Prepare( const glm::dmat4* aTransform,
-        S3D::MATLIST& materials, std::vector< SMESH >& meshes );
+    bool Prepare( const glm::dmat4* aTransform, S3D::MATLIST& materials,
+        std::vector< SMESH >& meshes, std::vector< SLINESET >& lines );
+
+    /**
+     * Function GetListBytes
+     * returns the memory held by the lists of owned and referenced nodes
+     * and by the naming context of this node
+     */
+    size_t GetListBytes( void ) const;
+
+    /**
+     * Function GetTransform
+     * returns the transform defined by this node alone
+     */
+    glm::dmat4 GetTransform( void ) const;
+
+    /**
+     * Function GetBounds
+     * returns the bounds of the shapes and transforms held by this node
+     * within its own coordinate system, as written to the bboxCenter and
+     * bboxSize fields of a VRML Transform; the transform of this node
+     * is not applied.
+     */
+    bool GetBounds( SGBOUNDS& aBounds ) const;
 };
 
 /*
@@ -22,8 +22,8 @@
  */
 
 #include <iostream>
-#include <utility>
 #include <sstream>
+#include <utility>
 #include <wx/log.h>
 
 #include "3d_cache/sg/sg_appearance.h"
@@ -220,7 +220,7 @@ SGNODE* SGAPPEARANCE::FindNode(const char *aNodeName, const SGNODE *aCaller)
     if( NULL == aNodeName || 0 == aNodeName[0] )
         return NULL;
 
-    if( !m_Name.compare( aNodeName ) )
+    if( isNamed( aNodeName ) )
         return this;
 
     return NULL;
@@ -279,28 +279,17 @@ bool SGAPPEARANCE::AddChildNode( SGNODE* aNode )
 }
 
 
-void SGAPPEARANCE::ReNameNodes( void )
-{
-    m_written = false;
-
-    // rename this node
-    m_Name.clear();
-    GetName();
-}
-
-
-bool SGAPPEARANCE::WriteVRML( std::ofstream& aFile, bool aReuseFlag )
+bool SGAPPEARANCE::WriteVRML( std::ofstream& aFile, bool aReuseFlag, SGWRITE& aState ) const
 {
     if( aReuseFlag )
     {
-        if( !m_written )
+        if( aState.SetWritten( this ) )
         {
-            aFile << " appearance DEF " << GetName() << " Appearance {\n";
-            m_written = true;
+            aFile << " appearance DEF " << aState.Name( this ) << " Appearance {\n";
         }
         else
         {
-            aFile << " appearance USE " << GetName() << "\n";
+            aFile << " appearance USE " << aState.Name( this ) << "\n";
             return true;
         }
     }
@@ -366,48 +355,8 @@ bool SGAPPEARANCE::WriteVRML( std::ofstream& aFile, bool aReuseFlag )
 }
 
 
-bool SGAPPEARANCE::WriteCache( std::ofstream& aFile, SGNODE* parentNode )
+bool SGAPPEARANCE::WriteCache( std::ofstream& aFile, SGWRITE& aState ) const
 {
-    if( NULL == parentNode )
-    {
-        if( NULL == m_Parent )
-        {
-            #ifdef DEBUG
-            std::ostringstream ostr;
-            ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
-            ostr << " * [BUG] corrupt data; m_aParent is NULL";
-            wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
-            #endif
-
-            return false;
-        }
-
-        SGNODE* np = m_Parent;
-
-        while( NULL != np->GetParent() )
-            np = np->GetParent();
-
-        if( np->WriteCache( aFile, NULL ) )
-        {
-            m_written = true;
-            return true;
-        }
-
-        return false;
-    }
-
-    if( parentNode != m_Parent )
-    {
-        #ifdef DEBUG
-        std::ostringstream ostr;
-        ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
-        ostr << " * [BUG] corrupt data; parentNode != m_aParent";
-        wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
-        #endif
-
-        return false;
-    }
-
     if( !aFile.good() )
     {
         #ifdef DEBUG
@@ -420,7 +369,8 @@ bool SGAPPEARANCE::WriteCache( std::ofstream& aFile, SGNODE* parentNode )
         return false;
     }
 
-    aFile << "[" << GetName() << "]";
+    aState.SetWritten( this );
+    aFile << "[" << aState.Name( this ) << "]";
     S3D::WriteColor( aFile, ambient );
     aFile.write( (char*)&shininess, sizeof(shininess) );
     aFile.write( (char*)&transparency, sizeof(transparency) );
@@ -431,7 +381,6 @@ bool SGAPPEARANCE::WriteCache( std::ofstream& aFile, SGNODE* parentNode )
     if( aFile.fail() )
         return false;
 
-    m_written = true;
     return true;
 }
 
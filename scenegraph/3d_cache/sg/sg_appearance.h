@@ -70,10 +70,9 @@ public:
     bool AddRefNode( SGNODE* aNode );
     bool AddChildNode( SGNODE* aNode );
 
-    void ReNameNodes( void );
-    bool WriteVRML( std::ofstream& aFile, bool aReuseFlag );
+    bool WriteVRML( std::ofstream& aFile, bool aReuseFlag, SGWRITE& aState ) const;
 
-    bool WriteCache( std::ofstream& aFile, SGNODE* parentNode );
+    bool WriteCache( std::ofstream& aFile, SGWRITE& aState ) const;
     bool ReadCache( std::ifstream& aFile, SGNODE* parentNode );
 };
 
@@ -0,0 +1,157 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2015 Cirilo Bernardo <cirilo.bernardo@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <new>
+
+#include "3d_cache/sg/sg_arena.h"
+#include "3d_cache/sg/scenegraph.h"
+
+// size of the memory blocks of an arena; a node larger than
+// this is given a block of its own
+#define ARENA_BLOCK ( 64 * 1024 )
+
+
+SGARENA::SGARENA()
+{
+    m_Next = NULL;
+    m_Free = 0;
+    m_Owner = NULL;
+    m_Releasing = false;
+
+    return;
+}
+
+
+SGARENA::~SGARENA()
+{
+    std::vector< char* >::iterator sB = m_Blocks.begin();
+    std::vector< char* >::iterator eB = m_Blocks.end();
+
+    while( sB != eB )
+    {
+        delete [] *sB;
+        ++sB;
+    }
+
+    return;
+}
+
+
+void* SGARENA::alloc( size_t aSize )
+{
+    const size_t align = sizeof( SGALLOC );
+    size_t need = ( sizeof( SGALLOC ) + aSize + align - 1 ) / align * align;
+
+    if( need > m_Free )
+    {
+        size_t bsize = need > ARENA_BLOCK ? need : ARENA_BLOCK;
+        m_Next = new char[bsize];
+        m_Free = bsize;
+        m_Blocks.push_back( m_Next );
+    }
+
+    void* mp = m_Next;
+    m_Next += need;
+    m_Free -= need;
+
+    return mp;
+}
+
+
+SCENEGRAPH* SGARENA::NewScene( void )
+{
+    SGARENA* arena = new SGARENA;
+    SCENEGRAPH* sp = new( arena ) SCENEGRAPH( NULL );
+    arena->m_Owner = sp;
+
+    return sp;
+}
+
+
+void* SGARENA::Alloc( size_t aSize, SGARENA* aArena )
+{
+    SGALLOC* hp;
+
+    if( NULL == aArena )
+        hp = (SGALLOC*) ::operator new( sizeof( SGALLOC ) + aSize );
+    else
+        hp = (SGALLOC*) aArena->alloc( aSize );
+
+    hp->info.arena = aArena;
+    hp->info.slot = 0;
+
+    if( NULL != aArena )
+    {
+        hp->info.slot = aArena->m_Nodes.size();
+        aArena->m_Nodes.push_back( hp + 1 );
+    }
+
+    return hp + 1;
+}
+
+
+void SGARENA::Free( void* aNode )
+{
+    if( NULL == aNode )
+        return;
+
+    SGALLOC* hp = (SGALLOC*) aNode - 1;
+    SGARENA* arena = hp->info.arena;
+
+    if( NULL == arena )
+    {
+        ::operator delete( hp );
+        return;
+    }
+
+    arena->m_Nodes[hp->info.slot] = NULL;
+
+    if( !arena->m_Releasing || aNode != arena->m_Owner )
+        return;
+
+    // destroy the remaining nodes, the most recent first; a destructor
+    // may delete other nodes of the arena so the list is re-read on
+    // each iteration
+    for( size_t i = arena->m_Nodes.size(); i > 0; --i )
+    {
+        SGNODE* np = (SGNODE*) arena->m_Nodes[i - 1];
+
+        if( NULL == np )
+            continue;
+
+        arena->m_Nodes[i - 1] = NULL;
+        np->~SGNODE();
+    }
+
+    delete arena;
+    return;
+}
+
+
+void SGARENA::BeginRelease( const SGNODE* aNode )
+{
+    if( aNode == m_Owner )
+        m_Releasing = true;
+
+    return;
+}
@@ -0,0 +1,129 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2015 Cirilo Bernardo <cirilo.bernardo@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file sg_arena.h
+ * defines the memory arena from which the nodes of an arena backed
+ * scene graph are allocated
+ */
+
+#ifndef SG_ARENA_H
+#define SG_ARENA_H
+
+#include <cstddef>
+#include <vector>
+
+class SGNODE;
+class SCENEGRAPH;
+class SGARENA;
+
+
+/**
+ * Union SGALLOC
+ * is the header which precedes every node in memory; it records the
+ * arena holding the node (NULL if the node is on the heap) and the
+ * node's position within the arena's list of nodes.
+ */
+union SGALLOC
+{
+    struct
+    {
+        SGARENA* arena;
+        size_t   slot;
+    } info;
+
+    std::max_align_t align;
+};
+
+
+/**
+ * Class SGARENA
+ * holds the memory of all nodes allocated on behalf of an arena backed
+ * top level transform (the owner). Nodes deleted individually are merely
+ * marked as such; their memory is reclaimed along with the arena.
+ * When the owner is deleted the remaining nodes of the arena are
+ * destroyed without undoing the links between them and the memory is
+ * released at once. Links to nodes outside of the arena are undone as usual.
+ */
+class SGARENA
+{
+private:
+    std::vector< char* > m_Blocks;  // memory blocks in order of allocation
+    char*   m_Next;                 // next free byte of the current block
+    size_t  m_Free;                 // free bytes remaining in the current block
+    std::vector< void* > m_Nodes;   // nodes in order of allocation; NULL once deleted
+    SGNODE* m_Owner;                // top level transform owning the arena
+    bool    m_Releasing;            // set true once the owner is being deleted
+
+    SGARENA();
+    ~SGARENA();
+
+    void* alloc( size_t aSize );
+
+public:
+    /**
+     * Function NewScene
+     * returns a new top level transform which owns a new arena; the
+     * nodes subsequently created beneath it are allocated from the arena.
+     */
+    static SCENEGRAPH* NewScene( void );
+
+    /**
+     * Function Alloc
+     * returns storage for a node of the given size; if aArena is NULL
+     * the storage is taken from the heap.
+     */
+    static void* Alloc( size_t aSize, SGARENA* aArena );
+
+    /**
+     * Function Free
+     * releases the storage of a node; if the node is the owner of an arena
+     * which is being released then all other nodes of the arena are
+     * destroyed and the arena itself is deleted.
+     */
+    static void Free( void* aNode );
+
+    /**
+     * Function Of
+     * returns the arena holding the given node or NULL if the
+     * node was allocated on the heap
+     */
+    static SGARENA* Of( const void* aNode )
+    {
+        return ( (const SGALLOC*) aNode - 1 )->info.arena;
+    }
+
+    /**
+     * Function BeginRelease
+     * marks the arena as being released if aNode is its owner; this is
+     * invoked when the owner is being deleted.
+     */
+    void BeginRelease( const SGNODE* aNode );
+
+    bool IsReleasing( void ) const
+    {
+        return m_Releasing;
+    }
+};
+
+#endif  // SG_ARENA_H
@@ -23,6 +23,8 @@
 
 #include <iostream>
 #include <sstream>
+#include <utility>
+#include <map>
 #include <wx/log.h>
 
 #include "3d_cache/sg/sg_colors.h"
@@ -95,7 +97,7 @@ SGNODE* SGCOLORS::FindNode(const char *aNodeName, const SGNODE *aCaller)
     if( NULL == aNodeName || 0 == aNodeName[0] )
         return NULL;
 
-    if( !m_Name.compare( aNodeName ) )
+    if( isNamed( aNodeName ) )
         return this;
 
     return NULL;
@@ -171,14 +173,20 @@ bool SGCOLORS::GetColorList( size_t& aListSize, SGCOLOR*& aColorList )
 
 void SGCOLORS::SetColorList( size_t aListSize, const SGCOLOR* aColorList )
 {
-    colors.clear();
-
     if( 0 == aListSize || NULL == aColorList )
+    {
+        colors.clear();
         return;
+    }
+
+    colors.assign( aColorList, aColorList + aListSize );
+    return;
+}
 
-    for( size_t i = 0; i < aListSize; ++i )
-        colors.push_back( aColorList[i] );
 
+void SGCOLORS::SetColorList( std::vector< SGCOLOR >&& aColorList )
+{
+    colors = std::move( aColorList );
     return;
 }
 
@@ -197,31 +205,55 @@ void SGCOLORS::AddColor( const SGCOLOR& aColor )
 }
 
 
-void SGCOLORS::ReNameNodes( void )
+bool SGCOLORS::GetPalette( std::vector< SGCOLOR >& aPalette,
+    std::vector< int >& aIndexMap ) const
 {
-    m_written = false;
+    aPalette.clear();
+    aIndexMap.clear();
+
+    typedef std::pair< std::pair< float, float >, float > RGBKEY;
+    std::map< RGBKEY, int > entries;
+    std::map< RGBKEY, int >::iterator item;
+    size_t n = colors.size();
+    aIndexMap.reserve( n );
+
+    for( size_t i = 0; i < n; ++i )
+    {
+        float r, g, b;
+        colors[i].GetColor( r, g, b );
+        RGBKEY key( std::pair< float, float >( r, g ), b );
+        item = entries.find( key );
 
-    // rename this node
-    m_Name.clear();
-    GetName();
+        if( item == entries.end() )
+        {
+            item = entries.insert( std::pair< RGBKEY, int >( key,
+                (int)aPalette.size() ) ).first;
+            aPalette.push_back( colors[i] );
+        }
+
+        aIndexMap.push_back( item->second );
+    }
+
+    // merged face sets typically hold a handful of colors over thousands
+    // of vertices; only use the palette when it saves a useful amount
+    return aPalette.size() * 2 <= n;
 }
 
 
-bool SGCOLORS::WriteVRML( std::ofstream& aFile, bool aReuseFlag )
+bool SGCOLORS::WriteVRML( std::ofstream& aFile, bool aReuseFlag, SGWRITE& aState ) const
 {
     if( colors.empty() )
         return false;
 
     if( aReuseFlag )
     {
-        if( !m_written )
+        if( aState.SetWritten( this ) )
         {
-            aFile << "color DEF " << GetName() << " Color { color [\n  ";
-            m_written = true;
+            aFile << "color DEF " << aState.Name( this ) << " Color { color [\n  ";
         }
         else
         {
-            aFile << "color USE " << GetName() << "\n";
+            aFile << "color USE " << aState.Name( this ) << "\n";
             return true;
         }
     }
@@ -230,15 +262,22 @@ bool SGCOLORS::WriteVRML( std::ofstream& aFile, bool aReuseFlag )
         aFile << "color Color { color [\n  ";
     }
 
+    // write the palette in place of the full list if the parent
+    // face set will index it
+    std::vector< SGCOLOR > palette;
+    std::vector< int > indexMap;
+    const std::vector< SGCOLOR >* list = &colors;
+
+    if( GetPalette( palette, indexMap ) )
+        list = &palette;
+
     std::string tmp;
-    size_t n = colors.size();
+    size_t n = list->size();
     bool nline = false;
 
     for( size_t i = 0; i < n; )
     {
-        S3D::FormatColor( tmp, colors[i] );
-        float r,g,b;
-        colors[i].GetColor(r, g, b);
+        S3D::FormatColor( tmp, (*list)[i] );
         aFile << tmp ;
         ++i;
 
@@ -265,48 +304,8 @@ bool SGCOLORS::WriteVRML( std::ofstream& aFile, bool aReuseFlag )
 }
 
 
-bool SGCOLORS::WriteCache( std::ofstream& aFile, SGNODE* parentNode )
+bool SGCOLORS::WriteCache( std::ofstream& aFile, SGWRITE& aState ) const
 {
-    if( NULL == parentNode )
-    {
-        if( NULL == m_Parent )
-        {
-            #ifdef DEBUG
-            std::ostringstream ostr;
-            ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
-            ostr << " * [BUG] corrupt data; m_aParent is NULL";
-            wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
-            #endif
-
-            return false;
-        }
-
-        SGNODE* np = m_Parent;
-
-        while( NULL != np->GetParent() )
-            np = np->GetParent();
-
-        if( np->WriteCache( aFile, NULL ) )
-        {
-            m_written = true;
-            return true;
-        }
-
-        return false;
-    }
-
-    if( parentNode != m_Parent )
-    {
-        #ifdef DEBUG
-        std::ostringstream ostr;
-        ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
-        ostr << " * [BUG] corrupt data; parentNode != m_aParent";
-        wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
-        #endif
-
-        return false;
-    }
-
     if( !aFile.good() )
     {
         #ifdef DEBUG
@@ -319,7 +318,8 @@ bool SGCOLORS::WriteCache( std::ofstream& aFile, SGNODE* parentNode )
         return false;
     }
 
-    aFile << "[" << GetName() << "]";
+    aState.SetWritten( this );
+    aFile << "[" << aState.Name( this ) << "]";
     size_t ncolors = colors.size();
     aFile.write( (char*)&ncolors, sizeof(size_t) );
 
@@ -329,7 +329,6 @@ bool SGCOLORS::WriteCache( std::ofstream& aFile, SGNODE* parentNode )
     if( aFile.fail() )
         return false;
 
-    m_written = true;
     return true;
 }
 
@@ -52,13 +52,22 @@ public:
 
     bool GetColorList( size_t& aListSize, SGCOLOR*& aColorList );
     void SetColorList( size_t aListSize, const SGCOLOR* aColorList );
+    void SetColorList( std::vector< SGCOLOR >&& aColorList );
     void AddColor( double aRedValue, double aGreenValue, double aBlueValue );
     void AddColor( const SGCOLOR& aColor );
 
-    void ReNameNodes( void );
-    bool WriteVRML( std::ofstream& aFile, bool aReuseFlag );
+    /**
+     * Function GetPalette
+     * builds the list of distinct colors and the palette entry of each color
+     *
+     * @return true if the palette is small enough to be written in place
+     * of the full color list; the palette is then indexed via a colorIndex
+     */
+    bool GetPalette( std::vector< SGCOLOR >& aPalette, std::vector< int >& aIndexMap ) const;
 
-    bool WriteCache( std::ofstream& aFile, SGNODE* parentNode );
+    bool WriteVRML( std::ofstream& aFile, bool aReuseFlag, SGWRITE& aState ) const;
+
+    bool WriteCache( std::ofstream& aFile, SGWRITE& aState ) const;
     bool ReadCache( std::ifstream& aFile, SGNODE* parentNode );
 };
 
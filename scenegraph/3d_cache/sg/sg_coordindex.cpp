@@ -28,7 +28,8 @@ SGCOORDINDEX::SGCOORDINDEX( SGNODE* aParent ) : SGINDEX( aParent )
 {
     m_SGtype = S3D::SGTYPE_COORDINDEX;
 
-    if( NULL != aParent && S3D::SGTYPE_FACESET == aParent->GetNodeType() )
+    if( NULL != aParent && ( S3D::SGTYPE_FACESET == aParent->GetNodeType()
+        || S3D::SGTYPE_LINESET == aParent->GetNodeType() ) )
     {
         m_Parent->AddChildNode( this );
     }
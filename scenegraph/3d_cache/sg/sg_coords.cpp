@@ -21,8 +21,10 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
  */
 
+#include <algorithm>
 #include <iostream>
 #include <sstream>
+#include <utility>
 #include <wx/log.h>
 
 #include "3d_cache/sg/sg_coords.h"
@@ -34,8 +36,10 @@
 SGCOORDS::SGCOORDS( SGNODE* aParent ) : SGNODE( aParent )
 {
     m_SGtype = S3D::SGTYPE_COORDS;
+    m_Single = false;
 
-    if( NULL != aParent && S3D::SGTYPE_FACESET != aParent->GetNodeType() )
+    if( NULL != aParent && S3D::SGTYPE_FACESET != aParent->GetNodeType()
+        && S3D::SGTYPE_LINESET != aParent->GetNodeType() )
     {
         m_Parent = NULL;
 
@@ -47,7 +51,7 @@ SGCOORDS::SGCOORDS( SGNODE* aParent ) : SGNODE( aParent )
         wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
 #endif
     }
-    else if( NULL != aParent && S3D::SGTYPE_FACESET == aParent->GetNodeType() )
+    else if( NULL != aParent )
     {
         m_Parent->AddChildNode( this );
     }
@@ -59,6 +63,7 @@ SGCOORDS::SGCOORDS( SGNODE* aParent ) : SGNODE( aParent )
 SGCOORDS::~SGCOORDS()
 {
     coords.clear();
+    m_Points.Clear();
     return;
 }
 
@@ -80,8 +85,9 @@ bool SGCOORDS::SetParent( SGNODE* aParent, bool notify )
             return true;
     }
 
-    // only a SGFACESET may be parent to a SGCOORDS
-    if( NULL != aParent && S3D::SGTYPE_FACESET != aParent->GetNodeType() )
+    // only a SGFACESET or SGLINESET may be parent to a SGCOORDS
+    if( NULL != aParent && S3D::SGTYPE_FACESET != aParent->GetNodeType()
+        && S3D::SGTYPE_LINESET != aParent->GetNodeType() )
         return false;
 
     m_Parent = aParent;
@@ -98,7 +104,7 @@ SGNODE* SGCOORDS::FindNode(const char *aNodeName, const SGNODE *aCaller)
     if( NULL == aNodeName || 0 == aNodeName[0] )
         return NULL;
 
-    if( !m_Name.compare( aNodeName ) )
+    if( isNamed( aNodeName ) )
         return this;
 
     return NULL;
@@ -157,8 +163,161 @@ bool SGCOORDS::AddChildNode( SGNODE* aNode )
 }
 
 
+void SGCOORDS::packPoints( const SGPOINT* aCoordsList, size_t aListSize )
+{
+    m_Points.Clear();
+    m_Origin = SGPOINT( 0.0, 0.0, 0.0 );
+
+    if( 0 == aListSize )
+        return;
+
+    // the offsets from the center of the bounds are at most half the
+    // extent of the points, which keeps the error of each float small
+    // for points which lie far from the model origin
+    SGPOINT lo = aCoordsList[0];
+    SGPOINT hi = aCoordsList[0];
+
+    for( size_t i = 1; i < aListSize; ++i )
+    {
+        const SGPOINT& pt = aCoordsList[i];
+        lo.x = std::min( lo.x, pt.x );
+        lo.y = std::min( lo.y, pt.y );
+        lo.z = std::min( lo.z, pt.z );
+        hi.x = std::max( hi.x, pt.x );
+        hi.y = std::max( hi.y, pt.y );
+        hi.z = std::max( hi.z, pt.z );
+    }
+
+    m_Origin = SGPOINT( ( lo.x + hi.x ) * 0.5, ( lo.y + hi.y ) * 0.5, ( lo.z + hi.z ) * 0.5 );
+    m_Points.Reserve( aListSize );
+
+    for( size_t i = 0; i < aListSize; ++i )
+    {
+        const SGPOINT& pt = aCoordsList[i];
+        m_Points.Add( pt.x - m_Origin.x, pt.y - m_Origin.y, pt.z - m_Origin.z );
+    }
+
+    return;
+}
+
+
+void SGCOORDS::SetSinglePrecision( bool aSingle )
+{
+    if( aSingle == m_Single )
+        return;
+
+    invalidateBounds();
+
+    if( aSingle )
+    {
+        packPoints( coords.empty() ? NULL : &coords[0], coords.size() );
+        std::vector< SGPOINT >().swap( coords );
+        m_Single = true;
+        return;
+    }
+
+    coords.reserve( m_Points.Size() );
+
+    for( size_t i = 0; i < m_Points.Size(); ++i )
+        coords.push_back( GetPoint( i ) );
+
+    m_Points.Release();
+    m_Single = false;
+    return;
+}
+
+
+bool SGCOORDS::resetBounds( void )
+{
+    return m_Bounds.Reset();
+}
+
+
+bool SGCOORDS::GetBounds( SGBOUNDS& aBounds ) const
+{
+    if( m_Bounds.Get( aBounds ) )
+        return !aBounds.IsEmpty();
+
+    aBounds = SGBOUNDS();
+
+    if( !m_Single )
+    {
+        for( size_t i = 0; i < coords.size(); ++i )
+            aBounds.Add( coords[i].x, coords[i].y, coords[i].z );
+
+        m_Bounds.Set( aBounds );
+        return !aBounds.IsEmpty();
+    }
+
+    size_t np = m_Points.Size();
+
+    if( np > 0 )
+    {
+        // independent reductions of each lane which the compiler may vectorize
+        const float* px = &m_Points.x[0];
+        const float* py = &m_Points.y[0];
+        const float* pz = &m_Points.z[0];
+        float lx = px[0];
+        float ly = py[0];
+        float lz = pz[0];
+        float hx = lx;
+        float hy = ly;
+        float hz = lz;
+
+        for( size_t i = 1; i < np; ++i )
+        {
+            lx = px[i] < lx ? px[i] : lx;
+            hx = px[i] > hx ? px[i] : hx;
+            ly = py[i] < ly ? py[i] : ly;
+            hy = py[i] > hy ? py[i] : hy;
+            lz = pz[i] < lz ? pz[i] : lz;
+            hz = pz[i] > hz ? pz[i] : hz;
+        }
+
+        aBounds.Add( m_Origin.x + lx, m_Origin.y + ly, m_Origin.z + lz );
+        aBounds.Add( m_Origin.x + hx, m_Origin.y + hy, m_Origin.z + hz );
+    }
+
+    m_Bounds.Set( aBounds );
+    return !aBounds.IsEmpty();
+}
+
+
+size_t SGCOORDS::GetDataBytes( void ) const
+{
+    return coords.capacity() * sizeof( SGPOINT ) + m_Points.GetBytes();
+}
+
+
+void SGCOORDS::TransformPoints( const glm::dmat4& aTransform, SFVEC3F* aResult ) const
+{
+    if( !m_Single )
+    {
+        for( size_t i = 0; i < coords.size(); ++i )
+        {
+            glm::dvec4 pt( coords[i].x, coords[i].y, coords[i].z, 1.0 );
+            pt = aTransform * pt;
+            aResult[i] = SFVEC3F( pt.x, pt.y, pt.z );
+        }
+
+        return;
+    }
+
+    // the origin is folded into the translation of the transform
+    // so that the kernel only operates on the offsets
+    glm::dmat4 tx = aTransform;
+    tx[3] = aTransform * glm::dvec4( m_Origin.x, m_Origin.y, m_Origin.z, 1.0 );
+    S3D::TransformLanes( tx, 1.0, m_Points, aResult );
+    return;
+}
+
+
 bool SGCOORDS::GetCoordsList( size_t& aListSize, SGPOINT*& aCoordsList )
 {
+    // callers may modify the list so it must be held in double precision
+    SetSinglePrecision( false );
+    invalidateBounds();
+
     if( coords.empty() )
     {
         aListSize = 0;
@@ -174,57 +333,82 @@ bool SGCOORDS::GetCoordsList( size_t& aListSize, SGPOINT*& aCoordsList )
 
 void SGCOORDS::SetCoordsList( size_t aListSize, const SGPOINT* aCoordsList )
 {
-    coords.clear();
+    invalidateBounds();
 
     if( 0 == aListSize || NULL == aCoordsList )
+    {
+        coords.clear();
+        m_Points.Clear();
         return;
+    }
 
-    for( size_t i = 0; i < aListSize; ++i )
-        coords.push_back( aCoordsList[i] );
+    if( m_Single )
+    {
+        packPoints( aCoordsList, aListSize );
+        return;
+    }
 
+    coords.assign( aCoordsList, aCoordsList + aListSize );
     return;
 }
 
 
-void SGCOORDS::AddCoord( double aXValue, double aYValue, double aZValue )
+void SGCOORDS::SetCoordsList( std::vector< SGPOINT >&& aCoordsList )
 {
-    coords.push_back( SGPOINT( aXValue, aYValue, aZValue ) );
+    invalidateBounds();
+
+    if( !m_Single )
+    {
+        coords = std::move( aCoordsList );
+        return;
+    }
+
+    std::vector< SGPOINT > tmp( std::move( aCoordsList ) );
+    packPoints( tmp.empty() ? NULL : &tmp[0], tmp.size() );
     return;
 }
 
 
-void SGCOORDS::AddCoord( const SGPOINT& aPoint )
+void SGCOORDS::AddCoord( double aXValue, double aYValue, double aZValue )
 {
-    coords.push_back( aPoint );
+    AddCoord( SGPOINT( aXValue, aYValue, aZValue ) );
     return;
 }
 
 
-void SGCOORDS::ReNameNodes( void )
+void SGCOORDS::AddCoord( const SGPOINT& aPoint )
 {
-    m_written = false;
+    invalidateBounds();
+
+    if( !m_Single )
+    {
+        coords.push_back( aPoint );
+        return;
+    }
+
+    // the first point becomes the origin of points added individually
+    if( 0 == m_Points.Size() )
+        m_Origin = aPoint;
 
-    // rename this node
-    m_Name.clear();
-    GetName();
+    m_Points.Add( aPoint.x - m_Origin.x, aPoint.y - m_Origin.y, aPoint.z - m_Origin.z );
+    return;
 }
 
 
-bool SGCOORDS::WriteVRML( std::ofstream& aFile, bool aReuseFlag )
+bool SGCOORDS::WriteVRML( std::ofstream& aFile, bool aReuseFlag, SGWRITE& aState ) const
 {
-    if( coords.empty() )
+    if( 0 == GetSize() )
         return false;
 
     if( aReuseFlag )
     {
-        if( !m_written )
+        if( aState.SetWritten( this ) )
         {
-            aFile << "  coord DEF " << GetName() << " Coordinate { point [\n  ";
-            m_written = true;
+            aFile << "  coord DEF " << aState.Name( this ) << " Coordinate { point [\n  ";
         }
         else
         {
-            aFile << "  coord USE " << GetName() << "\n";
+            aFile << "  coord USE " << aState.Name( this ) << "\n";
             return true;
         }
     }
@@ -234,14 +418,14 @@ bool SGCOORDS::WriteVRML( std::ofstream& aFile, bool aReuseFlag )
     }
 
     std::string tmp;
-    size_t n = coords.size();
+    size_t n = GetSize();
     bool nline = false;
     SGPOINT pt;
 
     for( size_t i = 0; i < n; )
     {
         // ensure VRML output has 1U = 0.1 inch as per legacy kicad expectations
-        pt = coords[i];
+        pt = GetPoint( i );
         pt.x /= 2.54;
         pt.y /= 2.54;
         pt.z /= 2.54;
@@ -272,48 +456,8 @@ bool SGCOORDS::WriteVRML( std::ofstream& aFile, bool aReuseFlag )
 }
 
 
-bool SGCOORDS::WriteCache( std::ofstream& aFile, SGNODE* parentNode )
+bool SGCOORDS::WriteCache( std::ofstream& aFile, SGWRITE& aState ) const
 {
-    if( NULL == parentNode )
-    {
-        if( NULL == m_Parent )
-        {
-            #ifdef DEBUG
-            std::ostringstream ostr;
-            ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
-            ostr << " * [BUG] corrupt data; m_aParent is NULL";
-            wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
-            #endif
-
-            return false;
-        }
-
-        SGNODE* np = m_Parent;
-
-        while( NULL != np->GetParent() )
-            np = np->GetParent();
-
-        if( np->WriteCache( aFile, NULL ) )
-        {
-            m_written = true;
-            return true;
-        }
-
-        return false;
-    }
-
-    if( parentNode != m_Parent )
-    {
-        #ifdef DEBUG
-        std::ostringstream ostr;
-        ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
-        ostr << " * [BUG] corrupt data; parentNode != m_aParent";
-        wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
-        #endif
-
-        return false;
-    }
-
     if( !aFile.good() )
     {
         #ifdef DEBUG
@@ -326,24 +470,35 @@ bool SGCOORDS::WriteCache( std::ofstream& aFile, SGNODE* parentNode )
         return false;
     }
 
-    aFile << "[" << GetName() << "]";
-    size_t npts = coords.size();
+    aState.SetWritten( this );
+    aFile << "[" << aState.Name( this ) << "]";
+    size_t npts = GetSize();
     aFile.write( (char*)&npts, sizeof(size_t) );
+    aFile.put( m_Single ? 'F' : 'D' );
 
-    for( size_t i = 0; i < npts; ++i )
-        S3D::WritePoint( aFile, coords[i] );
+    if( m_Single )
+    {
+        S3D::WritePoint( aFile, m_Origin );
+
+        for( size_t i = 0; i < npts; ++i )
+            S3D::WriteLanes( aFile, m_Points, i );
+    }
+    else
+    {
+        for( size_t i = 0; i < npts; ++i )
+            S3D::WritePoint( aFile, coords[i] );
+    }
 
     if( aFile.fail() )
         return false;
 
-    m_written = true;
     return true;
 }
 
 
 bool SGCOORDS::ReadCache( std::ifstream& aFile, SGNODE* parentNode )
 {
-    if( !coords.empty() )
+    if( 0 != GetSize() )
     {
         #ifdef DEBUG
         std::ostringstream ostr;
@@ -356,12 +511,31 @@ bool SGCOORDS::ReadCache( std::ifstream& aFile, SGNODE* parentNode )
     }
 
     size_t npts;
+    char prec = 0;
     aFile.read( (char*)&npts, sizeof(size_t) );
-    SGPOINT tmp;
+    aFile.get( prec );
 
-    if( aFile.fail() )
+    if( aFile.fail() || ( 'F' != prec && 'D' != prec ) )
         return false;
 
+    m_Single = ( 'F' == prec );
+
+    if( m_Single )
+    {
+        if( !S3D::ReadPoint( aFile, m_Origin ) )
+            return false;
+
+        for( size_t i = 0; i < npts; ++i )
+        {
+            if( !S3D::ReadLanes( aFile, m_Points ) )
+                return false;
+        }
+
+        return true;
+    }
+
+    SGPOINT tmp;
+
     for( size_t i = 0; i < npts; ++i )
     {
         if( !S3D::ReadPoint( aFile, tmp ) || aFile.fail() )
@@ -387,24 +561,27 @@ bool SGCOORDS::CalcNormals( SGFACESET* callingNode, SGNODE** aPtr )
     std::vector< int > ilist;
     SGNORMALS* np = NULL;
 
-    if( callingNode == m_Parent )
+    // the coordinates may also be owned or referenced by a line set,
+    // which has no faces and therefore contributes no normals
+    if( S3D::SGTYPE_FACESET == m_Parent->GetNodeType() && callingNode == m_Parent )
     {
-        ((SGFACESET*)m_Parent)->GatherCoordIndices( ilist );
+        callingNode->GatherCoordIndices( ilist );
 
-        std::list< SGNODE* >::iterator sB = m_BackPointers.begin();
-        std::list< SGNODE* >::iterator eB = m_BackPointers.end();
+        std::vector< SGNODE* >::iterator sB = m_BackPointers.begin();
+        std::vector< SGNODE* >::iterator eB = m_BackPointers.end();
 
         while( sB != eB )
         {
-            SGFACESET* fp = (SGFACESET*)(*sB);
-            fp->GatherCoordIndices( ilist );
+            if( S3D::SGTYPE_FACESET == (*sB)->GetNodeType() )
+                ((SGFACESET*)(*sB))->GatherCoordIndices( ilist );
+
             ++sB;
         }
 
-        np = ((SGFACESET*)m_Parent)->m_Normals;
+        np = callingNode->m_Normals;
 
         if( !np )
-            np = new SGNORMALS( m_Parent );
+            np = new( callingNode ) SGNORMALS( callingNode );
 
     }
     else
@@ -413,12 +590,39 @@ bool SGCOORDS::CalcNormals( SGFACESET* callingNode, SGNODE** aPtr )
         np = callingNode->m_Normals;
 
         if( !np )
-            np = new SGNORMALS( callingNode );
+            np = new( callingNode ) SGNORMALS( callingNode );
 
     }
 
-    if( S3D::CalcTriangleNormals( coords, ilist, np->norms )  )
+    std::vector< SGVECTOR > norms;
+    bool ok = false;
+
+    if( 0 == np->GetSize() )
     {
+        if( m_Single )
+        {
+            std::vector< SGPOINT > pts;
+            pts.reserve( m_Points.Size() );
+
+            for( size_t i = 0; i < m_Points.Size(); ++i )
+                pts.push_back( GetPoint( i ) );
+
+            ok = S3D::CalcTriangleNormals( pts, ilist, norms );
+        }
+        else
+        {
+            ok = S3D::CalcTriangleNormals( coords, ilist, norms );
+        }
+    }
+
+    if( ok )
+    {
+        // the normals of single precision coordinates are held in single precision
+        if( m_Single )
+            np->SetSinglePrecision( true );
+
+        np->SetNormalList( std::move( norms ) );
+
         if( aPtr )
             *aPtr = np;
 
@@ -31,13 +31,26 @@
 
 #include <vector>
 #include "3d_cache/sg/sg_node.h"
+#include "3d_cache/sg/sg_helpers.h"
 
 class SGFACESET;
 
 class SGCOORDS : public SGNODE
 {
+private:
+    bool    m_Single;                   // true if the coordinates are held in single precision
+    SGPOINT m_Origin;                   // origin of the single precision coordinates
+    SGLANES m_Points;                   // single precision coordinates relative to m_Origin
+    SGBOUNDSCACHE m_Bounds;             // bounds of the coordinates once computed
+
+    // set m_Origin to the center of the given points and store them in single precision
+    void packPoints( const SGPOINT* aCoordsList, size_t aListSize );
+
+protected:
+    bool resetBounds( void );
+
 public:
-    std::vector< SGPOINT > coords;
+    std::vector< SGPOINT > coords;      // double precision coordinates
 
     void unlinkChildNode( const SGNODE* aNode );
     void unlinkRefNode( const SGNODE* aNode );
@@ -52,8 +65,61 @@ public:
     bool AddRefNode( SGNODE* aNode );
     bool AddChildNode( SGNODE* aNode );
 
+    /**
+     * Function SetSinglePrecision
+     * selects the storage of the coordinates; in single precision the
+     * coordinates are held as floats relative to a double precision
+     * origin at the center of their bounds, which halves the memory and
+     * cache size while retaining sub-micrometre accuracy for parts of up
+     * to several metres. Any existing coordinates are converted.
+     */
+    void SetSinglePrecision( bool aSingle );
+
+    bool IsSinglePrecision( void ) const
+    {
+        return m_Single;
+    }
+
+    size_t GetSize( void ) const
+    {
+        return m_Single ? m_Points.Size() : coords.size();
+    }
+
+    SGPOINT GetPoint( size_t aIndex ) const
+    {
+        if( !m_Single )
+            return coords[aIndex];
+
+        return SGPOINT( m_Origin.x + m_Points.x[aIndex], m_Origin.y + m_Points.y[aIndex],
+                        m_Origin.z + m_Points.z[aIndex] );
+    }
+
+    /**
+     * Function TransformPoints
+     * writes the transformed coordinates to aResult which must hold
+     * GetSize() elements; single precision coordinates are transformed
+     * as a whole by a vectorized kernel.
+     */
+    void TransformPoints( const glm::dmat4& aTransform, SFVEC3F* aResult ) const;
+
+    /**
+     * Function GetBounds
+     * returns the bounds of all coordinates of the list whether
+     * or not they are indexed
+     */
+    bool GetBounds( SGBOUNDS& aBounds ) const;
+
+    // returns the memory held by the coordinate list
+    size_t GetDataBytes( void ) const;
+
+    /**
+     * Function GetCoordsList
+     * returns a pointer to the double precision coordinates; coordinates
+     * held in single precision are first converted to double precision.
+     */
     bool GetCoordsList( size_t& aListSize, SGPOINT*& aCoordsList );
     void SetCoordsList( size_t aListSize, const SGPOINT* aCoordsList );
+    void SetCoordsList( std::vector< SGPOINT >&& aCoordsList );
     void AddCoord( double aXValue, double aYValue, double aZValue );
     void AddCoord( const SGPOINT& aPoint );
 
@@ -64,10 +130,9 @@ public:
      */
     bool CalcNormals( SGFACESET* callingNode, SGNODE** aPtr = NULL );
 
-    void ReNameNodes( void );
-    bool WriteVRML( std::ofstream& aFile, bool aReuseFlag );
+    bool WriteVRML( std::ofstream& aFile, bool aReuseFlag, SGWRITE& aState ) const;
 
-    bool WriteCache( std::ofstream& aFile, SGNODE* parentNode );
+    bool WriteCache( std::ofstream& aFile, SGWRITE& aState ) const;
     bool ReadCache( std::ifstream& aFile, SGNODE* parentNode );
 };
 
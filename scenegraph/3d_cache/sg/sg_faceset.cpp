@@ -43,8 +43,7 @@ SGFACESET::SGFACESET( SGNODE* aParent ) : SGNODE( aParent )
     m_RColors = NULL;
     m_RCoords = NULL;
     m_RNormals = NULL;
-    valid = false;
-    validated = false;
+    m_Validity = SGVALID_UNKNOWN;
 
     if( NULL != aParent && S3D::SGTYPE_SHAPE != aParent->GetNodeType() )
     {
@@ -70,47 +69,47 @@ SGFACESET::SGFACESET( SGNODE* aParent ) : SGNODE( aParent )
 SGFACESET::~SGFACESET()
 {
     // drop references
-    if( m_RColors )
+    if( m_RColors && !isReleased( m_RColors ) )
     {
         m_RColors->delNodeRef( this );
         m_RColors = NULL;
     }
 
-    if( m_RCoords )
+    if( m_RCoords && !isReleased( m_RCoords ) )
     {
         m_RCoords->delNodeRef( this );
         m_RCoords = NULL;
     }
 
-    if( m_RNormals )
+    if( m_RNormals && !isReleased( m_RNormals ) )
     {
         m_RNormals->delNodeRef( this );
         m_RNormals = NULL;
     }
 
     // delete owned objects
-    if( m_Colors )
+    if( m_Colors && !isReleased( m_Colors ) )
     {
         m_Colors->SetParent( NULL, false );
         delete m_Colors;
         m_Colors = NULL;
     }
 
-    if( m_Coords )
+    if( m_Coords && !isReleased( m_Coords ) )
     {
         m_Coords->SetParent( NULL, false );
         delete m_Coords;
         m_Coords = NULL;
     }
 
-    if( m_Normals )
+    if( m_Normals && !isReleased( m_Normals ) )
     {
         m_Normals->SetParent( NULL, false );
         delete m_Normals;
         m_Normals = NULL;
     }
 
-    if( m_CoordIndices )
+    if( m_CoordIndices && !isReleased( m_CoordIndices ) )
     {
         m_CoordIndices->SetParent( NULL, false );
         delete m_CoordIndices;
@@ -156,7 +155,7 @@ SGNODE* SGFACESET::FindNode(const char *aNodeName, const SGNODE *aCaller)
     if( NULL == aNodeName || 0 == aNodeName[0] )
         return NULL;
 
-    if( !m_Name.compare( aNodeName ) )
+    if( isNamed( aNodeName ) )
         return this;
 
     SGNODE* np = NULL;
@@ -206,8 +205,10 @@ void SGFACESET::unlinkNode( const SGNODE* aNode, bool isChild )
     if( NULL == aNode )
         return;
 
-    valid = false;
-    validated = false;
+    m_Validity = SGVALID_UNKNOWN;
+
+    if( S3D::SGTYPE_COORDS == aNode->GetNodeType() )
+        invalidateBounds();
 
     if( isChild )
     {
@@ -301,8 +302,10 @@ bool SGFACESET::addNode( SGNODE* aNode, bool isChild )
         return false;
     }
 
-    valid = false;
-    validated = false;
+    m_Validity = SGVALID_UNKNOWN;
+
+    if( S3D::SGTYPE_COORDS == aNode->GetNodeType() )
+        invalidateBounds();
 
     if( S3D::SGTYPE_COLORS == aNode->GetNodeType() )
     {
@@ -356,6 +359,21 @@ bool SGFACESET::addNode( SGNODE* aNode, bool isChild )
             return true;
         }
 
+        // coordinates owned by a line set cannot be shared with a face set
+        // since the owner must be able to adopt the node when writing a cache
+        if( !isChild && NULL != aNode->GetParent()
+            && S3D::SGTYPE_FACESET != aNode->GetParent()->GetNodeType() )
+        {
+            #ifdef DEBUG
+            std::ostringstream ostr;
+            ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
+            ostr << " * [BUG] referenced Coords node is not owned by a FaceSet";
+            wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
+            #endif
+
+            return false;
+        }
+
         if( isChild )
         {
             m_Coords = (SGCOORDS*)aNode;
@@ -443,46 +461,30 @@ bool SGFACESET::addNode( SGNODE* aNode, bool isChild )
 }
 
 
-bool SGFACESET::AddRefNode( SGNODE* aNode )
+bool SGFACESET::GetBounds( SGBOUNDS& aBounds ) const
 {
-    return addNode( aNode, false );
-}
+    SGCOORDS* pc = m_Coords ? m_Coords : m_RCoords;
 
+    if( NULL == pc )
+        return SGNODE::GetBounds( aBounds );
 
-bool SGFACESET::AddChildNode( SGNODE* aNode )
-{
-    return addNode( aNode, true );
+    return pc->GetBounds( aBounds );
 }
 
 
-void SGFACESET::ReNameNodes( void )
+bool SGFACESET::AddRefNode( SGNODE* aNode )
 {
-    m_written = false;
-
-    // rename this node
-    m_Name.clear();
-    GetName();
-
-    // rename all Colors and Indices
-    if( m_Colors )
-        m_Colors->ReNameNodes();
-
-    // rename all Coordinates and Indices
-    if( m_Coords )
-        m_Coords->ReNameNodes();
-
-    if( m_CoordIndices )
-        m_CoordIndices->ReNameNodes();
+    return addNode( aNode, false );
+}
 
-    // rename all Normals and Indices
-    if( m_Normals )
-        m_Normals->ReNameNodes();
 
-    return;
+bool SGFACESET::AddChildNode( SGNODE* aNode )
+{
+    return addNode( aNode, true );
 }
 
 
-bool SGFACESET::WriteVRML( std::ofstream& aFile, bool aReuseFlag )
+bool SGFACESET::WriteVRML( std::ofstream& aFile, bool aReuseFlag, SGWRITE& aState ) const
 {
     if( ( NULL == m_Coords && NULL == m_RCoords )
         || ( NULL == m_CoordIndices ) )
@@ -494,14 +496,13 @@ bool SGFACESET::WriteVRML( std::ofstream& aFile, bool aReuseFlag )
 
     if( aReuseFlag )
     {
-        if( !m_written )
+        if( aState.SetWritten( this ) )
         {
-            aFile << " geometry DEF " << GetName() << " IndexedFaceSet {\n";
-            m_written = true;
+            aFile << " geometry DEF " << aState.Name( this ) << " IndexedFaceSet {\n";
         }
         else
         {
-            aFile << "USE " << GetName() << "\n";
+            aFile << "USE " << aState.Name( this ) << "\n";
             return true;
         }
     }
@@ -511,77 +512,53 @@ bool SGFACESET::WriteVRML( std::ofstream& aFile, bool aReuseFlag )
     }
 
     if( m_Coords )
-        m_Coords->WriteVRML( aFile, aReuseFlag );
+        m_Coords->WriteVRML( aFile, aReuseFlag, aState );
 
     if( m_RCoords )
-        m_RCoords->WriteVRML( aFile, aReuseFlag );
+        m_RCoords->WriteVRML( aFile, aReuseFlag, aState );
 
     if( m_CoordIndices )
-        m_CoordIndices->WriteVRML( aFile, aReuseFlag );
+        m_CoordIndices->WriteVRML( aFile, aReuseFlag, aState );
 
     if( m_Normals || m_RNormals )
         aFile << "  normalPerVertex TRUE\n";
 
     if( m_Normals )
-        m_Normals->WriteVRML( aFile, aReuseFlag );
+        m_Normals->WriteVRML( aFile, aReuseFlag, aState );
 
     if( m_RNormals )
-        m_RNormals->WriteVRML( aFile, aReuseFlag );
+        m_RNormals->WriteVRML( aFile, aReuseFlag, aState );
 
     if( m_Colors )
-        m_Colors->WriteVRML( aFile, aReuseFlag );
+        m_Colors->WriteVRML( aFile, aReuseFlag, aState );
 
     if( m_RColors )
-        m_RColors->WriteVRML( aFile, aReuseFlag );
-
-    aFile << "}\n";
+        m_RColors->WriteVRML( aFile, aReuseFlag, aState );
 
-    return true;
-}
+    // when the colors were written as a palette of distinct colors
+    // they must be indexed in parallel with the coordinates
+    SGCOLORS* pc = m_Colors;
 
+    if( NULL == pc )
+        pc = m_RColors;
 
-bool SGFACESET::WriteCache( std::ofstream& aFile, SGNODE* parentNode )
-{
-    if( NULL == parentNode )
+    if( NULL != pc )
     {
-        if( NULL == m_Parent )
-        {
-            #ifdef DEBUG
-            std::ostringstream ostr;
-            ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
-            ostr << " * [BUG] corrupt data; m_aParent is NULL";
-            wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
-            #endif
-
-            return false;
-        }
-
-        SGNODE* np = m_Parent;
-
-        while( NULL != np->GetParent() )
-            np = np->GetParent();
+        std::vector< SGCOLOR > palette;
+        std::vector< int > indexMap;
 
-        if( np->WriteCache( aFile, NULL ) )
-        {
-            m_written = true;
-            return true;
-        }
-
-        return false;
+        if( pc->GetPalette( palette, indexMap ) )
+            m_CoordIndices->WriteColorIndex( aFile, indexMap );
     }
 
-    if( parentNode != m_Parent )
-    {
-        #ifdef DEBUG
-        std::ostringstream ostr;
-        ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
-        ostr << " * [BUG] corrupt data; parentNode != m_aParent";
-        wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
-        #endif
+    aFile << "}\n";
+
+    return true;
+}
 
-        return false;
-    }
 
+bool SGFACESET::WriteCache( std::ofstream& aFile, SGWRITE& aState ) const
+{
     if( !aFile.good() )
     {
         #ifdef DEBUG
@@ -594,80 +571,52 @@ bool SGFACESET::WriteCache( std::ofstream& aFile, SGNODE* parentNode )
         return false;
     }
 
-    // check if any references are unwritten and swap parents if so
-    if( NULL != m_RCoords && !m_RCoords->isWritten() )
-        m_RCoords->SwapParent( this );
-
-    if( NULL != m_RNormals && !m_RNormals->isWritten() )
-        m_RNormals->SwapParent( this );
-
-    if( NULL != m_RColors && !m_RColors->isWritten() )
-        m_RColors->SwapParent( this );
+    // a referenced node which hadn't been written is written in full
+    // and a child which had already been written is written as a reference
+    const SGCOORDS* coords = m_Coords ? m_Coords : m_RCoords;
+    const SGNORMALS* normals = m_Normals ? m_Normals : m_RNormals;
+    const SGCOLORS* colors = m_Colors ? m_Colors : m_RColors;
 
-    aFile << "[" << GetName() << "]";
+    aState.SetWritten( this );
+    aFile << "[" << aState.Name( this ) << "]";
     #define NITEMS 7
     bool items[NITEMS];
-    int i;
-
-    for( i = 0; i < NITEMS; ++i )
-        items[i] = 0;
-
-    i = 0;
-    if( NULL != m_Coords )
-        items[i] = true;
-
-    ++i;
-    if( NULL != m_RCoords )
-        items[i] = true;
 
-    ++i;
-    if( NULL != m_CoordIndices )
-        items[i] = true;
-
-    ++i;
-    if( NULL != m_Normals )
-        items[i] = true;
-
-    ++i;
-    if( NULL != m_RNormals )
-        items[i] = true;
-
-    ++i;
-    if( NULL != m_Colors )
-        items[i] = true;
-
-    ++i;
-    if( NULL != m_RColors )
-        items[i] = true;
+    items[0] = NULL != coords && !aState.IsWritten( coords );
+    items[1] = NULL != coords && !items[0];
+    items[2] = NULL != m_CoordIndices;
+    items[3] = NULL != normals && !aState.IsWritten( normals );
+    items[4] = NULL != normals && !items[3];
+    items[5] = NULL != colors && !aState.IsWritten( colors );
+    items[6] = NULL != colors && !items[5];
 
     for( int i = 0; i < NITEMS; ++i )
         aFile.write( (char*)&items[i], sizeof(bool) );
 
     if( items[0] )
-        m_Coords->WriteCache( aFile, this );
+        coords->WriteCache( aFile, aState );
 
     if( items[1] )
-        aFile << "[" << m_RCoords->GetName() << "]";
+        aFile << "[" << aState.Name( coords ) << "]";
 
     if( items[2] )
-        m_CoordIndices->WriteCache( aFile, this );
+        m_CoordIndices->WriteCache( aFile, aState );
 
     if( items[3] )
-        m_Normals->WriteCache( aFile, this );
+        normals->WriteCache( aFile, aState );
 
     if( items[4] )
-        aFile << "[" << m_RNormals->GetName() << "]";
+        aFile << "[" << aState.Name( normals ) << "]";
 
     if( items[5] )
-        m_Colors->WriteCache( aFile, this );
+        colors->WriteCache( aFile, aState );
 
     if( items[6] )
-        aFile << "[" << m_RColors->GetName() << "]";
+        aFile << "[" << aState.Name( colors ) << "]";
 
     if( aFile.fail() )
         return false;
 
-    m_written = true;
     return true;
 }
 
@@ -725,8 +674,8 @@ bool SGFACESET::ReadCache( std::ifstream& aFile, SGNODE* parentNode )
             return false;
         }
 
-        m_Coords = new SGCOORDS( this );
-        m_Coords->SetName( name.c_str() );
+        m_Coords = new( this ) SGCOORDS( this );
+        m_Coords->readName( name );
 
         if( !m_Coords->ReadCache( aFile, this ) )
         {
@@ -757,7 +706,7 @@ bool SGFACESET::ReadCache( std::ifstream& aFile, SGNODE* parentNode )
             return false;
         }
 
-        SGNODE* np = FindNode( name.c_str(), this );
+        SGNODE* np = findReadNode( name );
 
         if( !np )
         {
@@ -804,8 +753,8 @@ bool SGFACESET::ReadCache( std::ifstream& aFile, SGNODE* parentNode )
             return false;
         }
 
-        m_CoordIndices = new SGCOORDINDEX( this );
-        m_CoordIndices->SetName( name.c_str() );
+        m_CoordIndices = new( this ) SGCOORDINDEX( this );
+        m_CoordIndices->readName( name );
 
         if( !m_CoordIndices->ReadCache( aFile, this ) )
         {
@@ -836,8 +785,8 @@ bool SGFACESET::ReadCache( std::ifstream& aFile, SGNODE* parentNode )
             return false;
         }
 
-        m_Normals = new SGNORMALS( this );
-        m_Normals->SetName( name.c_str() );
+        m_Normals = new( this ) SGNORMALS( this );
+        m_Normals->readName( name );
 
         if( !m_Normals->ReadCache( aFile, this ) )
         {
@@ -868,7 +817,7 @@ bool SGFACESET::ReadCache( std::ifstream& aFile, SGNODE* parentNode )
             return false;
         }
 
-        SGNODE* np = FindNode( name.c_str(), this );
+        SGNODE* np = findReadNode( name );
 
         if( !np )
         {
@@ -915,8 +864,8 @@ bool SGFACESET::ReadCache( std::ifstream& aFile, SGNODE* parentNode )
             return false;
         }
 
-        m_Colors = new SGCOLORS( this );
-        m_Colors->SetName( name.c_str() );
+        m_Colors = new( this ) SGCOLORS( this );
+        m_Colors->readName( name );
 
         if( !m_Colors->ReadCache( aFile, this ) )
         {
@@ -947,7 +896,7 @@ bool SGFACESET::ReadCache( std::ifstream& aFile, SGNODE* parentNode )
             return false;
         }
 
-        SGNODE* np = FindNode( name.c_str(), this );
+        SGNODE* np = findReadNode( name );
 
         if( !np )
         {
@@ -986,11 +935,24 @@ bool SGFACESET::ReadCache( std::ifstream& aFile, SGNODE* parentNode )
 }
 
 
-bool SGFACESET::validate( void )
+bool SGFACESET::validate( void ) const
+{
+    int validity = m_Validity.load( std::memory_order_acquire );
+
+    if( SGVALID_UNKNOWN != validity )
+        return SGVALID_YES == validity;
+
+    // concurrent readers may each check the data; they all store the same result
+    bool ok = checkData();
+    m_Validity.store( ok ? SGVALID_YES : SGVALID_NO, std::memory_order_release );
+
+    return ok;
+}
+
+
+bool SGFACESET::checkData( void ) const
 {
     // verify the integrity of this object's data
-    if( validated )
-        return valid;
 
     // ensure we have at least coordinates and their normals
     if( (NULL == m_Coords && NULL == m_RCoords)
@@ -1003,8 +965,6 @@ bool SGFACESET::validate( void )
         ostr << " * [INFO] bad model; no vertices, vertex indices, or normals";
         wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
 #endif
-        validated = true;
-        valid = false;
         return false;
     }
 
@@ -1014,9 +974,7 @@ bool SGFACESET::validate( void )
     if( NULL == coords )
         coords = m_RCoords;
 
-    size_t nCoords = 0;
-    SGPOINT* lCoords = NULL;
-    coords->GetCoordsList( nCoords, lCoords );
+    size_t nCoords = coords->GetSize();
 
     if( nCoords < 3 )
     {
@@ -1026,8 +984,6 @@ bool SGFACESET::validate( void )
         ostr << " * [INFO] bad model; fewer than 3 vertices";
         wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
 #endif
-        validated = true;
-        valid = false;
         return false;
     }
 
@@ -1044,8 +1000,6 @@ bool SGFACESET::validate( void )
         ostr << " * [INFO] bad model; no vertex indices or not multiple of 3";
         wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
 #endif
-        validated = true;
-        valid = false;
         return false;
     }
 
@@ -1060,21 +1014,17 @@ bool SGFACESET::validate( void )
             ostr << " * [INFO] bad model; vertex index out of bounds";
             wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
 #endif
-            validated = true;
-            valid = false;
             return false;
         }
     }
 
     // check that there are as many normals as vertices
-    size_t nNorms = 0;
-    SGVECTOR* lNorms = NULL;
     SGNORMALS* pNorms = m_Normals;
 
     if( NULL == pNorms )
         pNorms = m_RNormals;
 
-    pNorms->GetNormalList( nNorms, lNorms );
+    size_t nNorms = pNorms->GetSize();
 
     if( nNorms != nCoords )
     {
@@ -1085,8 +1035,6 @@ bool SGFACESET::validate( void )
         ostr << ") does not match number of vertices (" << nCoords << ")";
         wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
 #endif
-        validated = true;
-        valid = false;
         return false;
     }
 
@@ -1104,8 +1052,6 @@ bool SGFACESET::validate( void )
         pColors->GetColorList( nColor, pColor );
     }
 
-    validated = true;
-    valid = true;
     return true;
 }
 
@@ -1126,13 +1072,13 @@ bool SGFACESET::CalcNormals( SGNODE** aPtr )
     if( m_RCoords )
         coords = m_RCoords;
 
-    if( NULL == coords || coords->coords.empty() )
+    if( NULL == coords || 0 == coords->GetSize() )
         return false;
 
-    if( m_Normals && !m_Normals->norms.empty( ) )
+    if( m_Normals && 0 != m_Normals->GetSize() )
         return true;
 
-    if( m_RNormals && !m_RNormals->norms.empty( ) )
+    if( m_RNormals && 0 != m_RNormals->GetSize() )
         return true;
 
     return coords->CalcNormals( this, aPtr );
@@ -30,6 +30,7 @@
 #ifndef SG_FACESET_H
 #define SG_FACESET_H
 
+#include <atomic>
 #include <vector>
 #include "3d_cache/sg/sg_node.h"
 
@@ -43,8 +44,11 @@ class SGCOORDINDEX;
 class SGFACESET : public SGNODE
 {
 private:
-    bool valid;
-    bool validated;
+    // result of validate(); it is held atomically since a face set shared by a
+    // scene graph may be validated by several reader threads at once
+    mutable std::atomic< int > m_Validity;
+
+    bool checkData( void ) const;
     void unlinkNode( const SGNODE* aNode, bool isChild );
     bool addNode( SGNODE* aNode, bool isChild );
 
@@ -62,8 +66,9 @@ public:
 
     void unlinkChildNode( const SGNODE* aNode );
     void unlinkRefNode( const SGNODE* aNode );
-    // validate the data held by this face set
-    bool validate( void );
+    // validate the data held by this face set; the result is retained
+    // until a node is added to or removed from this one
+    bool validate( void ) const;
 
 public:
     SGFACESET( SGNODE* aParent );
@@ -77,10 +82,12 @@ public:
 
     bool CalcNormals( SGNODE** aPtr );
 
-    void ReNameNodes( void );
-    bool WriteVRML( std::ofstream& aFile, bool aReuseFlag );
+    // returns the bounds of the coordinates of this face set
+    bool GetBounds( SGBOUNDS& aBounds ) const;
+
+    bool WriteVRML( std::ofstream& aFile, bool aReuseFlag, SGWRITE& aState ) const;
 
-    bool WriteCache( std::ofstream& aFile, SGNODE* parentNode );
+    bool WriteCache( std::ofstream& aFile, SGWRITE& aState ) const;
     bool ReadCache( std::ifstream& aFile, SGNODE* parentNode );
 
     /**
@@ -190,6 +190,19 @@ bool S3D::WriteVector( std::ofstream& aFile, const SGVECTOR& aVector )
 }
 
 
+bool S3D::WriteLanes( std::ofstream& aFile, const SGLANES& aLanes, size_t aIndex )
+{
+    aFile.write( (char*)&aLanes.x[aIndex], sizeof(float) );
+    aFile.write( (char*)&aLanes.y[aIndex], sizeof(float) );
+    aFile.write( (char*)&aLanes.z[aIndex], sizeof(float) );
+
+    if( aFile.fail() )
+        return false;
+
+    return true;
+}
+
+
 bool S3D::WriteColor( std::ofstream& aFile, const SGCOLOR& aColor )
 {
     float r, g, b;
@@ -270,7 +283,8 @@ S3D::SGTYPES S3D::ReadTag( std::ifstream& aFile, std::string& aName )
         SGTYPE_COORDS,
         SGTYPE_COORDINDEX,
         SGTYPE_NORMALS,
-        SGTYPE_SHAPE
+        SGTYPE_SHAPE,
+        SGTYPE_LINESET
     };
 
     for( int i = 0; i < S3D::SGTYPE_END; ++i )
@@ -321,6 +335,21 @@ bool S3D::ReadVector( std::ifstream& aFile, SGVECTOR& aVector )
 }
 
 
+bool S3D::ReadLanes( std::ifstream& aFile, SGLANES& aLanes )
+{
+    float x, y, z;
+    aFile.read( (char*)&x, sizeof(float) );
+    aFile.read( (char*)&y, sizeof(float) );
+    aFile.read( (char*)&z, sizeof(float) );
+
+    if( aFile.fail() )
+        return false;
+
+    aLanes.Add( x, y, z );
+    return true;
+}
+
+
 bool S3D::ReadColor( std::ifstream& aFile, SGCOLOR& aColor )
 {
     float r, g, b;
@@ -381,7 +410,7 @@ static void calcTriad( glm::dvec3* pts, glm::dvec3& tri )
 }
 
 
-bool S3D::CalcTriangleNormals( std::vector< SGPOINT > coords,
+bool S3D::CalcTriangleNormals( const std::vector< SGPOINT >& coords,
     std::vector< int >& index, std::vector< SGVECTOR >& norms )
 {
     size_t vsize = coords.size();
@@ -537,3 +566,34 @@ bool S3D::CalcTriangleNormals( std::vector< SGPOINT > coords,
 
     return true;
 }
+
+
+void S3D::TransformLanes( const glm::dmat4& aTransform, double aW, const SGLANES& aLanes,
+                          SFVEC3F* aResult )
+{
+    // glm matrices are indexed [column][row]
+    const double m00 = aTransform[0][0], m01 = aTransform[1][0], m02 = aTransform[2][0];
+    const double m10 = aTransform[0][1], m11 = aTransform[1][1], m12 = aTransform[2][1];
+    const double m20 = aTransform[0][2], m21 = aTransform[1][2], m22 = aTransform[2][2];
+    const double t0 = aTransform[3][0] * aW;
+    const double t1 = aTransform[3][1] * aW;
+    const double t2 = aTransform[3][2] * aW;
+
+    const float* px = aLanes.x.data();
+    const float* py = aLanes.y.data();
+    const float* pz = aLanes.z.data();
+    size_t n = aLanes.Size();
+
+    for( size_t i = 0; i < n; ++i )
+    {
+        double x = px[i];
+        double y = py[i];
+        double z = pz[i];
+
+        aResult[i].x = (float)( m00 * x + m01 * y + m02 * z + t0 );
+        aResult[i].y = (float)( m10 * x + m11 * y + m12 * z + t1 );
+        aResult[i].z = (float)( m20 * x + m21 * y + m22 * z + t2 );
+    }
+
+    return;
+}
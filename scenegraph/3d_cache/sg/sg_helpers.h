@@ -33,25 +33,41 @@
 #define SG_HELPERS_H
 
 #include <fstream>
+#include <new>
 #include <string>
 #include <algorithm>
 #include <vector>
+#include <unordered_map>
+#include <unordered_set>
 #include "plugins/3dapi/sg_base.h"
 #include "plugins/3dapi/sg_types.h"
+#include "plugins/3dapi/xv3d_types.h"
 #include <glm/glm.hpp>
 
+class SGNODE;
 class SGNORMALS;
 class SGCOORDS;
 class SGCOORDINDEX;
 
+// Note: the list macros below require the node to map each of its owned
+// and referenced nodes to the node's position within its list in a member
+// 'm_Links' so that nodes are found and removed without searching the lists.
+// An unlinked node leaves an empty (NULL) slot so that the order of the
+// remaining nodes is kept; the slots are counted in a member 'm_Holes' and
+// removed by a member 'compactLists()'. Users of the lists skip such slots.
+
 // Function to drop references within an SGNODE
 // The node being destroyed must remove itself from the object reference's
-// backpointer list in order to avoid a segfault.
+// backpointer list in order to avoid a segfault. References to nodes which
+// are released along with the same arena are left alone.
 #define DROP_REFS( aType, aList ) do { \
         std::vector< aType* >::iterator sL = aList.begin(); \
         std::vector< aType* >::iterator eL = aList.end(); \
         while( sL != eL ) { \
-            ((SGNODE*)*sL)->delNodeRef( this ); \
+            if( NULL != *sL && !isReleased( *sL ) ) { \
+                ((SGNODE*)*sL)->delNodeRef( this ); \
+                m_Links.erase( *sL ); \
+            } \
             ++sL; \
         } \
         aList.clear(); \
@@ -60,13 +76,18 @@ class SGCOORDINDEX;
 
 // Function to delete owned objects within an SGNODE
 // The owned object's parent is set to NULL before
-// deletion to avoid a redundant 'unlinkChildNode' call.
+// deletion to avoid a redundant 'unlinkChildNode' call. Objects
+// which are released along with the same arena are destroyed
+// by the arena.
 #define DEL_OBJS( aType, aList ) do { \
         std::vector< aType* >::iterator sL = aList.begin(); \
         std::vector< aType* >::iterator eL = aList.end(); \
         while( sL != eL ) { \
-            ((SGNODE*)*sL)->SetParent( NULL, false ); \
-            delete *sL; \
+            if( NULL != *sL && !isReleased( *sL ) ) { \
+                ((SGNODE*)*sL)->SetParent( NULL, false ); \
+                m_Links.erase( *sL ); \
+                delete *sL; \
+            } \
             ++sL; \
         } \
         aList.clear(); \
@@ -74,36 +95,23 @@ class SGCOORDINDEX;
 
 
 // Function to unlink a child or reference node when that child or
-// reference node is being destroyed.
+// reference node is being destroyed. The slot of the node is cleared and
+// the lists are compacted once they hold more empty slots than nodes.
 #define UNLINK_NODE( aNodeID, aType, aNode, aOwnedList, aRefList, isChild ) do { \
         if( aNodeID == aNode->GetNodeType() ) { \
-            std::vector< aType* >* oSL; \
-            std::vector< aType* >::iterator sL; \
-            std::vector< aType* >::iterator eL; \
-            if( isChild ) { \
-                oSL = &aOwnedList; \
-                sL =  aOwnedList.begin(); \
-                eL =  aOwnedList.end(); \
-                while( sL != eL ) { \
-                    if( (SGNODE*)*sL == aNode ) { \
-                        oSL->erase( sL ); \
-                        return; \
-                    } \
-                    ++sL; \
-                } \
-            } else { \
-                oSL = &aRefList; \
-                sL =  aRefList.begin(); \
-                eL =  aRefList.end(); \
-                while( sL != eL ) { \
-                    if( (SGNODE*)*sL == aNode ) { \
-                        delNodeRef( this ); \
-                        oSL->erase( sL ); \
-                        return; \
-                    } \
-                    ++sL; \
-                } \
-            } \
+            std::unordered_map< const SGNODE*, size_t >::iterator sLK = m_Links.find( aNode ); \
+            if( sLK == m_Links.end() ) \
+                return; \
+            std::vector< aType* >& oSL = isChild ? aOwnedList : aRefList; \
+            size_t iSL = sLK->second; \
+            if( iSL >= oSL.size() || (SGNODE*)oSL[iSL] != aNode ) \
+                return; \
+            if( !isChild ) \
+                delNodeRef( this ); \
+            oSL[iSL] = NULL; \
+            m_Links.erase( sLK ); \
+            if( ++m_Holes > m_Links.size() ) \
+                compactLists(); \
             return; \
         } } while( 0 )
 
@@ -112,11 +120,7 @@ class SGCOORDINDEX;
 // and add the node type to the reference list if applicable
 #define ADD_NODE( aNodeID, aType, aNode, aOwnedList, aRefList, isChild ) do { \
     if( aNodeID == aNode->GetNodeType() ) { \
-        std::vector< aType* >::iterator sL; \
-        sL = std::find( aOwnedList.begin(), aOwnedList.end(), aNode ); \
-        if( sL != aOwnedList.end() ) return true; \
-        sL = std::find( aRefList.begin(), aRefList.end(), aNode ); \
-        if( sL != aRefList.end() ) return true; \
+        if( m_Links.find( aNode ) != m_Links.end() ) return true; \
         if( isChild ) { \
             SGNODE* ppn = (SGNODE*)aNode->GetParent(); \
             if( NULL != ppn ) { \
@@ -124,10 +128,11 @@ class SGCOORDINDEX;
                     std::cerr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n"; \
                     std::cerr << " * [BUG] object '" << aNode->GetName(); \
                     std::cerr << "' has multiple parents '" << ppn->GetName() << "', '"; \
-                    std::cerr << m_Name << "'\n"; \
+                    std::cerr << GetName() << "'\n"; \
                     return false; \
                 } \
             } \
+            m_Links[aNode] = aOwnedList.size(); \
             aOwnedList.push_back( (aType*)aNode ); \
             aNode->SetParent( this, false ); \
         } else { \
@@ -138,6 +143,7 @@ class SGCOORDINDEX;
                 std::cerr << " * [INFO] possible copy assignment or copy constructor bug\n"; \
                 return false; \
             } \
+            m_Links[aNode] = aRefList.size(); \
             aRefList.push_back( (aType*)aNode ); \
             aNode->addNodeRef( this ); \
         } \
@@ -151,7 +157,7 @@ class SGCOORDINDEX;
     std::vector< aType* >::iterator eLA = aNodeList.end(); \
     SGNODE* psg = NULL; \
     while( sLA != eLA ) { \
-        if( (SGNODE*)*sLA != aCallingNode ) { \
+        if( NULL != *sLA && (SGNODE*)*sLA != aCallingNode ) { \
             psg = (SGNODE*) (*sLA)->FindNode( aName, this ); \
             if( NULL != psg) \
                 return psg; \
@@ -159,6 +165,120 @@ class SGCOORDINDEX;
         ++sLA; \
     } } while ( 0 )
 
+/**
+ * Class SGALIGNED_ALLOC
+ * is an allocator which aligns the storage of a std::vector so that
+ * kernels may use aligned vector loads
+ */
+template< typename T >
+class SGALIGNED_ALLOC
+{
+public:
+    typedef T value_type;
+
+    enum { ALIGNMENT = 32 };
+
+    SGALIGNED_ALLOC()
+    {
+        return;
+    }
+
+    template< typename U >
+    SGALIGNED_ALLOC( const SGALIGNED_ALLOC< U >& )
+    {
+        return;
+    }
+
+    template< typename U >
+    struct rebind
+    {
+        typedef SGALIGNED_ALLOC< U > other;
+    };
+
+    T* allocate( size_t aCount )
+    {
+        void* vp = _mm_malloc( aCount * sizeof( T ), ALIGNMENT );
+
+        if( NULL == vp )
+            throw std::bad_alloc();
+
+        return (T*) vp;
+    }
+
+    void deallocate( T* aPtr, size_t )
+    {
+        _mm_free( aPtr );
+    }
+
+    bool operator==( const SGALIGNED_ALLOC& ) const
+    {
+        return true;
+    }
+
+    bool operator!=( const SGALIGNED_ALLOC& ) const
+    {
+        return false;
+    }
+};
+
+
+typedef std::vector< float, SGALIGNED_ALLOC< float > > SGLANE;
+
+
+/**
+ * Class SGLANES
+ * holds a list of single precision points or vectors as separate x, y
+ * and z arrays (structure of arrays) so that kernels read each axis
+ * from contiguous, aligned memory
+ */
+class SGLANES
+{
+public:
+    SGLANE x;
+    SGLANE y;
+    SGLANE z;
+
+    size_t Size( void ) const
+    {
+        return x.size();
+    }
+
+    void Reserve( size_t aCount )
+    {
+        x.reserve( aCount );
+        y.reserve( aCount );
+        z.reserve( aCount );
+    }
+
+    void Add( float aX, float aY, float aZ )
+    {
+        x.push_back( aX );
+        y.push_back( aY );
+        z.push_back( aZ );
+    }
+
+    void Clear( void )
+    {
+        x.clear();
+        y.clear();
+        z.clear();
+    }
+
+    // clears the lanes and frees their memory
+    void Release( void )
+    {
+        SGLANE().swap( x );
+        SGLANE().swap( y );
+        SGLANE().swap( z );
+    }
+
+    size_t GetBytes( void ) const
+    {
+        return ( x.capacity() + y.capacity() + z.capacity() ) * sizeof( float );
+    }
+};
+
+
 namespace S3D
 {
     bool degenerate( glm::dvec3* pts );
@@ -183,7 +303,7 @@ namespace S3D
      * @param norms is an empty array which holds the normals corresponding to each vector
      * @return true on success; otherwise false.
      */
-    bool CalcTriangleNormals( std::vector< SGPOINT > coords, std::vector< int >& index,
+    bool CalcTriangleNormals( const std::vector< SGPOINT >& coords, std::vector< int >& index,
         std::vector< SGVECTOR >& norms );
 
     //
@@ -215,6 +335,9 @@ namespace S3D
     // write out a unit vector
     bool WriteVector( std::ofstream& aFile, const SGVECTOR& aVector );
 
+    // write element aIndex of a list of single precision points or vectors
+    bool WriteLanes( std::ofstream& aFile, const SGLANES& aLanes, size_t aIndex );
+
     // write out an RGB color
     bool WriteColor( std::ofstream& aFile, const SGCOLOR& aColor );
 
@@ -240,8 +363,74 @@ namespace S3D
     // read a unit vector
     bool ReadVector( std::ifstream& aFile, SGVECTOR& aVector );
 
+    // read a single precision point or vector and append it to a list
+    bool ReadLanes( std::ifstream& aFile, SGLANES& aLanes );
+
     // read an RGB color
     bool ReadColor( std::ifstream& aFile, SGCOLOR& aColor );
+
+    /**
+     * Function TransformLanes
+     * applies a transform to a list of single precision points or vectors
+     * held as lanes. The lanes are read contiguously and the loop has no
+     * dependencies between elements so that it is vectorized by the compiler.
+     *
+     * @param aTransform is the transform to apply
+     * @param aW is 1 to transform points or 0 to transform vectors
+     * @param aLanes is the list of points or vectors
+     * @param aResult receives aLanes.Size() transformed elements
+     */
+    void TransformLanes( const glm::dmat4& aTransform, double aW, const SGLANES& aLanes,
+                         SFVEC3F* aResult );
+
+    //
+    // memory accounting
+    //
+
+    // estimate the memory held by a hash table: its buckets plus one
+    // singly linked entry per element
+    template< typename T >
+    size_t HashBytes( const T& aTable )
+    {
+        return aTable.bucket_count() * sizeof( void* )
+               + aTable.size() * ( sizeof( typename T::value_type ) + sizeof( void* ) );
+    }
+
+    //
+    // list maintenance
+    //
+
+    /**
+     * Function CompactList
+     * removes the empty slots left in a list of owned or referenced nodes
+     * by unlinked nodes; the order of the remaining nodes is kept and their
+     * new positions are stored in aLinks
+     *
+     * @param aList is the list of nodes
+     * @param aLinks maps each node to its position within its list
+     */
+    template< typename T >
+    void CompactList( std::vector< T* >& aList,
+                      std::unordered_map< const SGNODE*, size_t >& aLinks )
+    {
+        size_t j = 0;
+
+        for( size_t i = 0; i < aList.size(); ++i )
+        {
+            if( NULL == aList[i] )
+                continue;
+
+            if( i != j )
+            {
+                aList[j] = aList[i];
+                aLinks[aList[j]] = j;
+            }
+
+            ++j;
+        }
+
+        aList.resize( j );
+    }
 };
 
 #endif  // SG_HELPERS_H
@@ -24,6 +24,7 @@
 #include <fstream>
 #include <iostream>
 #include <sstream>
+#include <utility>
 #include <wx/log.h>
 
 #include "3d_cache/sg/sg_index.h"
@@ -31,7 +32,8 @@
 
 SGINDEX::SGINDEX( SGNODE* aParent ) : SGNODE( aParent )
 {
-    if( NULL != aParent && S3D::SGTYPE_FACESET != aParent->GetNodeType() )
+    if( NULL != aParent && S3D::SGTYPE_FACESET != aParent->GetNodeType()
+        && S3D::SGTYPE_LINESET != aParent->GetNodeType() )
     {
         m_Parent = NULL;
 
@@ -72,8 +74,9 @@ bool SGINDEX::SetParent( SGNODE* aParent, bool notify )
             return true;
     }
 
-    // only a SGFACESET may be parent to a SGINDEX and derived types
-    if( NULL != aParent && S3D::SGTYPE_FACESET != aParent->GetNodeType() )
+    // only a SGFACESET or SGLINESET may be parent to a SGINDEX and derived types
+    if( NULL != aParent && S3D::SGTYPE_FACESET != aParent->GetNodeType()
+        && S3D::SGTYPE_LINESET != aParent->GetNodeType() )
         return false;
 
     m_Parent = aParent;
@@ -90,7 +93,7 @@ SGNODE* SGINDEX::FindNode(const char *aNodeName, const SGNODE *aCaller)
     if( NULL == aNodeName || 0 == aNodeName[0] )
         return NULL;
 
-    if( !m_Name.compare( aNodeName ) )
+    if( isNamed( aNodeName ) )
         return this;
 
     return NULL;
@@ -166,48 +169,66 @@ bool SGINDEX::GetIndices( size_t& nIndices, int*& aIndexList )
 
 void SGINDEX::SetIndices( size_t nIndices, int* aIndexList )
 {
-    index.clear();
-
     if( 0 == nIndices || NULL == aIndexList )
+    {
+        index.clear();
         return;
+    }
 
-    for( size_t i = 0; i < nIndices; ++i )
-        index.push_back( aIndexList[i] );
-
+    index.assign( aIndexList, aIndexList + nIndices );
     return;
 }
 
 
-void SGINDEX::AddIndex( int aIndex )
+void SGINDEX::SetIndices( std::vector< int >&& aIndexList )
 {
-    index.push_back( aIndex );
+    index = std::move( aIndexList );
     return;
 }
 
 
-void SGINDEX::ReNameNodes( void )
+void SGINDEX::AddIndex( int aIndex )
 {
-    m_written = false;
-
-    // rename this node
-    m_Name.clear();
-    GetName();
+    index.push_back( aIndex );
+    return;
 }
 
 
-bool SGINDEX::WriteVRML( std::ofstream& aFile, bool aReuseFlag )
+bool SGINDEX::WriteVRML( std::ofstream& aFile, bool aReuseFlag, SGWRITE& aState ) const
 {
     if( index.empty() )
         return false;
 
     if( S3D::SGTYPE_COORDINDEX == m_SGtype )
+    {
+        if( NULL != m_Parent && S3D::SGTYPE_LINESET == m_Parent->GetNodeType() )
+            return writeLineIndex( aFile );
+
         return writeCoordIndex( aFile );
+    }
 
     return writeColorIndex( aFile );
 }
 
 
-bool SGINDEX::writeCoordIndex( std::ofstream& aFile )
+bool SGINDEX::writeCoordIndex( std::ofstream& aFile ) const
+{
+    return writeTriangleIndex( aFile, "coordIndex", NULL );
+}
+
+
+bool SGINDEX::WriteColorIndex( std::ofstream& aFile,
+    const std::vector< int >& aIndexMap ) const
+{
+    if( index.empty() )
+        return false;
+
+    return writeTriangleIndex( aFile, "colorIndex", &aIndexMap );
+}
+
+
+bool SGINDEX::writeTriangleIndex( std::ofstream& aFile, const char* aFieldName,
+    const std::vector< int >* aIndexMap ) const
 {
     size_t n = index.size();
 
@@ -223,7 +244,26 @@ bool SGINDEX::writeCoordIndex( std::ofstream& aFile )
         return false;
     }
 
-    aFile << " coordIndex [\n  ";
+    if( NULL != aIndexMap )
+    {
+        for( size_t i = 0; i < n; ++i )
+        {
+            if( index[i] < 0 || (size_t)index[i] >= aIndexMap->size() )
+            {
+                #ifdef DEBUG
+                std::ostringstream ostr;
+                ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
+                ostr << " * [INFO] bad model; index " << index[i];
+                ostr << " has no entry in the index map";
+                wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
+                #endif
+
+                return false;
+            }
+        }
+    }
+
+    aFile << " " << aFieldName << " [\n  ";
 
     // indices to control formatting
     int nv0 = 0;
@@ -231,7 +271,11 @@ bool SGINDEX::writeCoordIndex( std::ofstream& aFile )
 
     for( size_t i = 0; i < n; )
     {
-        aFile << index[i];
+        if( NULL != aIndexMap )
+            aFile << (*aIndexMap)[index[i]];
+        else
+            aFile << index[i];
+
         ++i;
 
         if( ++nv0 == 3 )
@@ -259,14 +303,22 @@ bool SGINDEX::writeCoordIndex( std::ofstream& aFile )
 }
 
 
-bool SGINDEX::writeColorIndex( std::ofstream& aFile )
+bool SGINDEX::writeLineIndex( std::ofstream& aFile ) const
+{
+    // polylines are already delimited by -1 so the list is written as-is
+    aFile << " coordIndex [\n  ";
+    return writeIndexList( aFile );
+}
+
+
+bool SGINDEX::writeColorIndex( std::ofstream& aFile ) const
 {
     aFile << " colorIndex [\n  ";
     return writeIndexList( aFile );
 }
 
 
-bool SGINDEX::writeIndexList( std::ofstream& aFile )
+bool SGINDEX::writeIndexList( std::ofstream& aFile ) const
 {
     // index to control formatting
     int nv = 0;
@@ -295,48 +347,8 @@ bool SGINDEX::writeIndexList( std::ofstream& aFile )
 }
 
 
-bool SGINDEX::WriteCache( std::ofstream& aFile, SGNODE* parentNode )
+bool SGINDEX::WriteCache( std::ofstream& aFile, SGWRITE& aState ) const
 {
-    if( NULL == parentNode )
-    {
-        if( NULL == m_Parent )
-        {
-            #ifdef DEBUG
-            std::ostringstream ostr;
-            ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
-            ostr << " * [BUG] corrupt data; m_aParent is NULL";
-            wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
-            #endif
-
-            return false;
-        }
-
-        SGNODE* np = m_Parent;
-
-        while( NULL != np->GetParent() )
-            np = np->GetParent();
-
-        if( np->WriteCache( aFile, NULL ) )
-        {
-            m_written = true;
-            return true;
-        }
-
-        return false;
-    }
-
-    if( parentNode != m_Parent )
-    {
-        #ifdef DEBUG
-        std::ostringstream ostr;
-        ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
-        ostr << " * [BUG] corrupt data; parentNode != m_aParent";
-        wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
-        #endif
-
-        return false;
-    }
-
     if( !aFile.good() )
     {
         #ifdef DEBUG
@@ -349,7 +361,8 @@ bool SGINDEX::WriteCache( std::ofstream& aFile, SGNODE* parentNode )
         return false;
     }
 
-    aFile << "[" << GetName() << "]";
+    aState.SetWritten( this );
+    aFile << "[" << aState.Name( this ) << "]";
     size_t npts = index.size();
     aFile.write( (char*)&npts, sizeof(size_t) );
 
@@ -359,7 +372,6 @@ bool SGINDEX::WriteCache( std::ofstream& aFile, SGNODE* parentNode )
     if( aFile.fail() )
         return false;
 
-    m_written = true;
     return true;
 }
 
@@ -35,9 +35,12 @@
 class SGINDEX : public SGNODE
 {
 protected:
-    bool writeCoordIndex( std::ofstream& aFile );
-    bool writeColorIndex( std::ofstream& aFile );
-    bool writeIndexList( std::ofstream& aFile );
+    bool writeCoordIndex( std::ofstream& aFile ) const;
+    bool writeTriangleIndex( std::ofstream& aFile, const char* aFieldName,
+        const std::vector< int >* aIndexMap ) const;
+    bool writeLineIndex( std::ofstream& aFile ) const;
+    bool writeColorIndex( std::ofstream& aFile ) const;
+    bool writeIndexList( std::ofstream& aFile ) const;
 
 public:
     // for internal SG consumption only
@@ -78,6 +81,12 @@ public:
      */
     void SetIndices( size_t nIndices, int* aIndexList );
 
+    /**
+     * Function SetIndices
+     * takes over the given index data without copying it.
+     */
+    void SetIndices( std::vector< int >&& aIndexList );
+
 
     /**
      * Function AddIndex
@@ -88,10 +97,19 @@ public:
      */
     void AddIndex( int aIndex );
 
-    void ReNameNodes( void );
-    bool WriteVRML( std::ofstream& aFile, bool aReuseFlag );
+    /**
+     * Function WriteColorIndex
+     * writes a colorIndex which parallels this triangle coordinate index;
+     * each coordinate index is written as its entry in aIndexMap
+     *
+     * @param aIndexMap [in] the palette entry of each vertex color
+     * @return true on success
+     */
+    bool WriteColorIndex( std::ofstream& aFile, const std::vector< int >& aIndexMap ) const;
+
+    bool WriteVRML( std::ofstream& aFile, bool aReuseFlag, SGWRITE& aState ) const;
 
-    bool WriteCache( std::ofstream& aFile, SGNODE* parentNode );
+    bool WriteCache( std::ofstream& aFile, SGWRITE& aState ) const;
     bool ReadCache( std::ifstream& aFile, SGNODE* parentNode );
 };
 
@@ -0,0 +1,654 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2016 Cirilo Bernardo <cirilo.bernardo@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+
+#include <iostream>
+#include <sstream>
+#include <wx/log.h>
+
+#include "3d_cache/sg/sg_lineset.h"
+#include "3d_cache/sg/sg_coords.h"
+#include "3d_cache/sg/sg_coordindex.h"
+#include "3d_cache/sg/sg_helpers.h"
+
+SGLINESET::SGLINESET( SGNODE* aParent ) : SGNODE( aParent )
+{
+    m_SGtype = S3D::SGTYPE_LINESET;
+    m_Coords = NULL;
+    m_CoordIndices = NULL;
+    m_RCoords = NULL;
+    m_Validity = SGVALID_UNKNOWN;
+
+    if( NULL != aParent && S3D::SGTYPE_SHAPE != aParent->GetNodeType() )
+    {
+        m_Parent = NULL;
+
+#ifdef DEBUG
+        std::ostringstream ostr;
+        ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
+        ostr << " * [BUG] inappropriate parent to SGLINESET (type ";
+        ostr << aParent->GetNodeType() << ")";
+        wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
+#endif
+    }
+    else if( NULL != aParent && S3D::SGTYPE_SHAPE == aParent->GetNodeType() )
+    {
+        m_Parent->AddChildNode( this );
+    }
+
+    return;
+}
+
+
+SGLINESET::~SGLINESET()
+{
+    // drop references
+    if( m_RCoords && !isReleased( m_RCoords ) )
+    {
+        m_RCoords->delNodeRef( this );
+        m_RCoords = NULL;
+    }
+
+    // delete owned objects
+    if( m_Coords && !isReleased( m_Coords ) )
+    {
+        m_Coords->SetParent( NULL, false );
+        delete m_Coords;
+        m_Coords = NULL;
+    }
+
+    if( m_CoordIndices && !isReleased( m_CoordIndices ) )
+    {
+        m_CoordIndices->SetParent( NULL, false );
+        delete m_CoordIndices;
+        m_CoordIndices = NULL;
+    }
+
+    return;
+}
+
+
+bool SGLINESET::SetParent( SGNODE* aParent, bool notify )
+{
+    if( NULL != m_Parent )
+    {
+        if( aParent == m_Parent )
+            return true;
+
+        // handle the change in parents
+        if( notify )
+            m_Parent->unlinkChildNode( this );
+
+        m_Parent = NULL;
+
+        if( NULL == aParent )
+            return true;
+    }
+
+    // only a SGSHAPE may be parent to a SGLINESET
+    if( NULL != aParent && S3D::SGTYPE_SHAPE != aParent->GetNodeType() )
+        return false;
+
+    m_Parent = aParent;
+
+    if( m_Parent )
+        m_Parent->AddChildNode( this );
+
+    return true;
+}
+
+
+SGNODE* SGLINESET::FindNode(const char *aNodeName, const SGNODE *aCaller)
+{
+    if( NULL == aNodeName || 0 == aNodeName[0] )
+        return NULL;
+
+    if( isNamed( aNodeName ) )
+        return this;
+
+    SGNODE* np = NULL;
+
+    if( m_Coords )
+    {
+        np = m_Coords->FindNode( aNodeName, this );
+
+        if( np )
+            return np;
+    }
+
+    if( m_CoordIndices )
+    {
+        np = m_CoordIndices->FindNode( aNodeName, this );
+
+        if( np )
+            return np;
+    }
+
+    // query the parent if appropriate
+    if( aCaller == m_Parent || NULL == m_Parent )
+        return NULL;
+
+    return m_Parent->FindNode( aNodeName, this );
+}
+
+
+void SGLINESET::unlinkNode( const SGNODE* aNode, bool isChild )
+{
+    if( NULL == aNode )
+        return;
+
+    m_Validity = SGVALID_UNKNOWN;
+
+    if( S3D::SGTYPE_COORDS == aNode->GetNodeType() )
+        invalidateBounds();
+
+    if( isChild )
+    {
+        if( aNode == m_Coords )
+        {
+            m_Coords = NULL;
+            return;
+        }
+
+        if( aNode == m_CoordIndices )
+        {
+            m_CoordIndices = NULL;
+            return;
+        }
+    }
+    else
+    {
+        if( aNode == m_RCoords )
+        {
+            m_RCoords = NULL;
+            return;
+        }
+    }
+
+    #ifdef DEBUG
+    do {
+        std::ostringstream ostr;
+        ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
+        ostr << " * [BUG] unlinkNode() did not find its target";
+        wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
+    } while( 0 );
+    #endif
+
+    return;
+}
+
+
+void SGLINESET::unlinkChildNode( const SGNODE* aNode )
+{
+    unlinkNode( aNode, true );
+    return;
+}
+
+
+void SGLINESET::unlinkRefNode( const SGNODE* aNode )
+{
+    unlinkNode( aNode, false );
+    return;
+}
+
+
+bool SGLINESET::addNode( SGNODE* aNode, bool isChild )
+{
+    if( NULL == aNode )
+    {
+        #ifdef DEBUG
+        std::ostringstream ostr;
+        ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
+        ostr << " * [BUG] NULL pointer passed for aNode";
+        wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
+        #endif
+
+        return false;
+    }
+
+    m_Validity = SGVALID_UNKNOWN;
+
+    if( S3D::SGTYPE_COORDS == aNode->GetNodeType() )
+        invalidateBounds();
+
+    if( S3D::SGTYPE_COORDS == aNode->GetNodeType() )
+    {
+        if( m_Coords || m_RCoords )
+        {
+            if( aNode != m_Coords && aNode != m_RCoords )
+            {
+                #ifdef DEBUG
+                std::ostringstream ostr;
+                ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
+                ostr << " * [BUG] assigning multiple Coords nodes";
+                wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
+                #endif
+
+                return false;
+            }
+
+            return true;
+        }
+
+        // coordinates owned by a face set cannot be shared with a line set
+        // since the owner must be able to adopt the node when writing a cache
+        if( !isChild && NULL != aNode->GetParent()
+            && S3D::SGTYPE_LINESET != aNode->GetParent()->GetNodeType() )
+        {
+            #ifdef DEBUG
+            std::ostringstream ostr;
+            ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
+            ostr << " * [BUG] referenced Coords node is not owned by a LineSet";
+            wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
+            #endif
+
+            return false;
+        }
+
+        if( isChild )
+        {
+            m_Coords = (SGCOORDS*)aNode;
+            m_Coords->SetParent( this );
+        }
+        else
+        {
+            m_RCoords = (SGCOORDS*)aNode;
+            m_RCoords->addNodeRef( this );
+        }
+
+        return true;
+    }
+
+    if( S3D::SGTYPE_COORDINDEX == aNode->GetNodeType() )
+    {
+        if( m_CoordIndices )
+        {
+            if( aNode != m_CoordIndices )
+            {
+                #ifdef DEBUG
+                std::ostringstream ostr;
+                ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
+                ostr << " * [BUG] assigning multiple CoordIndex nodes";
+                wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
+                #endif
+
+                return false;
+            }
+
+            return true;
+        }
+
+        m_CoordIndices = (SGCOORDINDEX*)aNode;
+        m_CoordIndices->SetParent( this );
+
+        return true;
+    }
+
+    #ifdef DEBUG
+    do {
+        std::ostringstream ostr;
+        ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
+        ostr << " * [BUG] object '" << aNode->GetName();
+        ostr << "' (type " << aNode->GetNodeType();
+        ostr << ") is not a valid type for this object (" << m_SGtype << ")";
+        wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
+    } while( 0 );
+    #endif
+
+    return false;
+}
+
+
+bool SGLINESET::GetBounds( SGBOUNDS& aBounds ) const
+{
+    SGCOORDS* pc = m_Coords ? m_Coords : m_RCoords;
+
+    if( NULL == pc )
+        return SGNODE::GetBounds( aBounds );
+
+    return pc->GetBounds( aBounds );
+}
+
+
+bool SGLINESET::AddRefNode( SGNODE* aNode )
+{
+    return addNode( aNode, false );
+}
+
+
+bool SGLINESET::AddChildNode( SGNODE* aNode )
+{
+    return addNode( aNode, true );
+}
+
+
+bool SGLINESET::WriteVRML( std::ofstream& aFile, bool aReuseFlag, SGWRITE& aState ) const
+{
+    if( ( NULL == m_Coords && NULL == m_RCoords )
+        || ( NULL == m_CoordIndices ) )
+    {
+        return false;
+    }
+
+    if( aReuseFlag )
+    {
+        if( aState.SetWritten( this ) )
+        {
+            aFile << " geometry DEF " << aState.Name( this ) << " IndexedLineSet {\n";
+        }
+        else
+        {
+            aFile << "USE " << aState.Name( this ) << "\n";
+            return true;
+        }
+    }
+    else
+    {
+        aFile << " geometry IndexedLineSet {\n";
+    }
+
+    if( m_Coords )
+        m_Coords->WriteVRML( aFile, aReuseFlag, aState );
+
+    if( m_RCoords )
+        m_RCoords->WriteVRML( aFile, aReuseFlag, aState );
+
+    if( m_CoordIndices )
+        m_CoordIndices->WriteVRML( aFile, aReuseFlag, aState );
+
+    aFile << "}\n";
+
+    return true;
+}
+
+
+bool SGLINESET::WriteCache( std::ofstream& aFile, SGWRITE& aState ) const
+{
+    if( !aFile.good() )
+    {
+        #ifdef DEBUG
+        std::ostringstream ostr;
+        ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
+        ostr << " * [INFO] bad stream";
+        wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
+        #endif
+
+        return false;
+    }
+
+    // a referenced node which hadn't been written is written in full
+    // and a child which had already been written is written as a reference
+    const SGCOORDS* coords = m_Coords ? m_Coords : m_RCoords;
+
+    aState.SetWritten( this );
+    aFile << "[" << aState.Name( this ) << "]";
+    #define NITEMS 3
+    bool items[NITEMS];
+
+    items[0] = NULL != coords && !aState.IsWritten( coords );
+    items[1] = NULL != coords && !items[0];
+    items[2] = NULL != m_CoordIndices;
+
+    for( int i = 0; i < NITEMS; ++i )
+        aFile.write( (char*)&items[i], sizeof(bool) );
+
+    if( items[0] )
+        coords->WriteCache( aFile, aState );
+
+    if( items[1] )
+        aFile << "[" << aState.Name( coords ) << "]";
+
+    if( items[2] )
+        m_CoordIndices->WriteCache( aFile, aState );
+
+    if( aFile.fail() )
+        return false;
+
+    return true;
+}
+
+
+bool SGLINESET::ReadCache( std::ifstream& aFile, SGNODE* parentNode )
+{
+    if( m_Coords || m_RCoords || m_CoordIndices )
+    {
+        #ifdef DEBUG
+        std::ostringstream ostr;
+        ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
+        ostr << " * [BUG] non-empty node";
+        wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
+        #endif
+
+        return false;
+    }
+
+    #define NITEMS 3
+    bool items[NITEMS];
+
+    for( int i = 0; i < NITEMS; ++i )
+        aFile.read( (char*)&items[i], sizeof(bool) );
+
+    if( items[0] && items[1] )
+    {
+        #ifdef DEBUG
+        std::ostringstream ostr;
+        ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
+        ostr << " * [INFO] corrupt data; multiple item definitions at position ";
+        ostr << aFile.tellg();
+        wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
+        #endif
+
+        return false;
+    }
+
+    std::string name;
+
+    if( items[0] )
+    {
+        if( S3D::SGTYPE_COORDS != S3D::ReadTag( aFile, name ) )
+        {
+            #ifdef DEBUG
+            std::ostringstream ostr;
+            ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
+            ostr << " * [INFO] corrupt data; bad child coords tag at position ";
+            ostr << aFile.tellg();
+            wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
+            #endif
+
+            return false;
+        }
+
+        m_Coords = new( this ) SGCOORDS( this );
+        m_Coords->readName( name );
+
+        if( !m_Coords->ReadCache( aFile, this ) )
+        {
+            #ifdef DEBUG
+            std::ostringstream ostr;
+            ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
+            ostr << " * [INFO] corrupt data while reading coords '";
+            ostr << name << "'";
+            wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
+            #endif
+
+            return false;
+        }
+    }
+
+    if( items[1] )
+    {
+        if( S3D::SGTYPE_COORDS != S3D::ReadTag( aFile, name ) )
+        {
+            #ifdef DEBUG
+            std::ostringstream ostr;
+            ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
+            ostr << " * [INFO] corrupt data; bad ref coords tag at position ";
+            ostr << aFile.tellg();
+            wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
+            #endif
+
+            return false;
+        }
+
+        SGNODE* np = findReadNode( name );
+
+        if( !np )
+        {
+            #ifdef DEBUG
+            std::ostringstream ostr;
+            ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
+            ostr << " * [INFO] corrupt data: cannot find ref coords '";
+            ostr << name << "'";
+            wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
+            #endif
+
+            return false;
+        }
+
+        if( S3D::SGTYPE_COORDS != np->GetNodeType() )
+        {
+            #ifdef DEBUG
+            std::ostringstream ostr;
+            ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
+            ostr << " * [INFO] corrupt data: type is not SGCOORDS '";
+            ostr << name << "'";
+            wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
+            #endif
+
+            return false;
+        }
+
+        m_RCoords = (SGCOORDS*)np;
+        m_RCoords->addNodeRef( this );
+    }
+
+    if( items[2] )
+    {
+        if( S3D::SGTYPE_COORDINDEX != S3D::ReadTag( aFile, name ) )
+        {
+            #ifdef DEBUG
+            std::ostringstream ostr;
+            ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
+            ostr << " * [INFO] corrupt data; bad coord index tag at position ";
+            ostr << aFile.tellg();
+            wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
+            #endif
+
+            return false;
+        }
+
+        m_CoordIndices = new( this ) SGCOORDINDEX( this );
+        m_CoordIndices->readName( name );
+
+        if( !m_CoordIndices->ReadCache( aFile, this ) )
+        {
+            #ifdef DEBUG
+            std::ostringstream ostr;
+            ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
+            ostr << " * [INFO] corrupt data while reading coord index '";
+            ostr << name << "'";
+            wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
+            #endif
+
+            return false;
+        }
+    }
+
+    if( aFile.fail() )
+        return false;
+
+    return true;
+}
+
+
+bool SGLINESET::validate( void ) const
+{
+    int validity = m_Validity.load( std::memory_order_acquire );
+
+    if( SGVALID_UNKNOWN != validity )
+        return SGVALID_YES == validity;
+
+    // concurrent readers may each check the data; they all store the same result
+    bool ok = checkData();
+    m_Validity.store( ok ? SGVALID_YES : SGVALID_NO, std::memory_order_release );
+
+    return ok;
+}
+
+
+bool SGLINESET::checkData( void ) const
+{
+    // verify the integrity of this object's data
+
+    // ensure we have coordinates and indices
+    if( (NULL == m_Coords && NULL == m_RCoords)
+        || (NULL == m_CoordIndices) )
+    {
+#ifdef DEBUG
+        std::ostringstream ostr;
+        ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
+        ostr << " * [INFO] bad model; no vertices or vertex indices";
+        wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
+#endif
+        return false;
+    }
+
+    SGCOORDS* coords = m_Coords;
+
+    if( NULL == coords )
+        coords = m_RCoords;
+
+    size_t nCoords = coords->GetSize();
+
+    size_t nCIdx = 0;
+    int* lCIdx = NULL;
+    m_CoordIndices->GetIndices( nCIdx, lCIdx );
+
+    if( nCoords < 2 || nCIdx < 2 )
+    {
+#ifdef DEBUG
+        std::ostringstream ostr;
+        ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
+        ostr << " * [INFO] bad model; fewer than 2 vertices or vertex indices";
+        wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
+#endif
+        return false;
+    }
+
+    // check that vertex[n] is -1 (end of polyline) or within [0, nVertices)
+    for( size_t i = 0; i < nCIdx; ++i )
+    {
+        if( lCIdx[i] < -1 || lCIdx[i] >= (int)nCoords )
+        {
+#ifdef DEBUG
+            std::ostringstream ostr;
+            ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
+            ostr << " * [INFO] bad model; vertex index out of bounds";
+            wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
+#endif
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,99 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2016 Cirilo Bernardo <cirilo.bernardo@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file sg_lineset.h
+ * defines an indexed line set for a scenegraph
+ */
+
+
+#ifndef SG_LINESET_H
+#define SG_LINESET_H
+
+#include <atomic>
+#include <vector>
+#include "3d_cache/sg/sg_node.h"
+
+
+class SGCOORDS;
+class SGCOORDINDEX;
+
+class SGLINESET : public SGNODE
+{
+private:
+    // result of validate(); it is held atomically since a line set shared by a
+    // scene graph may be validated by several reader threads at once
+    mutable std::atomic< int > m_Validity;
+
+    bool checkData( void ) const;
+    void unlinkNode( const SGNODE* aNode, bool isChild );
+    bool addNode( SGNODE* aNode, bool isChild );
+
+public:
+    // owned objects
+    SGCOORDS*       m_Coords;
+    SGCOORDINDEX*   m_CoordIndices;
+
+    // referenced objects
+    SGCOORDS*       m_RCoords;
+
+    void unlinkChildNode( const SGNODE* aNode );
+    void unlinkRefNode( const SGNODE* aNode );
+    // validate the data held by this line set; the result is retained
+    // until a node is added to or removed from this one
+    bool validate( void ) const;
+
+public:
+    SGLINESET( SGNODE* aParent );
+    virtual ~SGLINESET();
+
+    virtual bool SetParent( SGNODE* aParent, bool notify = true );
+
+    SGNODE* FindNode( const char *aNodeName, const SGNODE *aCaller );
+    bool AddRefNode( SGNODE* aNode );
+    bool AddChildNode( SGNODE* aNode );
+
+    // returns the bounds of the coordinates of this line set
+    bool GetBounds( SGBOUNDS& aBounds ) const;
+
+    bool WriteVRML( std::ofstream& aFile, bool aReuseFlag, SGWRITE& aState ) const;
+
+    bool WriteCache( std::ofstream& aFile, SGWRITE& aState ) const;
+    bool ReadCache( std::ifstream& aFile, SGNODE* parentNode );
+};
+
+/*
+    p.91
+    IndexedLineSet {
+        color               NULL
+        coord               NULL
+        colorIndex          []
+        colorPerVertex      TRUE
+        coordIndex          []
+    }
+
+    Each polyline in coordIndex is terminated by -1; the lines are
+    unlit and take their color from the Material's emissiveColor.
+*/
+
+#endif  // SG_LINESET_H
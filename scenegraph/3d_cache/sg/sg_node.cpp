@@ -22,13 +22,20 @@
  */
 
 #include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
+#include <limits>
+#include <mutex>
 #include <sstream>
 #include <wx/log.h>
 
 #include "3d_cache/sg/sg_node.h"
+#include "3d_cache/sg/sg_arena.h"
+#include "3d_cache/sg/sg_visitor.h"
+#include "3d_cache/sg/sg_helpers.h"
 #include "plugins/3dapi/c3dmodel.h"
 
 static const std::string node_names[S3D::SGTYPE_END + 1] = {
@@ -41,11 +48,15 @@ static const std::string node_names[S3D::SGTYPE_END + 1] = {
     "COORDIDX",
     "NORM",
     "SHAPE",
+    "LINES",
     "INVALID"
 };
 
 
-static unsigned int node_counts[S3D::SGTYPE_END] = { 1, 1, 1, 1, 1, 1, 1, 1, 1 };
+// source of the naming pass identifiers; each pass is unique across
+// all naming contexts so that a node renamed by one context is renamed
+// again by any other
+static std::atomic< unsigned int > name_pass( 0 );
 
 
 char const* S3D::GetNodeTypeName( S3D::SGTYPES aType )
@@ -54,20 +65,265 @@ char const* S3D::GetNodeTypeName( S3D::SGTYPES aType )
 }
 
 
-static void getNodeName( S3D::SGTYPES nodeType, std::string& aName )
+// serializes the publication of cached bounds; the bounds are computed
+// outside of the lock and only the first result is kept
+static std::mutex bounds_lock;
+
+
+SGBOUNDS::SGBOUNDS()
 {
-    if( nodeType < 0 || nodeType >= S3D::SGTYPE_END )
+    double big = std::numeric_limits< double >::max();
+    lower = glm::dvec3( big, big, big );
+    upper = glm::dvec3( -big, -big, -big );
+    return;
+}
+
+
+void SGBOUNDS::Add( double aXValue, double aYValue, double aZValue )
+{
+    if( aXValue < lower.x )
+        lower.x = aXValue;
+
+    if( aXValue > upper.x )
+        upper.x = aXValue;
+
+    if( aYValue < lower.y )
+        lower.y = aYValue;
+
+    if( aYValue > upper.y )
+        upper.y = aYValue;
+
+    if( aZValue < lower.z )
+        lower.z = aZValue;
+
+    if( aZValue > upper.z )
+        upper.z = aZValue;
+
+    return;
+}
+
+
+void SGBOUNDS::Add( const SGBOUNDS& aBounds )
+{
+    if( aBounds.IsEmpty() )
+        return;
+
+    Add( aBounds.lower.x, aBounds.lower.y, aBounds.lower.z );
+    Add( aBounds.upper.x, aBounds.upper.y, aBounds.upper.z );
+    return;
+}
+
+
+void SGBOUNDS::Add( const SGBOUNDS& aBounds, const glm::dmat4& aTransform )
+{
+    if( aBounds.IsEmpty() )
+        return;
+
+    // the transformed box is bounded by its transformed corners
+    for( int i = 0; i < 8; ++i )
     {
-        aName = node_names[S3D::SGTYPE_END];
+        glm::dvec4 pt( ( i & 1 ) ? aBounds.upper.x : aBounds.lower.x,
+                       ( i & 2 ) ? aBounds.upper.y : aBounds.lower.y,
+                       ( i & 4 ) ? aBounds.upper.z : aBounds.lower.z, 1.0 );
+        pt = aTransform * pt;
+        Add( pt.x, pt.y, pt.z );
+    }
+
+    return;
+}
+
+
+bool SGBOUNDSCACHE::Get( SGBOUNDS& aBounds ) const
+{
+    if( SGVALID_YES != m_State.load( std::memory_order_acquire ) )
+        return false;
+
+    aBounds = m_Bounds;
+    return true;
+}
+
+
+void SGBOUNDSCACHE::Set( const SGBOUNDS& aBounds ) const
+{
+    std::lock_guard< std::mutex > guard( bounds_lock );
+
+    if( SGVALID_YES == m_State.load( std::memory_order_relaxed ) )
         return;
+
+    m_Bounds = aBounds;
+    m_State.store( SGVALID_YES, std::memory_order_release );
+    return;
+}
+
+
+bool SGBOUNDSCACHE::Reset( void )
+{
+    if( SGVALID_UNKNOWN == m_State.load( std::memory_order_relaxed ) )
+        return false;
+
+    return SGVALID_UNKNOWN != m_State.exchange( SGVALID_UNKNOWN );
+}
+
+
+SGNAMES::SGNAMES()
+{
+    Reset();
+    return;
+}
+
+
+void SGNAMES::Reset( void )
+{
+    for( int i = 0; i < (int)S3D::SGTYPE_END; ++i )
+        m_Counts[i] = 1;
+
+    m_Pass = ++name_pass;
+
+    return;
+}
+
+
+unsigned int SGNAMES::Next( S3D::SGTYPES aType )
+{
+    if( aType < 0 || aType >= S3D::SGTYPE_END )
+        return 0;
+
+    return m_Counts[aType]++;
+}
+
+
+unsigned int SGNAMES::Peek( S3D::SGTYPES aType ) const
+{
+    if( aType < 0 || aType >= S3D::SGTYPE_END )
+        return 0;
+
+    return m_Counts[aType];
+}
+
+
+void SGNAMES::AddNode( const std::string& aName, SGNODE* aNode )
+{
+    m_Nodes.insert( std::pair< std::string, SGNODE* >( aName, aNode ) );
+    return;
+}
+
+
+SGNODE* SGNAMES::FindNode( const std::string& aName ) const
+{
+    std::unordered_map< std::string, SGNODE* >::const_iterator item = m_Nodes.find( aName );
+
+    if( item == m_Nodes.end() )
+        return NULL;
+
+    return item->second;
+}
+
+
+void SGNAMES::ClearNodes( void )
+{
+    std::unordered_map< std::string, SGNODE* > empty;
+    m_Nodes.swap( empty );
+    return;
+}
+
+
+std::ostream& operator<<( std::ostream& aStream, const SGNODENAME& aName )
+{
+    SGNODE* np = aName.node;
+
+    if( NULL != np->m_Name )
+        return aStream << *np->m_Name;
+
+    if( np->m_SGtype < 0 || np->m_SGtype >= S3D::SGTYPE_END )
+        return aStream << node_names[S3D::SGTYPE_END];
+
+    if( 0 == np->m_Index )
+        np->m_Index = np->GetNameContext().Next( np->m_SGtype );
+
+    return aStream << node_names[np->m_SGtype] << "_" << np->m_Index;
+}
+
+
+std::ostream& operator<<( std::ostream& aStream, const SGWRITENAME& aName )
+{
+    const SGNODE* np = aName.node;
+    SGWRITE* sp = aName.state;
+
+    if( np->m_SGtype < 0 || np->m_SGtype >= S3D::SGTYPE_END )
+        return aStream << node_names[S3D::SGTYPE_END];
+
+    if( !sp->m_Rename )
+    {
+        if( NULL != np->m_Name )
+            return aStream << *np->m_Name;
+
+        if( 0 != np->m_Index )
+            return aStream << node_names[np->m_SGtype] << "_" << np->m_Index;
     }
 
-    unsigned int seqNum = node_counts[nodeType];
-    ++node_counts[nodeType];
+    // nodes without a name are named for this write only
+    std::pair< std::unordered_map< const SGNODE*, unsigned int >::iterator, bool > item =
+        sp->m_Index.insert( std::pair< const SGNODE*, unsigned int >( np, 0 ) );
 
-    std::ostringstream ostr;
-    ostr << node_names[nodeType] << "_" << seqNum;
-    aName = ostr.str();
+    if( item.second )
+        item.first->second = sp->m_Counts[np->m_SGtype]++;
+
+    return aStream << node_names[np->m_SGtype] << "_" << item.first->second;
+}
+
+
+/**
+ * Class SGWRITENAMES
+ * generates the names of the nodes of a write in the order in
+ * which SGRENAME would rename them
+ */
+class SGWRITENAMES : public SGVISITOR
+{
+private:
+    SGWRITE& m_State;
+
+public:
+    SGWRITENAMES( SGWRITE& aState ) : m_State( aState )
+    {
+        return;
+    }
+
+    SGVISIT_ACTION Pre( const SGVISIT& aVisit )
+    {
+        S3D::SGTYPES type = aVisit.node->GetNodeType();
+
+        if( type >= 0 && type < S3D::SGTYPE_END )
+            m_State.m_Index[aVisit.node] = m_State.m_Counts[type]++;
+
+        return SGVISIT_CONTINUE;
+    }
+};
+
+
+SGWRITE::SGWRITE( SGNODE* aTopNode, bool aRename )
+{
+    m_Rename = aRename;
+
+    if( aRename || NULL == aTopNode )
+    {
+        for( int i = 0; i < (int)S3D::SGTYPE_END; ++i )
+            m_Counts[i] = 1;
+
+        if( NULL != aTopNode )
+        {
+            SGWRITENAMES names( *this );
+            S3D::Walk( aTopNode, names, SGWALK_REFS | SGWALK_ONCE );
+        }
+
+        return;
+    }
+
+    // names generated for unnamed nodes follow those already
+    // given by the naming context of the scene graph
+    const SGNAMES& context = aTopNode->PeekNameContext();
+
+    for( int i = 0; i < (int)S3D::SGTYPE_END; ++i )
+        m_Counts[i] = context.Peek( (S3D::SGTYPES)i );
 
     return;
 }
@@ -77,7 +333,9 @@ SGNODE::SGNODE( SGNODE* aParent )
 {
     m_Parent = aParent;
     m_Association = NULL;
-    m_written = false;
+    m_Name = NULL;
+    m_Index = 0;
+    m_Pass = 0;
     m_SGtype = S3D::SGTYPE_END;
 
     return;
@@ -86,18 +344,22 @@ SGNODE::SGNODE( SGNODE* aParent )
 
 SGNODE::~SGNODE()
 {
-    if( m_Parent )
+    if( m_Parent && !isReleased( m_Parent ) )
         m_Parent->unlinkChildNode( this );
 
     if( m_Association )
         *m_Association = NULL;
 
-    std::list< SGNODE* >::iterator sBP = m_BackPointers.begin();
-    std::list< SGNODE* >::iterator eBP = m_BackPointers.end();
+    delete m_Name;
+
+    std::vector< SGNODE* >::iterator sBP = m_BackPointers.begin();
+    std::vector< SGNODE* >::iterator eBP = m_BackPointers.end();
 
     while( sBP != eBP )
     {
-        (*sBP)->unlinkRefNode( this );
+        if( !isReleased( *sBP ) )
+            (*sBP)->unlinkRefNode( this );
+
         ++sBP;
     }
 
@@ -105,6 +367,59 @@ SGNODE::~SGNODE()
 }
 
 
+void* SGNODE::operator new( size_t aSize )
+{
+    return SGARENA::Alloc( aSize, NULL );
+}
+
+
+void* SGNODE::operator new( size_t aSize, SGNODE* aParent )
+{
+    if( NULL == aParent )
+        return SGARENA::Alloc( aSize, NULL );
+
+    return SGARENA::Alloc( aSize, SGARENA::Of( aParent ) );
+}
+
+
+void* SGNODE::operator new( size_t aSize, SGARENA* aArena )
+{
+    return SGARENA::Alloc( aSize, aArena );
+}
+
+
+void SGNODE::operator delete( void* aNode )
+{
+    SGARENA::Free( aNode );
+    return;
+}
+
+
+void SGNODE::operator delete( void* aNode, SGNODE* aParent )
+{
+    SGARENA::Free( aNode );
+    return;
+}
+
+
+void SGNODE::operator delete( void* aNode, SGARENA* aArena )
+{
+    SGARENA::Free( aNode );
+    return;
+}
+
+
+bool SGNODE::isReleased( const SGNODE* aNode ) const
+{
+    SGARENA* arena = SGARENA::Of( this );
+
+    if( NULL == arena || !arena->IsReleasing() )
+        return false;
+
+    return SGARENA::Of( aNode ) == arena;
+}
+
+
 S3D::SGTYPES SGNODE::GetNodeType( void ) const
 {
     return m_SGtype;
@@ -149,24 +464,224 @@ bool SGNODE::SwapParent( SGNODE* aNewParent )
 
 const char* SGNODE::GetName( void )
 {
-    if( m_Name.empty() )
-        getNodeName( m_SGtype, m_Name );
+    // the generated name is only stored when it is requested as a string
+    if( NULL == m_Name )
+    {
+        std::ostringstream ostr;
+        ostr << Name();
+        m_Name = new std::string( ostr.str() );
+    }
 
-    return m_Name.c_str();
+    return m_Name->c_str();
 }
 
 
 void SGNODE::SetName( const char *aName )
 {
-    if( NULL == aName || 0 == aName[0] )
-        getNodeName( m_SGtype, m_Name );
-    else
-        m_Name = aName;
+    delete m_Name;
+    m_Name = NULL;
+
+    if( NULL == aName || 0 == aName[0] || m_SGtype < 0 || m_SGtype >= S3D::SGTYPE_END )
+    {
+        m_Index = GetNameContext().Next( m_SGtype );
+        return;
+    }
+
+    // a name of the generated form (such as the names read from a
+    // cache file) is held as its sequence number
+    const std::string& prefix = node_names[m_SGtype];
+    size_t np = prefix.size();
+
+    if( !strncmp( aName, prefix.c_str(), np ) && '_' == aName[np]
+        && aName[np + 1] >= '1' && aName[np + 1] <= '9' )
+    {
+        char* ep = NULL;
+        unsigned long idx = strtoul( &aName[np + 1], &ep, 10 );
+
+        if( 0 == *ep && idx <= 0xffffffffUL )
+        {
+            m_Index = (unsigned int)idx;
+            return;
+        }
+    }
+
+    m_Name = new std::string( aName );
+    return;
+}
+
+
+SGNODENAME SGNODE::Name( void )
+{
+    SGNODENAME name;
+    name.node = this;
+    return name;
+}
+
+
+// a node outside of any scene graph is named from a per-thread context
+static SGNAMES& detachedNames( void )
+{
+    static thread_local SGNAMES detached;
+    return detached;
+}
+
+
+SGNAMES& SGNODE::GetNameContext( void )
+{
+    SGNODE* np = this;
+
+    while( NULL != np->m_Parent )
+        np = np->m_Parent;
+
+    SGNAMES* names = np->GetNames();
+
+    if( NULL != names )
+        return *names;
+
+    return detachedNames();
+}
+
+
+const SGNAMES& SGNODE::PeekNameContext( void ) const
+{
+    const SGNODE* np = this;
+
+    while( NULL != np->m_Parent )
+        np = np->m_Parent;
+
+    const SGNAMES* names = np->PeekNames();
+
+    if( NULL != names )
+        return *names;
+
+    // a top level node creates its context once it names a node, so
+    // until then its names follow those of an unused context
+    if( S3D::SGTYPE_TRANSFORM == np->GetNodeType() )
+    {
+        static const SGNAMES unused;
+        return unused;
+    }
+
+    return detachedNames();
+}
+
+
+void SGNODE::readName( const std::string& aName )
+{
+    SetName( aName.c_str() );
+    GetNameContext().AddNode( aName, this );
+    return;
+}
+
+
+SGNODE* SGNODE::findReadNode( const std::string& aName )
+{
+    SGNODE* np = GetNameContext().FindNode( aName );
+
+    if( NULL != np )
+        return np;
+
+    return FindNode( aName.c_str(), this );
+}
+
+
+bool SGNODE::GetBounds( SGBOUNDS& aBounds ) const
+{
+    aBounds = SGBOUNDS();
+    return false;
+}
+
+
+// set while a graft links its nodes; the graft then invalidates the
+// holders of its parent once it holds the lock serializing such walks
+static thread_local bool defer_holders = false;
+
+
+void SGNODE::deferHolderBounds( bool aDefer )
+{
+    defer_holders = aDefer;
+    return;
+}
+
+
+void SGNODE::invalidateBounds( void )
+{
+    // bounds are only cached while the bounds of the nodes beneath them
+    // are cached, so the propagation ends at a node without bounds
+    if( !resetBounds() || defer_holders )
+        return;
+
+    invalidateHolderBounds();
+    return;
+}
+
+
+void SGNODE::invalidateHolderBounds( void )
+{
+    if( NULL != m_Parent )
+        m_Parent->invalidateBounds();
+
+    for( size_t i = 0; i < m_BackPointers.size(); ++i )
+        m_BackPointers[i]->invalidateBounds();
 
     return;
 }
 
 
+size_t SGNODE::GetLinkBytes( void ) const
+{
+    return m_BackPointers.capacity() * sizeof( SGNODE* ) + S3D::HashBytes( m_BackIndex );
+}
+
+
+size_t SGNODE::GetNameBytes( void ) const
+{
+    if( NULL == m_Name )
+        return 0;
+
+    return sizeof( std::string ) + m_Name->capacity() + 1;
+}
+
+
+bool SGNODE::rename( SGNAMES& aNames )
+{
+    if( m_Pass == aNames.GetPass() )
+        return false;
+
+    m_Pass = aNames.GetPass();
+    delete m_Name;
+    m_Name = NULL;
+    m_Index = aNames.Next( m_SGtype );
+
+    return true;
+}
+
+
+bool SGNODE::isNamed( const char* aName ) const
+{
+    if( NULL == aName )
+        return false;
+
+    if( NULL != m_Name )
+        return !m_Name->compare( aName );
+
+    if( 0 == m_Index || m_SGtype < 0 || m_SGtype >= S3D::SGTYPE_END )
+        return false;
+
+    const std::string& prefix = node_names[m_SGtype];
+    size_t np = prefix.size();
+
+    if( strncmp( aName, prefix.c_str(), np ) || '_' != aName[np]
+        || aName[np + 1] < '1' || aName[np + 1] > '9' )
+        return false;
+
+    char* ep = NULL;
+    unsigned long idx = strtoul( &aName[np + 1], &ep, 10 );
+
+    return 0 == *ep && idx == m_Index;
+}
+
+
 const char * SGNODE::GetNodeTypeName( S3D::SGTYPES aNodeType ) const
 {
     return node_names[aNodeType].c_str();
@@ -178,12 +693,10 @@ void SGNODE::addNodeRef( SGNODE* aNode )
     if( NULL == aNode )
         return;
 
-    std::list< SGNODE* >::iterator np =
-        std::find( m_BackPointers.begin(), m_BackPointers.end(), aNode );
-
-    if( np != m_BackPointers.end() )
+    if( m_BackIndex.find( aNode ) != m_BackIndex.end() )
         return;
 
+    m_BackIndex[aNode] = m_BackPointers.size();
     m_BackPointers.push_back( aNode );
     return;
 }
@@ -194,12 +707,19 @@ void SGNODE::delNodeRef( const SGNODE* aNode )
     if( NULL == aNode )
         return;
 
-    std::list< SGNODE* >::iterator np =
-        std::find( m_BackPointers.begin(), m_BackPointers.end(), aNode );
+    std::unordered_map< const SGNODE*, size_t >::iterator np = m_BackIndex.find( aNode );
 
-    if( np != m_BackPointers.end() )
+    if( np != m_BackIndex.end() )
     {
-        m_BackPointers.erase( np );
+        // the order of the back-pointers is not significant so the
+        // last entry is moved into the vacated slot
+        size_t idx = np->second;
+        SGNODE* last = m_BackPointers.back();
+
+        m_BackPointers[idx] = last;
+        m_BackIndex[last] = idx;
+        m_BackPointers.pop_back();
+        m_BackIndex.erase( aNode );
         return;
     }
 
@@ -303,9 +823,42 @@ void SGNODE::DisassociateWrapper( SGNODE** aWrapperRef )
 
 void SGNODE::ResetNodeIndex( void )
 {
-    for( int i = 0; i < (int)S3D::SGTYPE_END; ++i )
-        node_counts[i] = 1;
+    GetNameContext().Reset();
+    return;
+}
+
+
+/**
+ * Class SGRENAME
+ * renames the nodes of a scene graph in the order in which they are written;
+ * nodes already renamed within the current pass are skipped along with the
+ * nodes beneath them.
+ */
+class SGRENAME : public SGVISITOR
+{
+private:
+    SGNAMES& m_Names;
+
+public:
+    SGRENAME( SGNAMES& aNames ) : m_Names( aNames )
+    {
+        return;
+    }
+
+    SGVISIT_ACTION Pre( const SGVISIT& aVisit )
+    {
+        if( !aVisit.node->rename( m_Names ) )
+            return SGVISIT_SKIP;
+
+        return SGVISIT_CONTINUE;
+    }
+};
+
 
+void SGNODE::ReNameNodes( SGNAMES& aNames )
+{
+    SGRENAME renamer( aNames );
+    S3D::Walk( this, renamer, SGWALK_REFS );
     return;
 }
 
@@ -377,6 +930,13 @@ void S3D::INIT_S3DMODEL( S3DMODEL& aModel )
 }
 
 
+void S3D::INIT_SLINESET( SLINESET& aLines )
+{
+    memset( &aLines, 0, sizeof( aLines ) );
+    return;
+}
+
+
 void S3D::FREE_SMESH( SMESH& aMesh)
 {
     if( NULL != aMesh.m_Positions )
@@ -417,6 +977,28 @@ void S3D::FREE_SMESH( SMESH& aMesh)
 }
 
 
+void S3D::FREE_SLINESET( SLINESET& aLines )
+{
+    if( NULL != aLines.m_Positions )
+    {
+        delete [] aLines.m_Positions;
+        aLines.m_Positions = NULL;
+    }
+
+    if( NULL != aLines.m_LineIdx )
+    {
+        delete [] aLines.m_LineIdx;
+        aLines.m_LineIdx = NULL;
+    }
+
+    aLines.m_VertexSize = 0;
+    aLines.m_LineIdxSize = 0;
+    aLines.m_MaterialIdx = 0;
+
+    return;
+}
+
+
 void S3D::FREE_S3DMODEL( S3DMODEL& aModel )
 {
     if( NULL != aModel.m_Materials )
@@ -438,5 +1020,16 @@ void S3D::FREE_S3DMODEL( S3DMODEL& aModel )
 
     aModel.m_MeshesSize = 0;
 
+    if( NULL != aModel.m_LineSets )
+    {
+        for( unsigned int i = 0; i < aModel.m_LineSetsSize; ++i )
+            FREE_SLINESET( aModel.m_LineSets[i] );
+
+        delete [] aModel.m_LineSets;
+        aModel.m_LineSets = NULL;
+    }
+
+    aModel.m_LineSetsSize = 0;
+
     return;
 }
@@ -30,11 +30,15 @@
 #ifndef SG_NODE_H
 #define SG_NODE_H
 
+#include <atomic>
 #include <fstream>
+#include <ostream>
 #include <string>
 #include <list>
 #include <vector>
 #include <map>
+#include <unordered_map>
+#include <unordered_set>
 #include <glm/glm.hpp>
 
 #include "plugins/3dapi/c3dmodel.h"
@@ -43,6 +47,7 @@
 
 class SGNODE;
 class SGAPPEARANCE;
+class SGARENA;
 
 namespace S3D
 {
@@ -63,12 +68,289 @@ namespace S3D
     void INIT_SMATERIAL( SMATERIAL& aMaterial );
     void INIT_SMESH( SMESH& aMesh );
     void INIT_S3DMODEL( S3DMODEL& aModel );
+    void INIT_SLINESET( SLINESET& aLines );
 
     void FREE_SMESH( SMESH& aMesh);
+    void FREE_SLINESET( SLINESET& aLines );
     void FREE_S3DMODEL( S3DMODEL& aModel );
 };
 
 
+/**
+ * Enum SGVALIDITY
+ * is the result of the validation of the data held by a geometry node
+ */
+enum SGVALIDITY
+{
+    SGVALID_UNKNOWN = 0,    // not validated since the node was last modified
+    SGVALID_YES,
+    SGVALID_NO
+};
+
+
+/**
+ * Struct SGBOUNDS
+ * is an axis aligned bounding box; it is empty until a point is added
+ */
+struct SGBOUNDS
+{
+    glm::dvec3 lower;
+    glm::dvec3 upper;
+
+    SGBOUNDS();
+
+    bool IsEmpty( void ) const
+    {
+        return lower.x > upper.x;
+    }
+
+    void Add( double aXValue, double aYValue, double aZValue );
+    void Add( const SGBOUNDS& aBounds );
+
+    /**
+     * Function Add
+     * adds the bounds of the given box after it has been transformed
+     */
+    void Add( const SGBOUNDS& aBounds, const glm::dmat4& aTransform );
+};
+
+
+/**
+ * Class SGBOUNDSCACHE
+ * holds the bounds of a node once they have been computed. Since reader
+ * threads may compute the bounds of a shared scene graph at once, the
+ * bounds are published by the first of them and are then read without
+ * locking; the bounds are only discarded while the scene graph is modified.
+ */
+class SGBOUNDSCACHE
+{
+private:
+    mutable std::atomic< int > m_State;     // SGVALID_YES if m_Bounds is set
+    mutable SGBOUNDS m_Bounds;
+
+public:
+    SGBOUNDSCACHE() : m_State( SGVALID_UNKNOWN )
+    {
+        return;
+    }
+
+    /**
+     * Function Get
+     * copies the bounds to aBounds; returns false if they are not held
+     */
+    bool Get( SGBOUNDS& aBounds ) const;
+
+    /**
+     * Function Set
+     * holds the given bounds unless bounds are already held
+     */
+    void Set( const SGBOUNDS& aBounds ) const;
+
+    /**
+     * Function Reset
+     * discards the bounds; returns false if no bounds were held
+     */
+    bool Reset( void );
+};
+
+
+/**
+ * Class SGNAMES
+ * is the naming context of a scene graph; it holds the sequence number
+ * of the next name of each node type so that independent scene graphs
+ * may be named and written concurrently.
+ */
+class SGNAMES
+{
+private:
+    unsigned int m_Counts[S3D::SGTYPE_END]; // next sequence number of each node type
+    unsigned int m_Pass;                    // identifies the current renaming pass
+
+    // nodes read from a cache file keyed on their names; this is only
+    // populated while the cache file is being read
+    std::unordered_map< std::string, SGNODE* > m_Nodes;
+
+public:
+    SGNAMES();
+
+    /**
+     * Function Reset
+     * restarts the sequence numbers and begins a new renaming pass
+     */
+    void Reset( void );
+
+    /**
+     * Function Next
+     * returns the next sequence number for the given node type
+     */
+    unsigned int Next( S3D::SGTYPES aType );
+
+    /**
+     * Function Peek
+     * returns the next sequence number for the given node type
+     * without consuming it
+     */
+    unsigned int Peek( S3D::SGTYPES aType ) const;
+
+    unsigned int GetPass( void ) const
+    {
+        return m_Pass;
+    }
+
+    /**
+     * Function AddNode
+     * indexes a node read from a cache file; the first node
+     * read with a given name is retained
+     */
+    void AddNode( const std::string& aName, SGNODE* aNode );
+
+    /**
+     * Function FindNode
+     * returns the indexed node with the given name or NULL
+     */
+    SGNODE* FindNode( const std::string& aName ) const;
+
+    /**
+     * Function ClearNodes
+     * discards the index of nodes read from a cache file
+     */
+    void ClearNodes( void );
+};
+
+
+/**
+ * Struct SGNODENAME
+ * writes the name of a node to a stream without building a string
+ */
+struct SGNODENAME
+{
+    SGNODE* node;
+};
+
+std::ostream& operator<<( std::ostream& aStream, const SGNODENAME& aName );
+
+
+class SGWRITE;
+
+/**
+ * Struct SGWRITENAME
+ * writes the name which a node is given within a VRML or cache file
+ */
+struct SGWRITENAME
+{
+    const SGNODE* node;
+    SGWRITE* state;
+};
+
+std::ostream& operator<<( std::ostream& aStream, const SGWRITENAME& aName );
+
+
+/**
+ * Class SGWRITE
+ * holds the state of a single VRML or cache file write: the nodes written
+ * so far and the names generated for the write. Since the state is held
+ * outside of the scene graph, a scene graph is not modified while it is
+ * written and may be written by several threads at once.
+ */
+class SGWRITE
+{
+private:
+    bool m_Rename;                          // true if every node is given a generated name
+    unsigned int m_Counts[S3D::SGTYPE_END]; // next sequence number of each node type
+
+    // sequence numbers of the names generated for this write
+    std::unordered_map< const SGNODE*, unsigned int > m_Index;
+
+    // nodes written so far
+    std::unordered_set< const SGNODE* > m_Written;
+
+    friend std::ostream& operator<<( std::ostream& aStream, const SGWRITENAME& aName );
+    friend class SGWRITENAMES;
+
+public:
+    /**
+     * Constructor SGWRITE
+     * prepares the write of the scene graph beneath aTopNode
+     *
+     * @param aTopNode is the first node to be written
+     * @param aRename is true to give every node a unique name generated for
+     * this write in place of its own name; nodes are named in the same order
+     * as by SGNODE::ReNameNodes()
+     */
+    SGWRITE( SGNODE* aTopNode, bool aRename );
+
+    /**
+     * Function IsWritten
+     * returns true if the node has already been written
+     */
+    bool IsWritten( const SGNODE* aNode ) const
+    {
+        return m_Written.find( aNode ) != m_Written.end();
+    }
+
+    /**
+     * Function SetWritten
+     * records that the node is being written; returns false if
+     * it had already been written
+     */
+    bool SetWritten( const SGNODE* aNode )
+    {
+        return m_Written.insert( aNode ).second;
+    }
+
+    /**
+     * Function Name
+     * returns an object which writes the name of the node within this write
+     */
+    SGWRITENAME Name( const SGNODE* aNode )
+    {
+        SGWRITENAME name;
+        name.node = aNode;
+        name.state = this;
+        return name;
+    }
+
+    /**
+     * Function SplitNodes
+     * divides the child and referenced nodes of one type held by a node into
+     * the nodes to be written in full and those to be written as references
+     * to nodes already written. A referenced node which has not been written
+     * is written in full in place of the reference; a child which has already
+     * been written, having been reached via a reference, is written as a reference.
+     * Empty slots left in the lists by unlinked nodes are skipped.
+     */
+    template< typename T >
+    void SplitNodes( const std::vector< T* >& aChildren, const std::vector< T* >& aRefs,
+                     std::vector< T* >& aWriteList, std::vector< T* >& aRefList ) const
+    {
+        for( size_t i = 0; i < aChildren.size(); ++i )
+        {
+            if( NULL != aChildren[i] && !IsWritten( aChildren[i] ) )
+                aWriteList.push_back( aChildren[i] );
+        }
+
+        for( size_t i = 0; i < aRefs.size(); ++i )
+        {
+            if( NULL == aRefs[i] )
+                continue;
+
+            if( IsWritten( aRefs[i] ) )
+                aRefList.push_back( aRefs[i] );
+            else
+                aWriteList.push_back( aRefs[i] );
+        }
+
+        for( size_t i = 0; i < aChildren.size(); ++i )
+        {
+            if( NULL != aChildren[i] && IsWritten( aChildren[i] ) )
+                aRefList.push_back( aChildren[i] );
+        }
+
+        return;
+    }
+};
+
+
 /**
  * Class SGNODE
  * represents the base class of all Scene Graph nodes
@@ -78,12 +360,71 @@ class SGNODE
 private:
     SGNODE** m_Association;                 // handle to the instance held by a wrapper
 
+    friend std::ostream& operator<<( std::ostream& aStream, const SGNODENAME& aName );
+    friend std::ostream& operator<<( std::ostream& aStream, const SGWRITENAME& aName );
+    friend class SGRENAME;
+
 protected:
-    std::list< SGNODE* > m_BackPointers;    // nodes which hold a reference to this
+    std::vector< SGNODE* > m_BackPointers;  // nodes which hold a reference to this
+    std::unordered_map< const SGNODE*, size_t > m_BackIndex;    // position in m_BackPointers
     SGNODE* m_Parent;       // pointer to parent node; may be NULL for top level transform
     S3D::SGTYPES m_SGtype;  // type of SG node
-    std::string m_Name;     // name to use for referencing the entity by name
-    bool m_written;         // set true when the object has been written after a ReNameNodes()
+    std::string* m_Name;    // user assigned name; NULL if the name is generated
+    unsigned int m_Index;   // sequence number of the generated name; 0 if not yet named
+    unsigned int m_Pass;    // naming pass in which the node was last renamed
+
+    /**
+     * Function rename
+     * gives the node the next generated name of the context; returns false
+     * if the node had already been renamed within the current pass
+     */
+    bool rename( SGNAMES& aNames );
+
+    /**
+     * Function isNamed
+     * returns true if the node's user assigned or generated name
+     * matches the given name
+     */
+    bool isNamed( const char* aName ) const;
+
+    /**
+     * Function GetNames
+     * returns the naming context owned by this node or NULL if the node
+     * does not own one; only a top level node may own a naming context.
+     */
+    virtual SGNAMES* GetNames( void )
+    {
+        return NULL;
+    }
+
+    /**
+     * Function PeekNames
+     * returns the naming context owned by this node or NULL if the node
+     * owns none; unlike GetNames() this never creates the context.
+     */
+    virtual const SGNAMES* PeekNames( void ) const
+    {
+        return NULL;
+    }
+
+    /**
+     * Function resetBounds
+     * discards the bounds cached by this node; returns false if no bounds
+     * were cached. Nodes which do not cache their bounds return true so
+     * that an invalidation passes through them to the nodes holding them.
+     */
+    virtual bool resetBounds( void )
+    {
+        return true;
+    }
+
+    /**
+     * Function isReleased
+     * returns true if this node is being destroyed along with the arena
+     * holding it and aNode is held by the same arena; the links between
+     * such nodes are not undone since all of them are being destroyed.
+     */
+    bool isReleased( const SGNODE* aNode ) const;
 
 public:
     /**
@@ -123,19 +464,73 @@ public:
     void delNodeRef( const SGNODE* aNode );
 
     /**
-     * Function IsWritten
-     * returns true if the object had already been written to a
-     * cache file or VRML file; for internal use only.
+     * Function readName
+     * sets the name of a node read from a cache file and adds the node
+     * to the name index of the scene graph; for internal use only.
      */
-    bool isWritten( void )
-    {
-        return m_written;
-    }
+    void readName( const std::string& aName );
+
+    /**
+     * Function findReadNode
+     * returns the node with the given name which has been read from the
+     * current cache file; nodes which are not indexed are searched for
+     * via FindNode(). For internal use only.
+     */
+    SGNODE* findReadNode( const std::string& aName );
+
+    /**
+     * Function invalidateBounds
+     * discards the cached bounds of this node and of every node holding it
+     * as a child or reference; it is invoked when the geometry beneath this
+     * node changes. For internal use only.
+     */
+    void invalidateBounds( void );
+
+    /**
+     * Function invalidateHolderBounds
+     * discards the cached bounds of every node holding this node but not
+     * those of this node; it is invoked when the transform of a node
+     * changes. For internal use only.
+     */
+    void invalidateHolderBounds( void );
+
+    /**
+     * Function deferHolderBounds
+     * while set, invalidateBounds() discards the bounds of the node on
+     * which it is invoked but not those of the nodes holding it; this
+     * applies to the calling thread only. For internal use only.
+     */
+    static void deferHolderBounds( bool aDefer );
+
+    /**
+     * Function GetLinkBytes
+     * returns the memory held by the back-pointer containers of this node
+     */
+    size_t GetLinkBytes( void ) const;
+
+    /**
+     * Function GetNameBytes
+     * returns the memory held by the user assigned name of this node
+     */
+    size_t GetNameBytes( void ) const;
 
 public:
     SGNODE( SGNODE* aParent );
     virtual ~SGNODE();
 
+    /**
+     * Operators new and delete
+     * every node is preceded in memory by a header naming the arena which
+     * holds it. new( aParent ) allocates the node from the arena of the
+     * scene graph holding aParent, if any, and otherwise from the heap.
+     */
+    static void* operator new( size_t aSize );
+    static void* operator new( size_t aSize, SGNODE* aParent );
+    static void* operator new( size_t aSize, SGARENA* aArena );
+    static void operator delete( void* aNode );
+    static void operator delete( void* aNode, SGNODE* aParent );
+    static void operator delete( void* aNode, SGARENA* aArena );
+
     /**
      * Function GetNodeType
      * returns the type of this node instance
@@ -174,8 +569,44 @@ public:
     const char* GetName( void );
     void SetName(const char *aName);
 
+    /**
+     * Function Name
+     * returns an object which writes the node name to a stream; unlike
+     * GetName() this does not store a string in the node.
+     */
+    SGNODENAME Name( void );
+
+    /**
+     * Function GetNameContext
+     * returns the naming context of the scene graph holding this node;
+     * this is owned by the top level node.
+     */
+    SGNAMES& GetNameContext( void );
+
+    /**
+     * Function PeekNameContext
+     * returns the naming context of the scene graph holding this node
+     * without modifying any node; a top level node which has not yet
+     * created its context yields an empty context. This may be invoked
+     * by concurrent writers of the scene graph.
+     */
+    const SGNAMES& PeekNameContext( void ) const;
+
     const char * GetNodeTypeName( S3D::SGTYPES aNodeType ) const;
 
+    /**
+     * Function GetBounds
+     * computes the bounds of the geometry beneath this node within the
+     * coordinate system of this node; that is, excluding the transform
+     * of the node itself. The bounds are cached by the nodes which
+     * hold coordinates or other nodes and are retained until the
+     * geometry changes.
+     *
+     * @param aBounds receives the bounds
+     * @return true if the bounds are not empty
+     */
+    virtual bool GetBounds( SGBOUNDS& aBounds ) const;
+
     /**
      * Function FindNode searches the tree of linked nodes and returns a
      * reference to the first node found with the given name. The reference
@@ -210,33 +641,36 @@ public:
 
     /**
      * Function ResetNodeIndex
-     * resets the global SG* node indices in preparation for
-     * Write() operations
+     * resets the node indices of the scene graph holding this node
+     * in preparation for Write() operations
      */
     void ResetNodeIndex( void );
 
     /**
      * Function ReNameNodes
-     * renames a node and all its child nodes in preparation for
-     * Write() operations
+     * renames a node and all its child and referenced nodes which have
+     * not yet been renamed since the last ResetNodeIndex() of the given
+     * naming context in preparation for Write() operations
      */
-    virtual void ReNameNodes( void ) = 0;
+    void ReNameNodes( SGNAMES& aNames );
 
     /**
      * Function WriteVRML
      * writes this node's data to a VRML file; this includes
-     * all data of child and referenced nodes.
+     * all data of child and referenced nodes. The nodes written
+     * and their names are held by aState rather than by the nodes.
      */
-    virtual bool WriteVRML( std::ofstream& aFile, bool aReuseFlag ) = 0;
+    virtual bool WriteVRML( std::ofstream& aFile, bool aReuseFlag, SGWRITE& aState ) const = 0;
 
     /**
      * Function WriteCache
      * write's this node's data to a binary cache file; the data
      * includes all data of children and references to children.
-     * If this function is invoked by the user, parentNode must be
-     * set to NULL in order to ensure coherent data.
+     * Referenced nodes not yet recorded as written by aState are
+     * written in full. Cache files are written via S3D::WriteCache(),
+     * which begins with the top level node of the scene graph.
      */
-    virtual bool WriteCache( std::ofstream& aFile, SGNODE* parentNode ) = 0;
+    virtual bool WriteCache( std::ofstream& aFile, SGWRITE& aState ) const = 0;
 
     /**
      * Function ReadCache
@@ -23,6 +23,7 @@
 
 #include <iostream>
 #include <sstream>
+#include <utility>
 #include <wx/log.h>
 
 #include "3d_cache/sg/sg_normals.h"
@@ -32,6 +33,7 @@
 SGNORMALS::SGNORMALS( SGNODE* aParent ) : SGNODE( aParent )
 {
     m_SGtype = S3D::SGTYPE_NORMALS;
+    m_Single = false;
 
     if( NULL != aParent && S3D::SGTYPE_FACESET != aParent->GetNodeType() )
     {
@@ -57,6 +59,7 @@ SGNORMALS::SGNORMALS( SGNODE* aParent ) : SGNODE( aParent )
 SGNORMALS::~SGNORMALS()
 {
     norms.clear();
+    m_Vectors.Clear();
     return;
 }
 
@@ -96,7 +99,7 @@ SGNODE* SGNORMALS::FindNode(const char *aNodeName, const SGNODE *aCaller)
     if( NULL == aNodeName || 0 == aNodeName[0] )
         return NULL;
 
-    if( !m_Name.compare( aNodeName ) )
+    if( isNamed( aNodeName ) )
         return this;
 
     return NULL;
@@ -155,8 +158,71 @@ bool SGNORMALS::AddChildNode( SGNODE* aNode )
 }
 
 
+void SGNORMALS::SetSinglePrecision( bool aSingle )
+{
+    if( aSingle == m_Single )
+        return;
+
+    m_Single = aSingle;
+
+    if( m_Single )
+    {
+        m_Vectors.Reserve( norms.size() );
+
+        for( size_t i = 0; i < norms.size(); ++i )
+        {
+            double x, y, z;
+            norms[i].GetVector( x, y, z );
+            m_Vectors.Add( x, y, z );
+        }
+
+        std::vector< SGVECTOR >().swap( norms );
+        return;
+    }
+
+    norms.reserve( m_Vectors.Size() );
+
+    for( size_t i = 0; i < m_Vectors.Size(); ++i )
+        norms.push_back( SGVECTOR( m_Vectors.x[i], m_Vectors.y[i], m_Vectors.z[i] ) );
+
+    m_Vectors.Release();
+    return;
+}
+
+
+size_t SGNORMALS::GetDataBytes( void ) const
+{
+    return norms.capacity() * sizeof( SGVECTOR ) + m_Vectors.GetBytes();
+}
+
+
+void SGNORMALS::TransformNormals( const glm::dmat4& aTransform, SFVEC3F* aResult ) const
+{
+    if( m_Single )
+    {
+        S3D::TransformLanes( aTransform, 0.0, m_Vectors, aResult );
+        return;
+    }
+
+    double x, y, z;
+
+    for( size_t i = 0; i < norms.size(); ++i )
+    {
+        norms[i].GetVector( x, y, z );
+        glm::dvec4 pt( x, y, z, 0.0 );
+        pt = aTransform * pt;
+        aResult[i] = SFVEC3F( pt.x, pt.y, pt.z );
+    }
+
+    return;
+}
+
+
 bool SGNORMALS::GetNormalList( size_t& aListSize, SGVECTOR*& aNormalList )
 {
+    // callers may modify the list so it must be held in double precision
+    SetSinglePrecision( false );
+
     if( norms.empty() )
     {
         aListSize = 0;
@@ -173,56 +239,85 @@ bool SGNORMALS::GetNormalList( size_t& aListSize, SGVECTOR*& aNormalList )
 void SGNORMALS::SetNormalList( size_t aListSize, const SGVECTOR* aNormalList )
 {
     norms.clear();
+    m_Vectors.Clear();
 
     if( 0 == aListSize || NULL == aNormalList )
         return;
 
-    for( int i = 0; i < (int)aListSize; ++i )
-        norms.push_back( aNormalList[i] );
+    if( !m_Single )
+    {
+        norms.assign( aNormalList, aNormalList + aListSize );
+        return;
+    }
+
+    m_Vectors.Reserve( aListSize );
+
+    for( size_t i = 0; i < aListSize; ++i )
+    {
+        double x, y, z;
+        aNormalList[i].GetVector( x, y, z );
+        m_Vectors.Add( x, y, z );
+    }
 
     return;
 }
 
 
-void SGNORMALS::AddNormal( double aXValue, double aYValue, double aZValue )
+void SGNORMALS::SetNormalList( std::vector< SGVECTOR >&& aNormalList )
 {
-    norms.push_back( SGVECTOR( aXValue, aYValue, aZValue ) );
+    if( !m_Single )
+    {
+        norms = std::move( aNormalList );
+        return;
+    }
+
+    std::vector< SGVECTOR > tmp( std::move( aNormalList ) );
+
+    if( tmp.empty() )
+        SetNormalList( 0, NULL );
+    else
+        SetNormalList( tmp.size(), &tmp[0] );
+
     return;
 }
 
 
-void SGNORMALS::AddNormal( const SGVECTOR& aNormal )
+void SGNORMALS::AddNormal( double aXValue, double aYValue, double aZValue )
 {
-    norms.push_back( aNormal );
+    AddNormal( SGVECTOR( aXValue, aYValue, aZValue ) );
     return;
 }
 
 
-void SGNORMALS::ReNameNodes( void )
+void SGNORMALS::AddNormal( const SGVECTOR& aNormal )
 {
-    m_written = false;
+    if( !m_Single )
+    {
+        norms.push_back( aNormal );
+        return;
+    }
 
-    // rename this node
-    m_Name.clear();
-    GetName();
+    double x, y, z;
+    aNormal.GetVector( x, y, z );
+    m_Vectors.Add( x, y, z );
+    return;
 }
 
 
-bool SGNORMALS::WriteVRML( std::ofstream& aFile, bool aReuseFlag )
+bool SGNORMALS::WriteVRML( std::ofstream& aFile, bool aReuseFlag, SGWRITE& aState ) const
 {
-    if( norms.empty() )
+    if( 0 == GetSize() )
         return false;
 
     if( aReuseFlag )
     {
-        if( !m_written )
+        if( aState.SetWritten( this ) )
         {
-            aFile << "  normal DEF " << GetName() << " Normal { vector [\n  ";
-            m_written = true;
+            aFile << "  normal DEF " << aState.Name( this ) << " Normal { vector [\n  ";
         }
         else
         {
-            aFile << "  normal USE " << GetName() << "\n";
+            aFile << "  normal USE " << aState.Name( this ) << "\n";
             return true;
         }
     }
@@ -232,12 +327,14 @@ bool SGNORMALS::WriteVRML( std::ofstream& aFile, bool aReuseFlag )
     }
 
     std::string tmp;
-    size_t n = norms.size();
+    size_t n = GetSize();
     bool nline = false;
+    double x, y, z;
 
     for( size_t i = 0; i < n; )
     {
-        S3D::FormatVector( tmp, norms[i] );
+        GetNormal( i, x, y, z );
+        S3D::FormatVector( tmp, SGVECTOR( x, y, z ) );
         aFile << tmp ;
         ++i;
 
@@ -264,48 +361,8 @@ bool SGNORMALS::WriteVRML( std::ofstream& aFile, bool aReuseFlag )
 }
 
 
-bool SGNORMALS::WriteCache( std::ofstream& aFile, SGNODE* parentNode )
+bool SGNORMALS::WriteCache( std::ofstream& aFile, SGWRITE& aState ) const
 {
-    if( NULL == parentNode )
-    {
-        if( NULL == m_Parent )
-        {
-            #ifdef DEBUG
-            std::ostringstream ostr;
-            ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
-            ostr << " * [BUG] corrupt data; m_aParent is NULL";
-            wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
-            #endif
-
-            return false;
-        }
-
-        SGNODE* np = m_Parent;
-
-        while( NULL != np->GetParent() )
-            np = np->GetParent();
-
-        if( np->WriteCache( aFile, NULL ) )
-        {
-            m_written = true;
-            return true;
-        }
-
-        return false;
-    }
-
-    if( parentNode != m_Parent )
-    {
-        #ifdef DEBUG
-        std::ostringstream ostr;
-        ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
-        ostr << " * [BUG] corrupt data; parentNode != m_aParent";
-        wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
-        #endif
-
-        return false;
-    }
-
     if( !aFile.good() )
     {
         #ifdef DEBUG
@@ -318,24 +375,33 @@ bool SGNORMALS::WriteCache( std::ofstream& aFile, SGNODE* parentNode )
         return false;
     }
 
-    aFile << "[" << GetName() << "]";
-    size_t npts = norms.size();
+    aState.SetWritten( this );
+    aFile << "[" << aState.Name( this ) << "]";
+    size_t npts = GetSize();
     aFile.write( (char*)&npts, sizeof(size_t) );
+    aFile.put( m_Single ? 'F' : 'D' );
 
-    for( size_t i = 0; i < npts; ++i )
-        S3D::WriteVector( aFile, norms[i] );
+    if( m_Single )
+    {
+        for( size_t i = 0; i < npts; ++i )
+            S3D::WriteLanes( aFile, m_Vectors, i );
+    }
+    else
+    {
+        for( size_t i = 0; i < npts; ++i )
+            S3D::WriteVector( aFile, norms[i] );
+    }
 
     if( aFile.fail() )
         return false;
 
-    m_written = true;
     return true;
 }
 
 
 bool SGNORMALS::ReadCache( std::ifstream& aFile, SGNODE* parentNode )
 {
-    if( !norms.empty() )
+    if( 0 != GetSize() )
     {
         #ifdef DEBUG
         std::ostringstream ostr;
@@ -348,12 +414,28 @@ bool SGNORMALS::ReadCache( std::ifstream& aFile, SGNODE* parentNode )
     }
 
     size_t npts;
+    char prec = 0;
     aFile.read( (char*)&npts, sizeof(size_t) );
-    SGVECTOR tmp;
+    aFile.get( prec );
 
-    if( aFile.fail() )
+    if( aFile.fail() || ( 'F' != prec && 'D' != prec ) )
         return false;
 
+    m_Single = ( 'F' == prec );
+
+    if( m_Single )
+    {
+        for( size_t i = 0; i < npts; ++i )
+        {
+            if( !S3D::ReadLanes( aFile, m_Vectors ) )
+                return false;
+        }
+
+        return true;
+    }
+
+    SGVECTOR tmp;
+
     for( size_t i = 0; i < npts; ++i )
     {
         if( !S3D::ReadVector( aFile, tmp ) || aFile.fail() )
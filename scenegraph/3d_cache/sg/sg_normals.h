@@ -31,11 +31,16 @@
 
 #include <vector>
 #include "3d_cache/sg/sg_node.h"
+#include "3d_cache/sg/sg_helpers.h"
 
 class SGNORMALS : public SGNODE
 {
+private:
+    bool m_Single;                      // true if the normals are held in single precision
+    SGLANES m_Vectors;                  // single precision normals
+
 public:
-    std::vector< SGVECTOR > norms;
+    std::vector< SGVECTOR > norms;      // double precision normals
 
     void unlinkChildNode( const SGNODE* aNode );
     void unlinkRefNode( const SGNODE* aNode );
@@ -50,15 +55,62 @@ public:
     bool AddRefNode( SGNODE* aNode );
     bool AddChildNode( SGNODE* aNode );
 
+    /**
+     * Function SetSinglePrecision
+     * selects the storage of the normals; in single precision the unit
+     * vectors are held as floats. Any existing normals are converted.
+     */
+    void SetSinglePrecision( bool aSingle );
+
+    bool IsSinglePrecision( void ) const
+    {
+        return m_Single;
+    }
+
+    size_t GetSize( void ) const
+    {
+        return m_Single ? m_Vectors.Size() : norms.size();
+    }
+
+    void GetNormal( size_t aIndex, double& aXVal, double& aYVal, double& aZVal ) const
+    {
+        if( m_Single )
+        {
+            aXVal = m_Vectors.x[aIndex];
+            aYVal = m_Vectors.y[aIndex];
+            aZVal = m_Vectors.z[aIndex];
+        }
+        else
+        {
+            norms[aIndex].GetVector( aXVal, aYVal, aZVal );
+        }
+    }
+
+    /**
+     * Function TransformNormals
+     * writes the transformed normals to aResult which must hold
+     * GetSize() elements; single precision normals are transformed
+     * as a whole by a vectorized kernel.
+     */
+    void TransformNormals( const glm::dmat4& aTransform, SFVEC3F* aResult ) const;
+
+    // returns the memory held by the normal list
+    size_t GetDataBytes( void ) const;
+
+    /**
+     * Function GetNormalList
+     * returns a pointer to the double precision normals; normals held
+     * in single precision are first converted to double precision.
+     */
     bool GetNormalList( size_t& aListSize, SGVECTOR*& aNormalList );
     void SetNormalList( size_t aListSize, const SGVECTOR* aNormalList );
+    void SetNormalList( std::vector< SGVECTOR >&& aNormalList );
     void AddNormal( double aXValue, double aYValue, double aZValue );
     void AddNormal( const SGVECTOR& aNormal );
 
-    void ReNameNodes( void );
-    bool WriteVRML( std::ofstream& aFile, bool aReuseFlag );
+    bool WriteVRML( std::ofstream& aFile, bool aReuseFlag, SGWRITE& aState ) const;
 
-    bool WriteCache( std::ofstream& aFile, SGNODE* parentNode );
+    bool WriteCache( std::ofstream& aFile, SGWRITE& aState ) const;
     bool ReadCache( std::ifstream& aFile, SGNODE* parentNode );
 };
 
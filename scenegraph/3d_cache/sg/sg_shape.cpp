@@ -29,6 +29,7 @@
 
 #include "3d_cache/sg/sg_shape.h"
 #include "3d_cache/sg/sg_faceset.h"
+#include "3d_cache/sg/sg_lineset.h"
 #include "3d_cache/sg/sg_appearance.h"
 #include "3d_cache/sg/sg_helpers.h"
 #include "3d_cache/sg/sg_coordindex.h"
@@ -37,6 +38,22 @@
 #include "3d_cache/sg/sg_normals.h"
 
 
+// transform the points of aCoords selected by aIndices one at a time
+static void transformPoints( const SGCOORDS* aCoords, const std::vector< int >& aIndices,
+                             const glm::dmat4& aTransform, SFVEC3F* aResult )
+{
+    for( size_t i = 0; i < aIndices.size(); ++i )
+    {
+        SGPOINT vp = aCoords->GetPoint( aIndices[i] );
+        glm::dvec4 pt( vp.x, vp.y, vp.z, 1.0 );
+        pt = aTransform * pt;
+        aResult[i] = SFVEC3F( pt.x, pt.y, pt.z );
+    }
+
+    return;
+}
+
+
 SGSHAPE::SGSHAPE( SGNODE* aParent ) : SGNODE( aParent )
 {
     m_SGtype = S3D::SGTYPE_SHAPE;
@@ -44,6 +61,8 @@ SGSHAPE::SGSHAPE( SGNODE* aParent ) : SGNODE( aParent )
     m_RAppearance = NULL;
     m_FaceSet = NULL;
     m_RFaceSet = NULL;
+    m_LineSet = NULL;
+    m_RLineSet = NULL;
 
     if( NULL != aParent && S3D::SGTYPE_TRANSFORM != aParent->GetNodeType() )
     {
@@ -69,33 +88,46 @@ SGSHAPE::SGSHAPE( SGNODE* aParent ) : SGNODE( aParent )
 SGSHAPE::~SGSHAPE()
 {
     // drop references
-    if( m_RAppearance )
+    if( m_RAppearance && !isReleased( m_RAppearance ) )
     {
         m_RAppearance->delNodeRef( this );
         m_RAppearance = NULL;
     }
 
-    if( m_RFaceSet )
+    if( m_RFaceSet && !isReleased( m_RFaceSet ) )
     {
         m_RFaceSet->delNodeRef( this );
         m_RFaceSet = NULL;
     }
 
+    if( m_RLineSet && !isReleased( m_RLineSet ) )
+    {
+        m_RLineSet->delNodeRef( this );
+        m_RLineSet = NULL;
+    }
+
     // delete objects
-    if( m_Appearance )
+    if( m_Appearance && !isReleased( m_Appearance ) )
     {
         m_Appearance->SetParent( NULL, false );
         delete m_Appearance;
         m_Appearance = NULL;
     }
 
-    if( m_FaceSet )
+    if( m_FaceSet && !isReleased( m_FaceSet ) )
     {
         m_FaceSet->SetParent( NULL, false );
         delete m_FaceSet;
         m_FaceSet = NULL;
     }
 
+    if( m_LineSet && !isReleased( m_LineSet ) )
+    {
+        m_LineSet->SetParent( NULL, false );
+        delete m_LineSet;
+        m_LineSet = NULL;
+    }
+
     return;
 }
 
@@ -135,7 +167,7 @@ SGNODE* SGSHAPE::FindNode(const char *aNodeName, const SGNODE *aCaller)
     if( NULL == aNodeName || 0 == aNodeName[0] )
         return NULL;
 
-    if( !m_Name.compare( aNodeName ) )
+    if( isNamed( aNodeName ) )
         return this;
 
     SGNODE* tmp = NULL;
@@ -160,6 +192,16 @@ SGNODE* SGSHAPE::FindNode(const char *aNodeName, const SGNODE *aCaller)
         }
     }
 
+    if( NULL != m_LineSet )
+    {
+        tmp = m_LineSet->FindNode( aNodeName, this );
+
+        if( tmp )
+        {
+            return tmp;
+        }
+    }
+
     // query the parent if appropriate
     if( aCaller == m_Parent || NULL == m_Parent )
         return NULL;
@@ -173,6 +215,9 @@ void SGSHAPE::unlinkNode( const SGNODE* aNode, bool isChild )
     if( NULL == aNode )
         return;
 
+    if( S3D::SGTYPE_APPEARANCE != aNode->GetNodeType() )
+        invalidateBounds();
+
     if( isChild )
     {
         if( aNode == m_Appearance )
@@ -186,6 +231,12 @@ void SGSHAPE::unlinkNode( const SGNODE* aNode, bool isChild )
             m_FaceSet = NULL;
             return;
         }
+
+        if( aNode == m_LineSet )
+        {
+            m_LineSet = NULL;
+            return;
+        }
     }
     else
     {
@@ -202,6 +253,12 @@ void SGSHAPE::unlinkNode( const SGNODE* aNode, bool isChild )
             m_RFaceSet = NULL;
             return;
         }
+
+        if( aNode == m_RLineSet )
+        {
+            m_RLineSet = NULL;
+            return;
+        }
     }
 
     #ifdef DEBUG
@@ -245,6 +302,9 @@ bool SGSHAPE::addNode( SGNODE* aNode, bool isChild )
         return false;
     }
 
+    if( S3D::SGTYPE_APPEARANCE != aNode->GetNodeType() )
+        invalidateBounds();
+
     if( S3D::SGTYPE_APPEARANCE == aNode->GetNodeType() )
     {
         if( m_Appearance || m_RAppearance )
@@ -297,6 +357,18 @@ bool SGSHAPE::addNode( SGNODE* aNode, bool isChild )
             return true;
         }
 
+        if( m_LineSet || m_RLineSet )
+        {
+            #ifdef DEBUG
+            std::ostringstream ostr;
+            ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
+            ostr << " * [BUG] assigning a FaceSet to a Shape with a LineSet";
+            wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
+            #endif
+
+            return false;
+        }
+
         if( isChild )
         {
             m_FaceSet = (SGFACESET*)aNode;
@@ -311,6 +383,51 @@ bool SGSHAPE::addNode( SGNODE* aNode, bool isChild )
         return true;
     }
 
+    if( S3D::SGTYPE_LINESET == aNode->GetNodeType() )
+    {
+        if( m_LineSet || m_RLineSet )
+        {
+            if( aNode != m_LineSet && aNode != m_RLineSet )
+            {
+                #ifdef DEBUG
+                std::ostringstream ostr;
+                ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
+                ostr << " * [BUG] assigning multiple LineSet nodes";
+                wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
+                #endif
+
+                return false;
+            }
+
+            return true;
+        }
+
+        if( m_FaceSet || m_RFaceSet )
+        {
+            #ifdef DEBUG
+            std::ostringstream ostr;
+            ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
+            ostr << " * [BUG] assigning a LineSet to a Shape with a FaceSet";
+            wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
+            #endif
+
+            return false;
+        }
+
+        if( isChild )
+        {
+            m_LineSet = (SGLINESET*)aNode;
+            m_LineSet->SetParent( this );
+        }
+        else
+        {
+            m_RLineSet = (SGLINESET*)aNode;
+            m_RLineSet->addNodeRef( this );
+        }
+
+        return true;
+    }
+
     #ifdef DEBUG
     do {
         std::ostringstream ostr;
@@ -325,42 +442,41 @@ bool SGSHAPE::addNode( SGNODE* aNode, bool isChild )
 }
 
 
-bool SGSHAPE::AddRefNode( SGNODE* aNode )
+bool SGSHAPE::GetBounds( SGBOUNDS& aBounds ) const
 {
-    return addNode( aNode, false );
-}
+    SGFACESET* pf = m_FaceSet ? m_FaceSet : m_RFaceSet;
+    SGLINESET* pl = m_LineSet ? m_LineSet : m_RLineSet;
+    SGBOUNDS bounds;
 
+    aBounds = SGBOUNDS();
 
-bool SGSHAPE::AddChildNode( SGNODE* aNode )
-{
-    return addNode( aNode, true );
-}
+    if( NULL != pf && pf->GetBounds( bounds ) )
+        aBounds.Add( bounds );
 
+    if( NULL != pl && pl->GetBounds( bounds ) )
+        aBounds.Add( bounds );
 
-void SGSHAPE::ReNameNodes( void )
-{
-    m_written = false;
+    return !aBounds.IsEmpty();
+}
 
-    // rename this node
-    m_Name.clear();
-    GetName();
 
-    // rename Appearance
-    if( m_Appearance )
-        m_Appearance->ReNameNodes();
+bool SGSHAPE::AddRefNode( SGNODE* aNode )
+{
+    return addNode( aNode, false );
+}
 
-    // rename FaceSet
-    if( m_FaceSet )
-        m_FaceSet->ReNameNodes();
 
-    return;
+bool SGSHAPE::AddChildNode( SGNODE* aNode )
+{
+    return addNode( aNode, true );
 }
 
 
-bool SGSHAPE::WriteVRML( std::ofstream& aFile, bool aReuseFlag )
+bool SGSHAPE::WriteVRML( std::ofstream& aFile, bool aReuseFlag, SGWRITE& aState ) const
 {
     if( !m_Appearance && !m_RAppearance
-        && !m_FaceSet && !m_RFaceSet )
+        && !m_FaceSet && !m_RFaceSet
+        && !m_LineSet && !m_RLineSet )
     {
         return false;
     }
@@ -369,14 +485,13 @@ bool SGSHAPE::WriteVRML( std::ofstream& aFile, bool aReuseFlag )
 
     if( aReuseFlag )
     {
-        if( !m_written )
+        if( aState.SetWritten( this ) )
         {
-            aFile << "DEF " << GetName() << " Shape {\n";
-            m_written = true;
+            aFile << "DEF " << aState.Name( this ) << " Shape {\n";
         }
         else
         {
-            aFile << " USE " << GetName() << "\n";
+            aFile << " USE " << aState.Name( this ) << "\n";
             return true;
         }
     }
@@ -386,16 +501,22 @@ bool SGSHAPE::WriteVRML( std::ofstream& aFile, bool aReuseFlag )
     }
 
     if( m_Appearance )
-        m_Appearance->WriteVRML( aFile, aReuseFlag );
+        m_Appearance->WriteVRML( aFile, aReuseFlag, aState );
 
     if( m_RAppearance )
-        m_RAppearance->WriteVRML( aFile, aReuseFlag );
+        m_RAppearance->WriteVRML( aFile, aReuseFlag, aState );
 
     if( m_FaceSet )
-        m_FaceSet->WriteVRML( aFile, aReuseFlag );
+        m_FaceSet->WriteVRML( aFile, aReuseFlag, aState );
 
     if( m_RFaceSet )
-        m_RFaceSet->WriteVRML( aFile, aReuseFlag );
+        m_RFaceSet->WriteVRML( aFile, aReuseFlag, aState );
+
+    if( m_LineSet )
+        m_LineSet->WriteVRML( aFile, aReuseFlag, aState );
+
+    if( m_RLineSet )
+        m_RLineSet->WriteVRML( aFile, aReuseFlag, aState );
 
     aFile << "}\n";
 
@@ -403,48 +524,8 @@ bool SGSHAPE::WriteVRML( std::ofstream& aFile, bool aReuseFlag )
 }
 
 
-bool SGSHAPE::WriteCache( std::ofstream& aFile, SGNODE* parentNode )
+bool SGSHAPE::WriteCache( std::ofstream& aFile, SGWRITE& aState ) const
 {
-    if( NULL == parentNode )
-    {
-        if( NULL == m_Parent )
-        {
-            #ifdef DEBUG
-            std::ostringstream ostr;
-            ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
-            ostr << " * [BUG] corrupt data; m_aParent is NULL";
-            wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
-            #endif
-
-            return false;
-        }
-
-        SGNODE* np = m_Parent;
-
-        while( NULL != np->GetParent() )
-            np = np->GetParent();
-
-        if( np->WriteCache( aFile, NULL ) )
-        {
-            m_written = true;
-            return true;
-        }
-
-        return false;
-    }
-
-    if( parentNode != m_Parent )
-    {
-        #ifdef DEBUG
-        std::ostringstream ostr;
-        ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
-        ostr << " * [BUG] corrupt data; parentNode != m_aParent";
-        wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
-        #endif
-
-        return false;
-    }
-
     if( !aFile.good() )
     {
         #ifdef DEBUG
@@ -457,63 +538,56 @@ bool SGSHAPE::WriteCache( std::ofstream& aFile, SGNODE* parentNode )
         return false;
     }
 
-    // check if any references are unwritten and swap parents if so
-    if( NULL != m_RAppearance && !m_RAppearance->isWritten() )
-        m_RAppearance->SwapParent(this);
+    // a referenced node which hadn't been written is written in full
+    // and a child which had already been written is written as a reference
+    const SGAPPEARANCE* app = m_Appearance ? m_Appearance : m_RAppearance;
+    const SGFACESET* face = m_FaceSet ? m_FaceSet : m_RFaceSet;
+    const SGLINESET* lines = m_LineSet ? m_LineSet : m_RLineSet;
 
-    if( NULL != m_RFaceSet && !m_RFaceSet->isWritten() )
-        m_RFaceSet->SwapParent( this );
-
-    aFile << "[" << GetName() << "]";
-    #define NITEMS 4
+    aState.SetWritten( this );
+    aFile << "[" << aState.Name( this ) << "]";
+    #define NITEMS 6
     bool items[NITEMS];
-    int i;
-
-    for( i = 0; i < NITEMS; ++i )
-        items[i] = 0;
-
-    i = 0;
-    if( NULL != m_Appearance )
-        items[i] = true;
-
-    ++i;
-    if( NULL != m_RAppearance )
-        items[i] = true;
 
-    ++i;
-    if( NULL != m_FaceSet )
-        items[i] = true;
-
-    ++i;
-    if( NULL != m_RFaceSet )
-        items[i] = true;
+    items[0] = NULL != app && !aState.IsWritten( app );
+    items[1] = NULL != app && !items[0];
+    items[2] = NULL != face && !aState.IsWritten( face );
+    items[3] = NULL != face && !items[2];
+    items[4] = NULL != lines && !aState.IsWritten( lines );
+    items[5] = NULL != lines && !items[4];
 
     for( int i = 0; i < NITEMS; ++i )
         aFile.write( (char*)&items[i], sizeof(bool) );
 
     if( items[0] )
-        m_Appearance->WriteCache( aFile, this );
+        app->WriteCache( aFile, aState );
 
     if( items[1] )
-        aFile << "[" << m_RAppearance->GetName() << "]";
+        aFile << "[" << aState.Name( app ) << "]";
 
     if( items[2] )
-        m_FaceSet->WriteCache( aFile, this );
+        face->WriteCache( aFile, aState );
 
     if( items[3] )
-        aFile << "[" << m_RFaceSet->GetName() << "]";
+        aFile << "[" << aState.Name( face ) << "]";
+
+    if( items[4] )
+        lines->WriteCache( aFile, aState );
+
+    if( items[5] )
+        aFile << "[" << aState.Name( lines ) << "]";
 
     if( aFile.fail() )
         return false;
 
-    m_written = true;
     return true;
 }
 
 
 bool SGSHAPE::ReadCache( std::ifstream& aFile, SGNODE* parentNode )
 {
-    if( m_Appearance || m_RAppearance || m_FaceSet || m_RFaceSet )
+    if( m_Appearance || m_RAppearance || m_FaceSet || m_RFaceSet
+        || m_LineSet || m_RLineSet )
     {
         #ifdef DEBUG
         std::ostringstream ostr;
@@ -525,13 +599,15 @@ bool SGSHAPE::ReadCache( std::ifstream& aFile, SGNODE* parentNode )
         return false;
     }
 
-    #define NITEMS 4
+    #define NITEMS 6
     bool items[NITEMS];
 
     for( int i = 0; i < NITEMS; ++i )
         aFile.read( (char*)&items[i], sizeof(bool) );
 
-    if( ( items[0] && items[1] ) || ( items[2] && items[3] ) )
+    if( ( items[0] && items[1] ) || ( items[2] && items[3] )
+        || ( items[4] && items[5] )
+        || ( ( items[2] || items[3] ) && ( items[4] || items[5] ) ) )
     {
         #ifdef DEBUG
         std::ostringstream ostr;
@@ -561,8 +637,8 @@ bool SGSHAPE::ReadCache( std::ifstream& aFile, SGNODE* parentNode )
             return false;
         }
 
-        m_Appearance = new SGAPPEARANCE( this );
-        m_Appearance->SetName( name.c_str() );
+        m_Appearance = new( this ) SGAPPEARANCE( this );
+        m_Appearance->readName( name );
 
         if( !m_Appearance->ReadCache( aFile, this ) )
         {
@@ -593,7 +669,7 @@ bool SGSHAPE::ReadCache( std::ifstream& aFile, SGNODE* parentNode )
             return false;
         }
 
-        SGNODE* np = FindNode( name.c_str(), this );
+        SGNODE* np = findReadNode( name );
 
         if( !np )
         {
@@ -640,8 +716,8 @@ bool SGSHAPE::ReadCache( std::ifstream& aFile, SGNODE* parentNode )
             return false;
         }
 
-        m_FaceSet = new SGFACESET( this );
-        m_FaceSet->SetName( name.c_str() );
+        m_FaceSet = new( this ) SGFACESET( this );
+        m_FaceSet->readName( name );
 
         if( !m_FaceSet->ReadCache( aFile, this ) )
         {
@@ -672,7 +748,7 @@ bool SGSHAPE::ReadCache( std::ifstream& aFile, SGNODE* parentNode )
             return false;
         }
 
-        SGNODE* np = FindNode( name.c_str(), this );
+        SGNODE* np = findReadNode( name );
 
         if( !np )
         {
@@ -704,6 +780,85 @@ bool SGSHAPE::ReadCache( std::ifstream& aFile, SGNODE* parentNode )
         m_RFaceSet->addNodeRef( this );
     }
 
+    if( items[4] )
+    {
+        if( S3D::SGTYPE_LINESET != S3D::ReadTag( aFile, name ) )
+        {
+            #ifdef DEBUG
+            std::ostringstream ostr;
+            ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
+            ostr << " * [INFO] corrupt data; bad child line set tag at position ";
+            ostr << aFile.tellg();
+            wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
+            #endif
+
+            return false;
+        }
+
+        m_LineSet = new( this ) SGLINESET( this );
+        m_LineSet->readName( name );
+
+        if( !m_LineSet->ReadCache( aFile, this ) )
+        {
+            #ifdef DEBUG
+            std::ostringstream ostr;
+            ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
+            ostr << " * [INFO] corrupt data while reading line set '";
+            ostr << name << "'";
+            wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
+            #endif
+
+            return false;
+        }
+    }
+
+    if( items[5] )
+    {
+        if( S3D::SGTYPE_LINESET != S3D::ReadTag( aFile, name ) )
+        {
+            #ifdef DEBUG
+            std::ostringstream ostr;
+            ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
+            ostr << " * [INFO] corrupt data; bad ref line set tag at position ";
+            ostr << aFile.tellg();
+            wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
+            #endif
+
+            return false;
+        }
+
+        SGNODE* np = findReadNode( name );
+
+        if( !np )
+        {
+            #ifdef DEBUG
+            std::ostringstream ostr;
+            ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
+            ostr << " * [INFO] corrupt data: cannot find ref line set '";
+            ostr << name << "'";
+            wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
+            #endif
+
+            return false;
+        }
+
+        if( S3D::SGTYPE_LINESET != np->GetNodeType() )
+        {
+            #ifdef DEBUG
+            std::ostringstream ostr;
+            ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
+            ostr << " * [INFO] corrupt data: type is not SGLINESET '";
+            ostr << name << "'";
+            wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
+            #endif
+
+            return false;
+        }
+
+        m_RLineSet = (SGLINESET*)np;
+        m_RLineSet->addNodeRef( this );
+    }
+
     if( aFile.fail() )
         return false;
 
@@ -711,9 +866,12 @@ bool SGSHAPE::ReadCache( std::ifstream& aFile, SGNODE* parentNode )
 }
 
 
-bool SGSHAPE::Prepare( const glm::dmat4* aTransform,
-    S3D::MATLIST& materials, std::vector< SMESH >& meshes )
+bool SGSHAPE::Prepare( const glm::dmat4* aTransform, S3D::MATLIST& materials,
+    std::vector< SMESH >& meshes, std::vector< SLINESET >& lines )
 {
+    if( NULL != m_LineSet || NULL != m_RLineSet )
+        return prepareLines( aTransform, materials, lines );
+
     SMESH m;
     S3D::INIT_SMESH( m );
 
@@ -774,9 +932,7 @@ bool SGSHAPE::Prepare( const glm::dmat4* aTransform,
         pn = pf->m_RNormals;
 
     // set the vertex points and indices
-    size_t nCoords = 0;
-    SGPOINT* pCoords = NULL;
-    pv->GetCoordsList( nCoords, pCoords );
+    size_t nCoords = pv->GetSize();
 
     size_t nColors = 0;
     SGCOLOR* pColors = NULL;
@@ -804,18 +960,17 @@ bool SGSHAPE::Prepare( const glm::dmat4* aTransform,
     int*   lv = NULL;
     vidx->GetIndices( nvidx, lv );
 
-    // note: reduce the vertex set to include only the referenced vertices
+    // note: reduce the vertex set to include only the referenced vertices;
+    // the indices were range checked by validate() so a flat table is used
+    // rather than a map since merged face sets may hold many vertices
     std::vector< int > vertices;            // store the list of temp vertex indices
-    std::map< int, unsigned int > indexmap; // map temp vertex to true vertex
-    std::map< int, unsigned int >::iterator mit;
+    std::vector< int > indexmap( nCoords, -1 ); // map temp vertex to true vertex
 
     for( unsigned int i = 0; i < nvidx; ++i )
     {
-        mit = indexmap.find( lv[i] );
-
-        if( mit == indexmap.end() )
+        if( indexmap[lv[i]] < 0 )
         {
-            indexmap.insert( std::pair< int, unsigned int >( lv[i], vertices.size() ) );
+            indexmap[lv[i]] = (int)vertices.size();
             vertices.push_back( lv[i] );
         }
     }
@@ -843,25 +998,30 @@ bool SGSHAPE::Prepare( const glm::dmat4* aTransform,
     }
 
 
-    if( pc )
+    // when most of the vertices are used, single precision lanes are
+    // transformed as a whole by the vectorized kernel
+    bool wholeList = vertices.size() * 2 >= nCoords;
+    std::vector< SFVEC3F > tCoords;
+
+    if( wholeList && pv->IsSinglePrecision() )
     {
+        tCoords.resize( nCoords );
+        pv->TransformPoints( *aTransform, &tCoords[0] );
+
         for( size_t i = 0; i < vertices.size(); ++i )
-        {
-            ti = vertices[i];
-            glm::dvec4 pt( pCoords[ti].x, pCoords[ti].y, pCoords[ti].z, 1.0 );
-            pt = (*aTransform) * pt;
-            pColors[ti].GetColor( lColors[i].x, lColors[i].y, lColors[i].z );
-            lCoords[i] = SFVEC3F( pt.x, pt.y, pt.z );
-        }
+            lCoords[i] = tCoords[vertices[i]];
     }
     else
+    {
+        transformPoints( pv, vertices, *aTransform, lCoords );
+    }
+
+    if( pc )
     {
         for( size_t i = 0; i < vertices.size(); ++i )
         {
             ti = vertices[i];
-            glm::dvec4 pt( pCoords[ti].x, pCoords[ti].y, pCoords[ti].z, 1.0 );
-            pt = (*aTransform) * pt;
-            lCoords[i] = SFVEC3F( pt.x, pt.y, pt.z );
+            pColors[ti].GetColor( lColors[i].x, lColors[i].y, lColors[i].z );
         }
     }
 
@@ -870,30 +1030,35 @@ bool SGSHAPE::Prepare( const glm::dmat4* aTransform,
     unsigned int* lvidx = new unsigned int[ nvidx ];
 
     for( unsigned int i = 0; i < nvidx; ++i )
-    {
-        mit = indexmap.find( lv[i] );
-        lvidx[i] = mit->second;
-    }
+        lvidx[i] = (unsigned int)indexmap[lv[i]];
 
     m.m_FaceIdxSize = (unsigned int )nvidx;
     m.m_FaceIdx = lvidx;
 
     // set the per-vertex normals
-    size_t nNorms = 0;
-    SGVECTOR* pNorms = NULL;
-    double x, y, z;
-
-    pn->GetNormalList( nNorms, pNorms );
     SFVEC3F* lNorms = new SFVEC3F[ vertices.size() ];
 
-    for( size_t i = 0; i < vertices.size(); ++i )
+    if( wholeList && pn->IsSinglePrecision() )
     {
-        ti = vertices[i];
-        pNorms[ti].GetVector( x, y, z );
-        glm::dvec4 pt( x, y, z, 0.0 );
-        pt = (*aTransform) * pt;
+        // the normals parallel the vertices
+        tCoords.resize( nCoords );
+        pn->TransformNormals( *aTransform, &tCoords[0] );
 
-        lNorms[i] = SFVEC3F( pt.x, pt.y, pt.z );
+        for( size_t i = 0; i < vertices.size(); ++i )
+            lNorms[i] = tCoords[vertices[i]];
+    }
+    else
+    {
+        double x, y, z;
+
+        for( size_t i = 0; i < vertices.size(); ++i )
+        {
+            pn->GetNormal( vertices[i], x, y, z );
+            glm::dvec4 pt( x, y, z, 0.0 );
+            pt = (*aTransform) * pt;
+
+            lNorms[i] = SFVEC3F( pt.x, pt.y, pt.z );
+        }
     }
 
     m.m_Normals = lNorms;
@@ -901,3 +1066,114 @@ bool SGSHAPE::Prepare( const glm::dmat4* aTransform,
 
     return true;
 }
+
+
+bool SGSHAPE::prepareLines( const glm::dmat4* aTransform, S3D::MATLIST& materials,
+    std::vector< SLINESET >& lines )
+{
+    SGAPPEARANCE* pa = m_Appearance;
+    SGLINESET* pl = m_LineSet;
+
+    if( NULL == pa )
+        pa = m_RAppearance;
+
+    if( NULL == pl )
+        pl = m_RLineSet;
+
+    if( !pl->validate() )
+    {
+#ifdef DEBUG
+        std::ostringstream ostr;
+        ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
+        ostr << " * [INFO] bad model; inconsistent line data";
+        wxLogTrace( MASK_3D_SG, "%s\n", ostr.str().c_str() );
+#endif
+        return true;
+    }
+
+    SLINESET m;
+    S3D::INIT_SLINESET( m );
+
+    int idx;
+
+    if( NULL == pa || !S3D::GetMatIndex( materials, pa, idx ) )
+        m.m_MaterialIdx = 0;
+    else
+        m.m_MaterialIdx = idx;
+
+    SGCOORDS* pv = pl->m_Coords;
+
+    if( NULL == pv )
+        pv = pl->m_RCoords;
+
+    size_t nvidx = 0;
+    int*   lv = NULL;
+    pl->m_CoordIndices->GetIndices( nvidx, lv );
+
+    // note: the polylines are split into segments and the vertex set is
+    // reduced to include only the referenced vertices
+    std::vector< int > vertices;
+    std::vector< unsigned int > segments;
+    std::map< int, unsigned int > indexmap;
+    std::map< int, unsigned int >::iterator mit;
+    int lastIdx = -1;
+
+    for( size_t i = 0; i < nvidx; ++i )
+    {
+        if( lv[i] < 0 )
+        {
+            lastIdx = -1;
+            continue;
+        }
+
+        mit = indexmap.find( lv[i] );
+
+        if( mit == indexmap.end() )
+        {
+            mit = indexmap.insert( std::pair< int, unsigned int >( lv[i],
+                (unsigned int) vertices.size() ) ).first;
+            vertices.push_back( lv[i] );
+        }
+
+        if( lastIdx >= 0 )
+        {
+            segments.push_back( (unsigned int) lastIdx );
+            segments.push_back( mit->second );
+        }
+
+        lastIdx = (int) mit->second;
+    }
+
+    // no segments = nothing to render, which is valid though pointless
+    if( segments.empty() )
+        return true;
+
+    SFVEC3F* lCoords = new SFVEC3F[ vertices.size() ];
+    size_t nCoords = pv->GetSize();
+
+    if( vertices.size() * 2 >= nCoords && pv->IsSinglePrecision() )
+    {
+        std::vector< SFVEC3F > tCoords( nCoords );
+        pv->TransformPoints( *aTransform, &tCoords[0] );
+
+        for( size_t i = 0; i < vertices.size(); ++i )
+            lCoords[i] = tCoords[vertices[i]];
+    }
+    else
+    {
+        transformPoints( pv, vertices, *aTransform, lCoords );
+    }
+
+    unsigned int* lidx = new unsigned int[ segments.size() ];
+
+    for( size_t i = 0; i < segments.size(); ++i )
+        lidx[i] = segments[i];
+
+    m.m_VertexSize = (unsigned int) vertices.size();
+    m.m_Positions = lCoords;
+    m.m_LineIdxSize = (unsigned int) segments.size();
+    m.m_LineIdx = lidx;
+    lines.push_back( m );
+
+    return true;
+}
@@ -35,6 +35,7 @@
 
 class SGAPPEARANCE;
 class SGFACESET;
+class SGLINESET;
 
 class SGSHAPE : public SGNODE
 {
@@ -46,10 +47,12 @@ public:
     // owned node
     SGAPPEARANCE* m_Appearance;
     SGFACESET*    m_FaceSet;
+    SGLINESET*    m_LineSet;
 
     // referenced nodes
     SGAPPEARANCE* m_RAppearance;
     SGFACESET*    m_RFaceSet;
+    SGLINESET*    m_RLineSet;
 
     void unlinkChildNode( const SGNODE* aNode );
     void unlinkRefNode( const SGNODE* aNode );
@@ -64,14 +67,20 @@ public:
     bool AddRefNode( SGNODE* aNode );
     bool AddChildNode( SGNODE* aNode );
 
-    void ReNameNodes( void );
-    bool WriteVRML( std::ofstream& aFile, bool aReuseFlag );
+    // returns the bounds of the geometry of this shape
+    bool GetBounds( SGBOUNDS& aBounds ) const;
 
-    bool WriteCache( std::ofstream& aFile, SGNODE* parentNode );
+    bool WriteVRML( std::ofstream& aFile, bool aReuseFlag, SGWRITE& aState ) const;
+
+    bool WriteCache( std::ofstream& aFile, SGWRITE& aState ) const;
     bool ReadCache( std::ifstream& aFile, SGNODE* parentNode );
 
-    bool Prepare( const glm::dmat4* aTransform,
-        S3D::MATLIST& materials, std::vector< SMESH >& meshes );
+    bool Prepare( const glm::dmat4* aTransform, S3D::MATLIST& materials,
+        std::vector< SMESH >& meshes, std::vector< SLINESET >& lines );
+
+private:
+    bool prepareLines( const glm::dmat4* aTransform, S3D::MATLIST& materials,
+        std::vector< SLINESET >& lines );
 };
 
 /*
@@ -80,6 +89,9 @@ public:
         appearance  NULL
         geometry    NULL
     }
+
+    The geometry is either an IndexedFaceSet or an IndexedLineSet
+    but never both.
 */
 
 #endif  // SG_SHAPE_H
@@ -0,0 +1,183 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2015 Cirilo Bernardo <cirilo.bernardo@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <unordered_set>
+#include <vector>
+
+#include "3d_cache/sg/sg_visitor.h"
+#include "3d_cache/sg/scenegraph.h"
+#include "3d_cache/sg/sg_shape.h"
+#include "3d_cache/sg/sg_faceset.h"
+#include "3d_cache/sg/sg_lineset.h"
+#include "3d_cache/sg/sg_appearance.h"
+#include "3d_cache/sg/sg_colors.h"
+#include "3d_cache/sg/sg_coords.h"
+#include "3d_cache/sg/sg_coordindex.h"
+#include "3d_cache/sg/sg_normals.h"
+
+
+/**
+ * Class SGWALK
+ * holds the state of a traversal
+ */
+class SGWALK
+{
+private:
+    SGVISITOR& m_Visitor;
+    int m_Flags;
+    std::unordered_set< const SGNODE* > m_Visited;  // nodes visited when SGWALK_ONCE is set
+
+    template< typename T >
+    bool visitList( const std::vector< T* >& aList, SGNODE* aParent,
+                    const glm::dmat4* aTransform, int aDepth, bool isRef )
+    {
+        for( size_t i = 0; i < aList.size(); ++i )
+        {
+            if( !Visit( aList[i], aParent, aTransform, aDepth, isRef ) )
+                return false;
+        }
+
+        return true;
+    }
+
+public:
+    SGWALK( SGVISITOR& aVisitor, int aFlags ) : m_Visitor( aVisitor ), m_Flags( aFlags )
+    {
+        return;
+    }
+
+    bool Visit( SGNODE* aNode, SGNODE* aParent, const glm::dmat4* aTransform,
+                int aDepth, bool isRef );
+};
+
+
+bool SGWALK::Visit( SGNODE* aNode, SGNODE* aParent, const glm::dmat4* aTransform,
+                    int aDepth, bool isRef )
+{
+    if( NULL == aNode || ( isRef && !( m_Flags & SGWALK_REFS ) ) )
+        return true;
+
+    if( ( m_Flags & SGWALK_ONCE ) && !m_Visited.insert( aNode ).second )
+        return true;
+
+    SGVISIT visit;
+    visit.node = aNode;
+    visit.parent = aParent;
+    visit.transform = aTransform;
+    visit.depth = aDepth;
+    visit.isRef = isRef;
+
+    S3D::SGTYPES type = aNode->GetNodeType();
+    glm::dmat4 tx;
+
+    if( S3D::SGTYPE_TRANSFORM == type && ( m_Flags & SGWALK_TRANSFORMS ) )
+    {
+        tx = static_cast< SCENEGRAPH* >( aNode )->GetTransform();
+
+        if( NULL != aTransform )
+            tx = (*aTransform) * tx;
+
+        visit.transform = &tx;
+    }
+
+    SGVISIT_ACTION act = m_Visitor.Pre( visit );
+
+    if( SGVISIT_STOP == act )
+        return false;
+
+    if( SGVISIT_SKIP == act )
+        return true;
+
+    const glm::dmat4* ctx = visit.transform;
+    bool ok = true;
+    ++aDepth;
+
+    switch( type )
+    {
+    case S3D::SGTYPE_TRANSFORM:
+        {
+            SCENEGRAPH* np = static_cast< SCENEGRAPH* >( aNode );
+            ok = visitList( np->m_Shape, aNode, ctx, aDepth, false )
+                 && visitList( np->m_Transforms, aNode, ctx, aDepth, false )
+                 && visitList( np->m_RShape, aNode, ctx, aDepth, true )
+                 && visitList( np->m_RTransforms, aNode, ctx, aDepth, true );
+        }
+        break;
+
+    case S3D::SGTYPE_SHAPE:
+        {
+            SGSHAPE* np = static_cast< SGSHAPE* >( aNode );
+            ok = Visit( np->m_Appearance, aNode, ctx, aDepth, false )
+                 && Visit( np->m_FaceSet, aNode, ctx, aDepth, false )
+                 && Visit( np->m_LineSet, aNode, ctx, aDepth, false )
+                 && Visit( np->m_RAppearance, aNode, ctx, aDepth, true )
+                 && Visit( np->m_RFaceSet, aNode, ctx, aDepth, true )
+                 && Visit( np->m_RLineSet, aNode, ctx, aDepth, true );
+        }
+        break;
+
+    case S3D::SGTYPE_FACESET:
+        {
+            SGFACESET* np = static_cast< SGFACESET* >( aNode );
+            ok = Visit( np->m_Colors, aNode, ctx, aDepth, false )
+                 && Visit( np->m_Coords, aNode, ctx, aDepth, false )
+                 && Visit( np->m_CoordIndices, aNode, ctx, aDepth, false )
+                 && Visit( np->m_Normals, aNode, ctx, aDepth, false )
+                 && Visit( np->m_RColors, aNode, ctx, aDepth, true )
+                 && Visit( np->m_RCoords, aNode, ctx, aDepth, true )
+                 && Visit( np->m_RNormals, aNode, ctx, aDepth, true );
+        }
+        break;
+
+    case S3D::SGTYPE_LINESET:
+        {
+            SGLINESET* np = static_cast< SGLINESET* >( aNode );
+            ok = Visit( np->m_Coords, aNode, ctx, aDepth, false )
+                 && Visit( np->m_CoordIndices, aNode, ctx, aDepth, false )
+                 && Visit( np->m_RCoords, aNode, ctx, aDepth, true );
+        }
+        break;
+
+    default:
+        // the remaining node types hold no other nodes
+        break;
+    }
+
+    if( !ok )
+        return false;
+
+    m_Visitor.Post( visit );
+    return true;
+}
+
+
+bool S3D::Walk( SGNODE* aNode, SGVISITOR& aVisitor, int aFlags,
+                const glm::dmat4* aTransform )
+{
+    if( NULL == aNode )
+        return true;
+
+    SGWALK walk( aVisitor, aFlags );
+
+    return walk.Visit( aNode, NULL, aTransform, 0, false );
+}
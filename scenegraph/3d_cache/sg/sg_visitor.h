@@ -0,0 +1,124 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2015 Cirilo Bernardo <cirilo.bernardo@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file sg_visitor.h
+ * defines a generic depth first traversal of the scene graph; an analysis
+ * of the scene graph is written as a visitor rather than as yet another
+ * virtual function implemented by each type of node.
+ */
+
+#ifndef SG_VISITOR_H
+#define SG_VISITOR_H
+
+#include <glm/glm.hpp>
+
+class SGNODE;
+
+
+// options of a traversal
+enum SGWALK_FLAGS
+{
+    SGWALK_REFS       = 1,      // follow references as well as owned nodes
+    SGWALK_ONCE       = 2,      // visit each node at most once
+    SGWALK_TRANSFORMS = 4       // carry the accumulated transform
+};
+
+// action returned by SGVISITOR::Pre()
+enum SGVISIT_ACTION
+{
+    SGVISIT_CONTINUE = 0,       // visit the nodes beneath this node
+    SGVISIT_SKIP,               // do not visit the nodes beneath this node
+    SGVISIT_STOP                // end the traversal
+};
+
+
+/**
+ * Struct SGVISIT
+ * describes a node reached during a traversal
+ */
+struct SGVISIT
+{
+    SGNODE* node;               // node being visited
+    SGNODE* parent;             // node via which this node was reached; NULL at the start
+    const glm::dmat4* transform;    // accumulated transform, including that of node if
+                                    // it is a transform; NULL if transforms are not carried
+    int     depth;              // 0 for the node at which the traversal started
+    bool    isRef;              // true if the node was reached via a reference
+};
+
+
+/**
+ * Class SGVISITOR
+ * is the base class of the operations applied to nodes by S3D::Walk()
+ */
+class SGVISITOR
+{
+public:
+    virtual ~SGVISITOR()
+    {
+        return;
+    }
+
+    /**
+     * Function Pre
+     * is invoked before the nodes beneath aVisit.node are visited
+     */
+    virtual SGVISIT_ACTION Pre( const SGVISIT& aVisit )
+    {
+        return SGVISIT_CONTINUE;
+    }
+
+    /**
+     * Function Post
+     * is invoked once the nodes beneath aVisit.node have been visited;
+     * it is not invoked if Pre() did not return SGVISIT_CONTINUE.
+     */
+    virtual void Post( const SGVISIT& aVisit )
+    {
+        return;
+    }
+};
+
+
+namespace S3D
+{
+    /**
+     * Function Walk
+     * visits aNode and the nodes beneath it in depth first order. The nodes
+     * beneath a node are visited in the order in which they are named and
+     * written: owned nodes first, then referenced nodes. Node types are
+     * dispatched within the traversal rather than via virtual functions
+     * of the nodes.
+     *
+     * @param aNode is the node at which to start
+     * @param aVisitor is the operation to apply to each node
+     * @param aFlags is a combination of SGWALK_FLAGS
+     * @param aTransform is an optional transform to apply to aNode
+     * @return false if the visitor ended the traversal
+     */
+    bool Walk( SGNODE* aNode, SGVISITOR& aVisitor, int aFlags,
+               const glm::dmat4* aTransform = NULL );
+};
+
+#endif  // SG_VISITOR_H